@@ -0,0 +1,186 @@
+/**
+ * \file
+ *
+ * \brief Benchmark of drawing the game screens from sprites against working them out
+ *
+ * Draws the screens monty_ui_draw() draws into a framebuffer, without
+ * flushing, once working every door out column by column and writing the
+ * text glyph by glyph, and once from the door and text sprites of
+ * monty_display_sprites. The door screens use the three and seven door
+ * layouts with random doors open and the cursor on a random door, the result
+ * screens random percentages. Both ways have to draw the same pixels.
+ *
+ * Usage: bench_display [-n screens]
+ *
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "prng.h"
+#include "monty_display.h"
+
+/** \brief screens kept in memory and cycled through */
+#define BENCH_SCREENS 64
+
+/** \brief doors of the layouts drawn */
+static const uint32_t g_door_counts[] = { 3, 7 };
+
+/** \brief one screen to draw */
+typedef struct
+{
+	uint32_t layout;             /**< Index into g_door_counts */
+	uint32_t result;             /**< Non-zero for a result screen */
+	monty_door_set open_doors;
+	uint32_t cursor_door;
+	char rows[MONTY_DISPLAY_PAGES][32];
+} bench_screen;
+
+static bench_screen g_screens[BENCH_SCREENS];
+static door_coordinates g_doors[2][MONTY_NK_MAX_DOORS];
+static monty_display_sprites g_sprites[2];
+
+/** \brief same strings as the game caches */
+static const char *g_texts[] = {
+	"Select a door", "Winner", "Loser", "Game win %   ", "Switch win % ", "Stay win %   "
+};
+
+/** \brief result of one way of drawing */
+typedef struct
+{
+	uint64_t ns;
+	uint32_t hash;
+} bench_result;
+
+static uint64_t bench_ns( void )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/** \brief draws one screen like monty_ui_draw() */
+static void bench_draw( monty_framebuffer *p_fb, const bench_screen *p_screen, const monty_display_sprites *p_sprites )
+{
+	monty_framebuffer_clear( p_fb );
+	monty_display_text( p_fb, p_sprites, 0, p_screen->rows[0] );
+	if( !p_screen->result )
+	{
+		monty_display_draw_doors( p_fb, p_sprites, g_doors[p_screen->layout], g_door_counts[p_screen->layout],
+								p_screen->open_doors, p_screen->cursor_door );
+	}
+	else
+	{
+		for( uint8_t row = 1; row < MONTY_DISPLAY_PAGES; ++row )
+		{
+			monty_display_text( p_fb, p_sprites, row, p_screen->rows[row] );
+		}
+	}
+}
+
+/** \brief draws the screens, from sprites or not, and hashes every framebuffer */
+static void bench_screens( uint32_t screens, uint32_t sprites, bench_result *p_result )
+{
+	monty_framebuffer fb;
+	uint32_t hash = 0x811C9DC5u;
+
+	monty_framebuffer_init( &fb );
+	uint64_t start = bench_ns();
+	for( uint32_t screen = 0; screen < screens; ++screen )
+	{
+		const bench_screen *p_screen = &g_screens[screen % BENCH_SCREENS];
+		bench_draw( &fb, p_screen, sprites ? &g_sprites[p_screen->layout] : NULL );
+		hash = (hash ^ fb.pixels[2][screen % MONTY_DISPLAY_COLUMNS]) * 0x01000193u;
+	}
+	p_result->ns = bench_ns() - start;
+
+	// Every byte of the last screens as well
+	for( uint32_t screen = 0; screen < BENCH_SCREENS; ++screen )
+	{
+		const bench_screen *p_screen = &g_screens[screen];
+		bench_draw( &fb, p_screen, sprites ? &g_sprites[p_screen->layout] : NULL );
+		for( uint32_t i = 0; i < sizeof(fb.pixels); ++i )
+		{
+			hash = (hash ^ (&fb.pixels[0][0])[i]) * 0x01000193u;
+		}
+	}
+	p_result->hash = hash;
+}
+
+int main( int argc, char **argv )
+{
+	uint32_t screens = 1000000;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "n:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'n':
+				screens = (uint32_t)strtoul( optarg, NULL, 0 );
+				break;
+			default:
+				fprintf( stderr, "usage: %s [-n screens]\n", argv[0] );
+				return 1;
+		}
+	}
+	if( screens == 0 )
+	{
+		fprintf( stderr, "-n has to be at least 1\n" );
+		return 1;
+	}
+
+	for( uint32_t layout = 0; layout < 2; ++layout )
+	{
+		monty_nk_layout( g_door_counts[layout], MONTY_DISPLAY_COLUMNS, g_doors[layout] );
+		monty_display_sprites_init( &g_sprites[layout], &g_doors[layout][0] );
+		for( uint32_t i = 0; i < sizeof(g_texts) / sizeof(g_texts[0]); ++i )
+		{
+			monty_sprite_font_add( &g_sprites[layout].font, g_texts[i] );
+		}
+	}
+
+	prng_stream stream;
+	prng_init( &stream, 25, 0 );
+	for( uint32_t screen = 0; screen < BENCH_SCREENS; ++screen )
+	{
+		bench_screen *p_screen = &g_screens[screen];
+		uint32_t doors;
+		p_screen->layout = prng_next_u32( &stream ) & 1;
+		p_screen->result = (prng_next_u32( &stream ) % 3) == 0;
+		doors = g_door_counts[p_screen->layout];
+		p_screen->open_doors = prng_next_u32( &stream ) & (((monty_door_set)1 << doors) - 1);
+		p_screen->cursor_door = 1 + prng_next_u32( &stream ) % doors;
+		if( p_screen->result )
+		{
+			sprintf( p_screen->rows[0], (prng_next_u32( &stream ) & 1) ? "Winner" : "Loser" );
+			sprintf( p_screen->rows[1], "Game win %%   %" PRIu32, prng_next_u32( &stream ) % 101 );
+			sprintf( p_screen->rows[2], "Switch win %% %" PRIu32, prng_next_u32( &stream ) % 101 );
+			sprintf( p_screen->rows[3], "Stay win %%   %" PRIu32, prng_next_u32( &stream ) % 101 );
+		}
+		else
+		{
+			sprintf( p_screen->rows[0], "Select a door (last %" PRIu32 ")", 1 + prng_next_u32( &stream ) % doors );
+		}
+	}
+
+	bench_result computed, blitted;
+	bench_screens( screens, 0, &computed );
+	bench_screens( screens, 1, &blitted );
+
+	printf( "%" PRIu32 " screens (ns per screen, framebuffer hash)\n", screens );
+	printf( "  %-22s %10.1f  %08" PRIx32 "\n", "worked out", (double)computed.ns / screens, computed.hash );
+	printf( "  %-22s %10.1f  %08" PRIx32 "\n", "sprites", (double)blitted.ns / screens, blitted.hash );
+	printf( "speed up: %.1fx\n", (double)computed.ns / (double)blitted.ns );
+
+	if( computed.hash != blitted.hash )
+	{
+		printf( "FAILED: the sprites drew different pixels\n" );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,178 @@
+/**
+ * \file
+ *
+ * \brief Benchmark of handle_current_game_update_table() against the switch
+ *
+ * First checks the transition table against handle_current_game_update()
+ * for every state, prize door, first door, open door, press and random draw,
+ * valid or not, then plays the same random presses through both and reports
+ * TSC cycles per press.
+ *
+ * Usage: bench_game_update [-n presses]
+ *
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#include "monty_game_table.h"
+#include "prng.h"
+
+/** \brief number of pre-generated inputs, cycled through during the timing */
+#define BENCH_INPUTS 4096
+
+/** \brief random values served to the game core */
+static uint32_t g_draws[BENCH_INPUTS];
+static uint32_t g_next_draw;
+
+/** \brief host random source for the game core */
+uint32_t monty_hall_rand( void )
+{
+	return g_draws[g_next_draw++ & (BENCH_INPUTS - 1)];
+}
+
+static int bench_same_state( const monty_hall_state *p_a, const monty_hall_state *p_b )
+{
+	return (p_a->state == p_b->state) && (p_a->first_door == p_b->first_door) &&
+		   (p_a->open_door == p_b->open_door) && (p_a->winning_door == p_b->winning_door) &&
+		   (memcmp( &p_a->stats, &p_b->stats, sizeof(p_a->stats) ) == 0);
+}
+
+/** \brief compares the table against the reference for all inputs
+ *
+ * \returns number of mismatches
+ */
+static uint32_t bench_check_table( uint32_t *p_cases )
+{
+	// One draw for every prize door, each with both coins
+	static const uint32_t draws[6][2] = {
+		{ 0x00000000u, 0 }, { 0x00000000u, 1 }, { 0x60000000u, 0 },
+		{ 0x60000000u, 1 }, { 0xFFFFFFFFu, 0 }, { 0xFFFFFFFFu, 1 }
+	};
+	uint32_t errors = 0;
+
+	*p_cases = 0;
+	for( uint32_t state = 0; state <= MONTY_HALL_STATES; ++state )
+	{
+		for( uint32_t winning_door = 0; winning_door <= DOOR_NOT_PRESSED; ++winning_door )
+		{
+			for( uint32_t first_door = 0; first_door <= DOOR_NOT_PRESSED; ++first_door )
+			{
+				for( uint32_t open_door = 0; open_door <= DOOR_NOT_PRESSED; ++open_door )
+				{
+					for( uint32_t press = 0; press <= DOOR_NOT_PRESSED; ++press )
+					{
+						for( uint32_t draw = 0; draw < 6; ++draw )
+						{
+							monty_hall_state table = {
+								{ 10, 5, 3, 4 }, (MONTY_HALL_STATE)state, first_door, open_door, winning_door
+							};
+							monty_hall_state reference = table;
+
+							g_draws[0] = draws[draw][0];
+							g_draws[1] = draws[draw][1];
+							g_next_draw = 0;
+							int32_t reference_result = handle_current_game_update( &reference, press );
+							uint32_t reference_draws = g_next_draw;
+							g_next_draw = 0;
+							int32_t table_result = handle_current_game_update_table( &table, press );
+
+							if( (reference_result != table_result) || (reference_draws != g_next_draw) ||
+								!bench_same_state( &reference, &table ) )
+							{
+								printf( "mismatch: state %" PRIu32 " winning %" PRIu32 " first %" PRIu32
+										" open %" PRIu32 " press %" PRIu32 " draw %" PRIu32 "\n",
+										state, winning_door, first_door, open_door, press, draw );
+								errors++;
+							}
+							(*p_cases)++;
+						}
+					}
+				}
+			}
+		}
+	}
+	return errors;
+}
+
+/** \brief serialising time stamp */
+static inline uint64_t bench_tsc( void )
+{
+	_mm_lfence();
+	uint64_t tsc = __rdtsc();
+	_mm_lfence();
+	return tsc;
+}
+
+int main( int argc, char **argv )
+{
+	uint64_t presses = 50000000;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "n:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'n':
+				presses = strtoull( optarg, NULL, 0 );
+				break;
+			default:
+				fprintf( stderr, "usage: %s [-n presses]\n", argv[0] );
+				return 1;
+		}
+	}
+
+	uint32_t cases;
+	uint32_t errors = bench_check_table( &cases );
+	printf( "table check: " );
+	if( errors )
+	{
+		printf( "FAILED\n" );
+		return 1;
+	}
+	printf( "matches handle_current_game_update() for all %" PRIu32 " inputs\n", cases );
+
+	// Random presses on doors 1..3, some of them on the door Monty opened
+	static uint8_t press[BENCH_INPUTS];
+	prng_stream stream;
+	prng_init( &stream, 5, 0 );
+	for( uint32_t i = 0; i < BENCH_INPUTS; ++i )
+	{
+		press[i] = (uint8_t)monty_hall_random_door( prng_next_u32( &stream ) );
+		g_draws[i] = prng_next_u32( &stream );
+	}
+
+	monty_hall_state reference, table;
+	int32_t sink = 0;
+	uint64_t start, reference_cycles, table_cycles;
+
+	memset( &reference, 0, sizeof(reference) );
+	g_next_draw = 0;
+	start = bench_tsc();
+	for( uint64_t i = 0; i < presses; ++i )
+	{
+		sink += handle_current_game_update( &reference, press[i & (BENCH_INPUTS - 1)] );
+	}
+	reference_cycles = bench_tsc() - start;
+
+	memset( &table, 0, sizeof(table) );
+	g_next_draw = 0;
+	start = bench_tsc();
+	for( uint64_t i = 0; i < presses; ++i )
+	{
+		sink += handle_current_game_update_table( &table, press[i & (BENCH_INPUTS - 1)] );
+	}
+	table_cycles = bench_tsc() - start;
+
+	printf( "%" PRIu64 " random presses, %" PRIu64 " games (TSC cycles per press)\n", presses,
+			table.stats.number_of_games );
+	printf( "  handle_current_game_update()       %6.2f\n", (double)reference_cycles / (double)presses );
+	printf( "  handle_current_game_update_table() %6.2f\n", (double)table_cycles / (double)presses );
+	printf( "(checksum %" PRId32 ", counters %s)\n", sink,
+			bench_same_state( &reference, &table ) ? "match" : "DIFFER" );
+	return bench_same_state( &reference, &table ) ? 0 : 1;
+}
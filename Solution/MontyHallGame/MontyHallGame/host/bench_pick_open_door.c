@@ -0,0 +1,145 @@
+/**
+ * \file
+ *
+ * \brief Benchmark of the table driven pick_open_door() against the original
+ *
+ * First checks the table against pick_open_door_reference() for every prize
+ * door, first door and coin toss, then times both on random (unpredictable)
+ * inputs and reports TSC cycles per call.
+ *
+ * Usage: bench_pick_open_door [-n calls]
+ *
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#include "monty_hall.h"
+#include "prng.h"
+
+/** \brief number of pre-generated inputs, cycled through during the timing */
+#define BENCH_INPUTS 4096
+
+/** \brief random values served to the game core */
+static uint32_t g_draws[BENCH_INPUTS];
+static uint32_t g_next_draw;
+
+/** \brief host random source for the game core */
+uint32_t monty_hall_rand( void )
+{
+	return g_draws[g_next_draw++ & (BENCH_INPUTS - 1)];
+}
+
+/** \brief compares the table against the reference for all inputs
+ *
+ * \returns number of mismatches
+ */
+static uint32_t bench_check_table( void )
+{
+	uint32_t errors = 0;
+	for( uint32_t winning_door = DOOR_PRESSED_MIN; winning_door <= DOOR_PRESSED_MAX; ++winning_door )
+	{
+		for( uint32_t first_door = DOOR_PRESSED_MIN; first_door <= DOOR_PRESSED_MAX; ++first_door )
+		{
+			for( uint32_t coin = 0; coin < 2; ++coin )
+			{
+				g_draws[0] = coin;
+				g_next_draw = 0;
+				uint32_t reference = pick_open_door_reference( winning_door, first_door );
+				g_next_draw = 0;
+				uint32_t table = pick_open_door( winning_door, first_door );
+				uint32_t direct = pick_open_door_coin( winning_door, first_door, coin );
+
+				if( (reference != table) || (reference != direct) )
+				{
+					printf( "mismatch: winning %" PRIu32 " first %" PRIu32 " coin %" PRIu32
+							": reference %" PRIu32 ", table %" PRIu32 ", lookup %" PRIu32 "\n",
+							winning_door, first_door, coin, reference, table, direct );
+					errors++;
+				}
+			}
+		}
+	}
+	return errors;
+}
+
+/** \brief serialising time stamp */
+static inline uint64_t bench_tsc( void )
+{
+	_mm_lfence();
+	uint64_t tsc = __rdtsc();
+	_mm_lfence();
+	return tsc;
+}
+
+int main( int argc, char **argv )
+{
+	uint64_t calls = 50000000;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "n:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'n':
+				calls = strtoull( optarg, NULL, 0 );
+				break;
+			default:
+				fprintf( stderr, "usage: %s [-n calls]\n", argv[0] );
+				return 1;
+		}
+	}
+
+	uint32_t errors = bench_check_table();
+	printf( "table check: %s\n", errors ? "FAILED" : "matches pick_open_door_reference() for all 18 inputs" );
+	if( errors )
+	{
+		return 1;
+	}
+
+	static uint8_t winning[BENCH_INPUTS];
+	static uint8_t first[BENCH_INPUTS];
+	prng_stream stream;
+	prng_init( &stream, 4, 0 );
+	for( uint32_t i = 0; i < BENCH_INPUTS; ++i )
+	{
+		winning[i] = (uint8_t)monty_hall_random_door( prng_next_u32( &stream ) );
+		first[i] = (uint8_t)monty_hall_random_door( prng_next_u32( &stream ) );
+		g_draws[i] = prng_next_u32( &stream );
+	}
+
+	uint32_t sink = 0;
+	uint64_t start, reference_cycles, table_cycles, lookup_cycles;
+
+	start = bench_tsc();
+	for( uint64_t i = 0; i < calls; ++i )
+	{
+		sink += pick_open_door_reference( winning[i & (BENCH_INPUTS - 1)], first[i & (BENCH_INPUTS - 1)] );
+	}
+	reference_cycles = bench_tsc() - start;
+
+	start = bench_tsc();
+	for( uint64_t i = 0; i < calls; ++i )
+	{
+		sink += pick_open_door( winning[i & (BENCH_INPUTS - 1)], first[i & (BENCH_INPUTS - 1)] );
+	}
+	table_cycles = bench_tsc() - start;
+
+	start = bench_tsc();
+	for( uint64_t i = 0; i < calls; ++i )
+	{
+		sink += pick_open_door_coin( winning[i & (BENCH_INPUTS - 1)], first[i & (BENCH_INPUTS - 1)],
+									g_draws[i & (BENCH_INPUTS - 1)] );
+	}
+	lookup_cycles = bench_tsc() - start;
+
+	printf( "%" PRIu64 " calls on random inputs (TSC cycles per call)\n", calls );
+	printf( "  pick_open_door_reference() %6.2f\n", (double)reference_cycles / (double)calls );
+	printf( "  pick_open_door()           %6.2f\n", (double)table_cycles / (double)calls );
+	printf( "  pick_open_door_coin()      %6.2f\n", (double)lookup_cycles / (double)calls );
+	printf( "(checksum %" PRIu32 ")\n", sink );
+	return 0;
+}
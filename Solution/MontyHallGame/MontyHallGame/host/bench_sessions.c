@@ -0,0 +1,171 @@
+/**
+ * \file
+ *
+ * \brief Benchmark of the packed session table against an array of game states
+ *
+ * Plays rounds of random button presses (a door or no press for every
+ * session) on a monty_session_table with monty_session_update() and on a plain
+ * array of monty_hall_state with handle_current_game_update(), both drawing
+ * from the same random stream. Fails unless every session ends with the same
+ * state and counters in both, then reports TSC cycles per session and round
+ * and the bytes of game state each one walks.
+ *
+ * Usage: bench_sessions [-n sessions] [-r rounds] [-S seed]
+ *
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#include "host_rand.h"
+#include "monty_session.h"
+
+/** \brief serialising time stamp */
+static inline uint64_t bench_tsc( void )
+{
+	_mm_lfence();
+	uint64_t tsc = __rdtsc();
+	_mm_lfence();
+	return tsc;
+}
+
+/** \brief compares every session of the table against the array
+ *
+ * \returns number of sessions that differ
+ */
+static uint32_t bench_compare( const monty_session_table *p_table, const monty_hall_state *p_states, uint32_t sessions )
+{
+	uint32_t errors = 0;
+	for( uint32_t session = 0; session < sessions; ++session )
+	{
+		monty_hall_state packed;
+		const monty_hall_state *p_state = &p_states[session];
+		monty_session_get( p_table, session, &packed );
+
+		if( (packed.state != p_state->state) || (packed.first_door != p_state->first_door) ||
+			(packed.open_door != p_state->open_door) || (packed.winning_door != p_state->winning_door) ||
+			(memcmp( &packed.stats, &p_state->stats, sizeof(packed.stats) ) != 0) )
+		{
+			if( errors++ < 4 )
+			{
+				printf( "session %" PRIu32 " differs: state %u/%u, games %" PRIu64 "/%" PRIu64 "\n", session,
+						packed.state, p_state->state, packed.stats.number_of_games, p_state->stats.number_of_games );
+			}
+		}
+	}
+	return errors;
+}
+
+int main( int argc, char **argv )
+{
+	uint32_t sessions = 65536;
+	uint32_t rounds = 64;
+	uint64_t seed = 11;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "n:r:S:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'n':
+				sessions = (uint32_t)strtoul( optarg, NULL, 0 );
+				break;
+			case 'r':
+				rounds = (uint32_t)strtoul( optarg, NULL, 0 );
+				break;
+			case 'S':
+				seed = strtoull( optarg, NULL, 0 );
+				break;
+			default:
+				fprintf( stderr, "usage: %s [-n sessions] [-r rounds] [-S seed]\n", argv[0] );
+				return 1;
+		}
+	}
+	if( sessions == 0 )
+	{
+		fprintf( stderr, "need at least one session\n" );
+		return 1;
+	}
+
+	uint32_t groups = MONTY_SESSION_GROUPS(sessions);
+	monty_session_group *p_groups = malloc( groups * sizeof(*p_groups) );
+	monty_stats *p_stats = malloc( sessions * sizeof(*p_stats) );
+	monty_hall_state *p_states = malloc( sessions * sizeof(*p_states) );
+	uint64_t *p_presses = malloc( groups * sizeof(*p_presses) );
+	uint8_t *p_doors = malloc( sessions );
+	if( (p_groups == NULL) || (p_stats == NULL) || (p_states == NULL) || (p_presses == NULL) || (p_doors == NULL) )
+	{
+		fprintf( stderr, "out of memory\n" );
+		return 1;
+	}
+
+	monty_session_table table;
+	monty_session_init( &table, p_groups, p_stats, sessions );
+	for( uint32_t session = 0; session < sessions; ++session )
+	{
+		p_states[session] = (monty_hall_state){ { 0, 0, 0, 0 }, MONTY_GAME_STARTED,
+												DOOR_NOT_PRESSED, DOOR_NOT_PRESSED, DOOR_NOT_PRESSED };
+	}
+
+	// Presses come from stream 1, the game draws of both layouts from stream 0
+	prng_stream press_stream, array_stream, table_stream;
+	prng_init( &press_stream, seed, 1 );
+	prng_init( &array_stream, seed, 0 );
+	prng_init( &table_stream, seed, 0 );
+
+	uint64_t array_cycles = 0;
+	uint64_t table_cycles = 0;
+	uint64_t finished = 0;
+	for( uint32_t round = 0; round < rounds; ++round )
+	{
+		memset( p_presses, 0, groups * sizeof(*p_presses) );
+		for( uint32_t session = 0; session < sessions; ++session )
+		{
+			// Two random bits: no press a quarter of the time, otherwise a door
+			p_doors[session] = (uint8_t)(prng_next_u32( &press_stream ) & 0x3);
+			monty_session_set_press( p_presses, session, p_doors[session] );
+		}
+
+		host_rand_set_stream( &array_stream );
+		uint64_t start = bench_tsc();
+		for( uint32_t session = 0; session < sessions; ++session )
+		{
+			if( p_doors[session] != 0 )
+			{
+				handle_current_game_update( &p_states[session], p_doors[session] );
+			}
+		}
+		array_cycles += bench_tsc() - start;
+
+		host_rand_set_stream( &table_stream );
+		start = bench_tsc();
+		finished += monty_session_update( &table, p_presses );
+		table_cycles += bench_tsc() - start;
+	}
+	host_rand_set_stream( NULL );
+
+	uint32_t errors = bench_compare( &table, p_states, sessions );
+	printf( "%" PRIu32 " sessions, %" PRIu32 " rounds, %" PRIu64 " games finished: %s\n", sessions, rounds, finished,
+			errors ? "MISMATCH" : "table matches handle_current_game_update()" );
+	if( errors )
+	{
+		return 1;
+	}
+
+	double updates = (double)sessions * rounds;
+	printf( "TSC cycles per session and round (hot state bytes per session)\n" );
+	printf( "  monty_hall_state array   %6.2f (%zu)\n", (double)array_cycles / updates, sizeof(monty_hall_state) );
+	printf( "  monty_session_update()   %6.2f (%zu)\n", (double)table_cycles / updates,
+			sizeof(monty_session_group) / MONTY_SESSION_LANES );
+
+	free( p_doors );
+	free( p_presses );
+	free( p_states );
+	free( p_stats );
+	free( p_groups );
+	return 0;
+}
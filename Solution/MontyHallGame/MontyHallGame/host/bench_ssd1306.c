@@ -0,0 +1,216 @@
+/**
+ * \file
+ *
+ * \brief Benchmark of burst SSD1306 data writes against one byte per transfer
+ *
+ * Writes the same random frames through the ASF driver to the host model of
+ * the controller (ssd1306_mock.h), once a byte at a time through ssd1306_write_data(), once a page
+ * at a time through ssd1306_write_data_buffer() and once the whole frame as a
+ * single window through ssd1306_blit(), then the same text a byte at a time
+ * and through ssd1306_write_text(). All ways have to leave the same display
+ * RAM. For each it prints the
+ * bytes/s on the host and the bytes/s on the board's bus as modelled by the
+ * controller model (SPI clock and the ASF driver's latency per transfer).
+ *
+ * Usage: bench_ssd1306 [-n frames]
+ *
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "prng.h"
+#include "ssd1306.h"
+#include "font.h"
+
+/** \brief pages of the 128x32 panel */
+#define BENCH_PAGES 4
+
+/** \brief frames kept in memory and cycled through */
+#define BENCH_FRAMES 64
+
+/** \brief text drawn per frame in the text test */
+static const char *g_text[BENCH_PAGES] = {
+	"Select a door (last 2)", "Game win %   67", "Switch win % 66", "Stay win %   33"
+};
+
+static uint8_t g_frames[BENCH_FRAMES][BENCH_PAGES][SSD1306_MOCK_COLUMNS];
+
+/** \brief result of one way of writing */
+typedef struct
+{
+	uint64_t bytes;
+	uint64_t ns;
+	uint64_t bus_ns;
+	uint64_t transfers;
+	uint32_t hash;
+} bench_result;
+
+static uint64_t bench_ns( void )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/** \brief ways of writing a frame */
+enum
+{
+	BENCH_BYTES,        /**< A byte per transfer */
+	BENCH_PAGE_BURSTS,  /**< A page address and a burst per page */
+	BENCH_FRAME_BLIT    /**< One window and one burst per frame */
+};
+
+/** \brief writes the frames one of the BENCH_* ways */
+static void bench_frames( uint32_t frames, uint32_t way, bench_result *p_result )
+{
+	ssd1306_mock_reset();
+	uint64_t start = bench_ns();
+	for( uint32_t frame = 0; frame < frames; ++frame )
+	{
+		if( way == BENCH_FRAME_BLIT )
+		{
+			ssd1306_blit( 0, 0, SSD1306_MOCK_COLUMNS, BENCH_PAGES, g_frames[frame % BENCH_FRAMES][0] );
+			continue;
+		}
+		for( uint8_t page = 0; page < BENCH_PAGES; ++page )
+		{
+			const uint8_t *p_row = g_frames[frame % BENCH_FRAMES][page];
+			ssd1306_set_page_address( page );
+			ssd1306_set_column_address( 0 );
+			if( way == BENCH_PAGE_BURSTS )
+			{
+				ssd1306_write_data_buffer( p_row, SSD1306_MOCK_COLUMNS );
+			}
+			else
+			{
+				for( uint32_t column = 0; column < SSD1306_MOCK_COLUMNS; ++column )
+				{
+					ssd1306_write_data( p_row[column] );
+				}
+			}
+		}
+	}
+	p_result->ns = bench_ns() - start;
+	p_result->bytes = g_ssd1306_mock.data;
+	p_result->bus_ns = g_ssd1306_mock.bus_ns;
+	p_result->transfers = g_ssd1306_mock.transfers;
+	p_result->hash = ssd1306_mock_hash();
+}
+
+/** \brief ssd1306_write_text() as it was, one transfer per font column */
+static void bench_write_text_bytes( const char *p_text )
+{
+	for( ; *p_text != 0; ++p_text )
+	{
+		uint8_t *p_glyph = font_table[*p_text - 32];
+		for( uint8_t i = 1; i <= p_glyph[0]; i++ )
+		{
+			ssd1306_write_data( p_glyph[i] );
+		}
+		ssd1306_write_data( 0x00 );
+	}
+}
+
+/** \brief writes the text rows, a byte per transfer or through ssd1306_write_text() */
+static void bench_text( uint32_t frames, uint32_t burst, bench_result *p_result )
+{
+	ssd1306_mock_reset();
+	uint64_t start = bench_ns();
+	for( uint32_t frame = 0; frame < frames; ++frame )
+	{
+		for( uint8_t page = 0; page < BENCH_PAGES; ++page )
+		{
+			ssd1306_set_page_address( page );
+			ssd1306_set_column_address( 0 );
+			if( burst )
+			{
+				ssd1306_write_text( g_text[page] );
+			}
+			else
+			{
+				bench_write_text_bytes( g_text[page] );
+			}
+		}
+	}
+	p_result->ns = bench_ns() - start;
+	p_result->bytes = g_ssd1306_mock.data;
+	p_result->bus_ns = g_ssd1306_mock.bus_ns;
+	p_result->transfers = g_ssd1306_mock.transfers;
+	p_result->hash = ssd1306_mock_hash();
+}
+
+static void bench_report( const char *p_name, const bench_result *p_result )
+{
+	printf( "  %-34s %12.0f %12.0f %10.2f  %08" PRIx32 "\n", p_name,
+			(double)p_result->bytes * 1e9 / (double)p_result->ns,
+			(double)p_result->bytes * 1e9 / (double)p_result->bus_ns,
+			(double)p_result->transfers / (double)p_result->bytes, p_result->hash );
+}
+
+int main( int argc, char **argv )
+{
+	uint32_t frames = 20000;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "n:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'n':
+				frames = (uint32_t)strtoul( optarg, NULL, 0 );
+				break;
+			default:
+				fprintf( stderr, "usage: %s [-n frames]\n", argv[0] );
+				return 1;
+		}
+	}
+	if( frames == 0 )
+	{
+		fprintf( stderr, "-n has to be at least 1\n" );
+		return 1;
+	}
+
+	prng_stream stream;
+	prng_init( &stream, 9, 0 );
+	for( uint32_t frame = 0; frame < BENCH_FRAMES; ++frame )
+	{
+		for( uint32_t page = 0; page < BENCH_PAGES; ++page )
+		{
+			for( uint32_t column = 0; column < SSD1306_MOCK_COLUMNS; ++column )
+			{
+				g_frames[frame][page][column] = (uint8_t)prng_next_u32( &stream );
+			}
+		}
+	}
+
+	bench_result byte_frames, burst_frames, blit_frames, byte_text, burst_text;
+	bench_frames( frames, BENCH_BYTES, &byte_frames );
+	bench_frames( frames, BENCH_PAGE_BURSTS, &burst_frames );
+	bench_frames( frames, BENCH_FRAME_BLIT, &blit_frames );
+	bench_text( frames, 0, &byte_text );
+	bench_text( frames, 1, &burst_text );
+
+	printf( "%" PRIu32 " frames of %u pages (bytes/s, transfers per byte, display hash)\n", frames, BENCH_PAGES );
+	printf( "  %-34s %12s %12s %10s\n", "", "host", "board bus", "transfers" );
+	bench_report( "frames, ssd1306_write_data", &byte_frames );
+	bench_report( "frames, ssd1306_write_data_buffer", &burst_frames );
+	bench_report( "frames, ssd1306_blit", &blit_frames );
+	bench_report( "text, byte per transfer", &byte_text );
+	bench_report( "text, ssd1306_write_text", &burst_text );
+	printf( "board bus speed up: frames %.1fx (%.1fx as one blit), text %.1fx\n",
+			(double)byte_frames.bus_ns / (double)burst_frames.bus_ns,
+			(double)byte_frames.bus_ns / (double)blit_frames.bus_ns,
+			(double)byte_text.bus_ns / (double)burst_text.bus_ns );
+
+	if( (byte_frames.hash != burst_frames.hash) || (byte_frames.hash != blit_frames.hash) ||
+		(byte_text.hash != burst_text.hash) )
+	{
+		printf( "FAILED: the burst writes left a different display\n" );
+		return 1;
+	}
+	return 0;
+}
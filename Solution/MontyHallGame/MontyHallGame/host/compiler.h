@@ -0,0 +1,15 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for the ASF compiler.h, enough to build the OLED font
+ *
+ */
+
+#ifndef COMPILER_H_INCLUDED
+#define COMPILER_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#endif /* COMPILER_H_INCLUDED */
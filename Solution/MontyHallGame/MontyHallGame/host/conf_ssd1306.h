@@ -0,0 +1,22 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for conf_ssd1306.h, the OLED on the SPI of the controller model
+ *
+ */
+
+#ifndef CONF_SSD1306_H_INCLUDED
+#define CONF_SSD1306_H_INCLUDED
+
+#include "ssd1306_mock.h"
+
+#define SSD1306_SPI_INTERFACE
+#define SSD1306_SPI          ssd1306_mock_spi()
+
+#define SSD1306_DC_PIN       SSD1306_MOCK_DC_PIN
+#define SSD1306_RES_PIN      SSD1306_MOCK_RES_PIN
+#define SSD1306_CS_PIN       SSD1306_MOCK_CS_PIN
+
+#define SSD1306_CLOCK_SPEED  SSD1306_MOCK_CLOCK_HZ
+
+#endif /* CONF_SSD1306_H_INCLUDED */
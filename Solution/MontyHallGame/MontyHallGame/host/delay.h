@@ -0,0 +1,13 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for the ASF delay.h, delays add to the modelled bus time
+ *
+ */
+
+#ifndef DELAY_H_INCLUDED
+#define DELAY_H_INCLUDED
+
+#include "ssd1306_mock.h"
+
+#endif /* DELAY_H_INCLUDED */
@@ -0,0 +1,82 @@
+/**
+ * \file
+ *
+ * \brief Host random source for the game core
+ *
+ */
+
+#include <stddef.h>
+
+#include "host_rand.h"
+#include "monty_hall.h"
+
+/*
+ * Per-game draws of the three door game. handle_current_game_update() asks
+ * for the winning door first and pick_open_door() for its coin toss second.
+ */
+static __thread uint32_t t_draws[2];
+static __thread uint32_t t_next_draw;
+
+/** \brief caller supplied draws, 0 is served once they run out */
+static __thread const uint32_t *tp_sequence;
+static __thread uint32_t t_sequence_count;
+
+/** \brief stream to read from instead of the per-game draws */
+static __thread prng_stream *tp_stream;
+
+/** \brief host random source for the game core */
+uint32_t monty_hall_rand( void )
+{
+	if( tp_stream != NULL )
+	{
+		return prng_next_u32( tp_stream );
+	}
+	if( tp_sequence != NULL )
+	{
+		uint32_t index = t_next_draw++;
+		return (index < t_sequence_count) ? tp_sequence[index] : 0;
+	}
+	return t_draws[t_next_draw++ & 1];
+}
+
+/** \brief serves the draws of one three door game to the calling thread
+ *
+ * \param winning - raw value for the prize door
+ * \param coin - raw value for Monty's coin toss
+ */
+void host_rand_set_draws( uint32_t winning, uint32_t coin )
+{
+	tp_stream = NULL;
+	tp_sequence = NULL;
+	t_draws[0] = winning;
+	t_draws[1] = coin;
+	t_next_draw = 0;
+}
+
+/** \brief makes the calling thread draw sequentially from a stream
+ *
+ * \param p_stream - stream, owned by the caller, NULL to go back to per-game draws
+ */
+void host_rand_set_stream( prng_stream *p_stream )
+{
+	tp_stream = p_stream;
+}
+
+/** \brief serves a fixed sequence of draws to the calling thread
+ *
+ * \param p_draws - draws, owned by the caller
+ * \param count - number of draws
+ */
+void host_rand_set_sequence( const uint32_t *p_draws, uint32_t count )
+{
+	tp_stream = NULL;
+	tp_sequence = p_draws;
+	t_sequence_count = count;
+	t_next_draw = 0;
+}
+
+/** \brief draws taken since the last host_rand_set_sequence() or host_rand_set_draws() */
+uint32_t host_rand_used( void )
+{
+	return t_next_draw;
+}
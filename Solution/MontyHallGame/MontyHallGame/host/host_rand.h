@@ -0,0 +1,25 @@
+/**
+ * \file
+ *
+ * \brief Host random source for the game core
+ *
+ * The game core draws through monty_hall_rand(). On the host every worker
+ * thread either serves fixed per-game draws (the classic three door game, see
+ * monty_kernel.h), serves a caller supplied sequence of draws (the exact
+ * solver enumerating them) or reads sequentially from a prng_stream.
+ *
+ */
+
+#ifndef HOST_RAND_H_INCLUDED
+#define HOST_RAND_H_INCLUDED
+
+#include <stdint.h>
+
+#include "prng.h"
+
+void host_rand_set_draws( uint32_t winning, uint32_t coin );
+void host_rand_set_stream( prng_stream *p_stream );
+void host_rand_set_sequence( const uint32_t *p_draws, uint32_t count );
+uint32_t host_rand_used( void );
+
+#endif /* HOST_RAND_H_INCLUDED */
@@ -0,0 +1,13 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for the ASF ioport.h, the pins of the OLED on the controller model
+ *
+ */
+
+#ifndef IOPORT_H_INCLUDED
+#define IOPORT_H_INCLUDED
+
+#include "ssd1306_mock.h"
+
+#endif /* IOPORT_H_INCLUDED */
@@ -0,0 +1,70 @@
+/**
+ * \file
+ *
+ * \brief Plays ranges of blocks of the game stream on a pool of threads
+ *
+ */
+
+#include <stdio.h>
+
+#include "monty_batch.h"
+#include "monty_nk_sim.h"
+
+/** \brief worker thread, plays its range of blocks of the game stream */
+static void *batch_worker_main( void *p_arg )
+{
+	monty_batch_worker *p_worker = (monty_batch_worker *)p_arg;
+	monty_draw_block block;
+
+	for( uint64_t index = p_worker->first_block; index < p_worker->first_block + p_worker->block_count; ++index )
+	{
+		uint64_t first_game = index * MONTY_KERNEL_LANES;
+		uint64_t left = p_worker->games - first_game;
+		uint32_t games = (left < MONTY_KERNEL_LANES) ? (uint32_t)left : MONTY_KERNEL_LANES;
+
+		if( p_worker->p_rules != NULL )
+		{
+			monty_nk_sim_run( p_worker->p_rules, p_worker->seed, first_game, games, p_worker->strategy, &p_worker->totals );
+			continue;
+		}
+		monty_kernel_fill( &block, p_worker->p_stream, first_game );
+		monty_kernel_run( p_worker->kernel, &block, games, p_worker->strategy, &p_worker->totals );
+		if( p_worker->verify )
+		{
+			monty_kernel_run( MONTY_KERNEL_SCALAR, &block, games, p_worker->strategy, &p_worker->reference );
+		}
+	}
+	return NULL;
+}
+
+/** \brief plays a range of blocks on all workers and adds the results to the totals
+ *
+ * \returns 0 if everything is okay -1 when a worker could not be started
+ */
+int monty_batch_play( monty_batch_worker *p_workers, long threads, uint64_t first_block, uint64_t blocks,
+						monty_stats *p_totals, monty_stats *p_reference )
+{
+	uint64_t next_block = first_block;
+	for( long i = 0; i < threads; ++i )
+	{
+		// Spread the remainder over the first workers
+		p_workers[i].first_block = next_block;
+		p_workers[i].block_count = blocks / (uint64_t)threads + (((uint64_t)i < blocks % (uint64_t)threads) ? 1 : 0);
+		next_block += p_workers[i].block_count;
+		monty_stats_clear( &p_workers[i].totals );
+		monty_stats_clear( &p_workers[i].reference );
+		if( pthread_create( &p_workers[i].thread, NULL, batch_worker_main, &p_workers[i] ) != 0 )
+		{
+			fprintf( stderr, "failed to start worker %ld\n", i );
+			return -1;
+		}
+	}
+	for( long i = 0; i < threads; ++i )
+	{
+		pthread_join( p_workers[i].thread, NULL );
+		monty_stats_merge( p_totals, &p_workers[i].totals );
+		monty_stats_merge( p_reference, &p_workers[i].reference );
+	}
+	return 0;
+}
+
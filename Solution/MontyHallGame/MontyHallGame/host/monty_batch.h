@@ -0,0 +1,43 @@
+/**
+ * \file
+ *
+ * \brief Plays ranges of blocks of the game stream on a pool of threads
+ *
+ * A range is split into one contiguous run of blocks per thread. Every block
+ * draws from its own position of the counter based game stream, so the
+ * counters do not depend on how the blocks are split up, over threads here or
+ * over processes by monty_shard.
+ *
+ */
+
+#ifndef MONTY_BATCH_H_INCLUDED
+#define MONTY_BATCH_H_INCLUDED
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "monty_kernel.h"
+#include "monty_nk.h"
+#include "monty_sim.h"
+
+/** \brief per thread work item */
+typedef struct
+{
+	pthread_t thread;
+	uint64_t first_block;   /**< First block of the game stream this worker plays */
+	uint64_t block_count;   /**< Number of blocks this worker plays */
+	uint64_t games;         /**< Total games in the stream, the last block may be partial */
+	const prng_stream *p_stream; /**< Game stream, shared read only */
+	const monty_nk_rules *p_rules; /**< N door rules, NULL for the three door game */
+	uint64_t seed;          /**< Run seed */
+	SIM_STRATEGY strategy;
+	MONTY_KERNEL kernel;
+	int verify;             /**< Also run the scalar reference and compare */
+	monty_stats totals;      /**< Result, valid once the thread is joined */
+	monty_stats reference;   /**< Scalar reference result when verifying */
+} monty_batch_worker;
+
+int monty_batch_play( monty_batch_worker *p_workers, long threads, uint64_t first_block, uint64_t blocks,
+						monty_stats *p_totals, monty_stats *p_reference );
+
+#endif /* MONTY_BATCH_H_INCLUDED */
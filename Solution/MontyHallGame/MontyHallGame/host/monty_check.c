@@ -0,0 +1,296 @@
+/**
+ * \file
+ *
+ * \brief Exact win probabilities and a check of measured results against them
+ *
+ * Prints the exact win probability of every player strategy for the rules,
+ * from the closed form and from walking every path through the game code (see
+ * monty_exact.h), and fails if the two disagree.
+ *
+ * With -c it then reads a monty_sim, monty_shard or monty_replay report or a
+ * board UART log on stdin and checks the last "Games Played: ..." line in it:
+ * the switch and stay win rates must be consistent with the exact values. A
+ * rate deviates when the exact value lies outside its Wilson interval (-z,
+ * default 3.29 for 99.9%). The tools follow the line with the raw counters
+ * ("Won W, Switched Won S"), which give the win counts exactly. A board log
+ * only has the whole percentages of the line, so every win count that rounds
+ * to the printed percentage is accepted and the check is coarse: the window
+ * is at least 1% wide however many games were played. A "N doors, Monty
+ * opens K" line in the input (monty_sim prints one) overrides -d and -r.
+ *
+ * -b and -f check a three door game against a host who does not follow the
+ * textbook rules (see monty_variant.h): -b is the probability that he opens
+ * the lower numbered door when the player picked the prize, -f the
+ * probability that he opens a door blind. Games in which a blind host shows
+ * the prize are not played on, so the rates are taken over the other games.
+ * The exact values come from monty_variant_exact(), with the probabilities
+ * rounded to the 32 bit thresholds the simulators apply, and the measured
+ * rates get the same Wilson interval check.
+ *
+ * Usage: monty_check [-d doors] [-r reveals] [-b bias] [-f blind] [-p max_paths] [-c] [-z z]
+ *
+ *   monty_sim -n 1e8 -s random | monty_check -c
+ *
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "monty_exact.h"
+#include "monty_variant.h"
+
+/** \brief longest input line looked at */
+#define CHECK_LINE_LENGTH 512
+
+/** \brief win rate read from a statistics line */
+typedef struct
+{
+	uint64_t trials;
+	uint64_t won;      /**< Games won, valid when exact is set */
+	uint32_t percent;  /**< Whole percent, rounded down like monty_stats_percent() */
+	int exact;         /**< Win count known, not just the percentage */
+} check_rate;
+
+static const char *const g_strategy_names[3] = { "switch", "stay", "random" };
+
+/** \brief checks one measured rate against its exact value
+ *
+ * \param p_name - name of the rate
+ * \param p_rate - measured rate
+ * \param value - exact value
+ * \param p_exact - exact value as text, a fraction or the host
+ * \param z - width of the Wilson interval in standard errors
+ * \returns 0 when consistent, 1 when it deviates
+ */
+static int check_rate_against( const char *p_name, const check_rate *p_rate, double value, const char *p_exact,
+							   double z )
+{
+	if( p_rate->trials == 0 )
+	{
+		printf( "%-6s no games\n", p_name );
+		return 0;
+	}
+
+	// Smallest and largest win counts that print as this percentage
+	uint64_t lowest = p_rate->won;
+	uint64_t highest = p_rate->won;
+	if( !p_rate->exact )
+	{
+		lowest = (p_rate->trials * p_rate->percent + 99) / 100;
+		highest = (p_rate->trials * (p_rate->percent + 1) + 99) / 100 - 1;
+		highest = (highest > p_rate->trials) ? p_rate->trials : highest;
+	}
+
+	monty_interval low, high;
+	monty_stats_wilson( lowest, p_rate->trials, z, &low );
+	monty_stats_wilson( highest, p_rate->trials, z, &high );
+
+	int deviates = (value < low.lower) || (value > high.upper);
+	if( p_rate->exact )
+	{
+		printf( "%-6s %" PRIu64 " of %" PRIu64 " games = %.5f%%, allowed [%.5f%%, %.5f%%]", p_name,
+				p_rate->won, p_rate->trials, 100.0 * (double)p_rate->won / (double)p_rate->trials,
+				100.0 * low.lower, 100.0 * high.upper );
+	}
+	else
+	{
+		printf( "%-6s %" PRIu32 "%% of %" PRIu64 " games (whole percent only, coarse), allowed [%.4f%%, %.4f%%]", p_name,
+				p_rate->percent, p_rate->trials, 100.0 * low.lower, 100.0 * high.upper );
+	}
+	printf( ", exact %s = %.4f%%: %s\n", p_exact, 100.0 * value, deviates ? "DEVIATES" : "consistent" );
+	return deviates;
+}
+
+/** \brief checks one measured rate against an exact fraction */
+static int check_rate_against_rational( const char *p_name, const check_rate *p_rate, monty_rational exact, double z )
+{
+	char text[64];
+
+	snprintf( text, sizeof(text), "%" PRIu64 "/%" PRIu64, exact.num, exact.den );
+	return check_rate_against( p_name, p_rate, monty_rational_value( exact ), text, z );
+}
+
+/** \brief switch and stay win rates of a three door game against the host of a variant
+ *
+ * Over the games in which the host did not show the prize. The rates do not
+ * depend on how often the player switches, so each is worked out for the
+ * strategy that always plays it.
+ *
+ * \param p_variant - host, offers ignored: he always offers the switch
+ * \param p_switch - switch win rate
+ * \param p_stay - stay win rate
+ */
+static void check_variant_exact( const monty_variant *p_variant, double *p_switch, double *p_stay )
+{
+	monty_variant offered = { p_variant->lower_bias, p_variant->blind, 1.0, 1.0 };
+	monty_variant_exact_result exact;
+
+	monty_variant_exact( &offered, SIM_STRATEGY_SWITCH, &exact );
+	*p_switch = (exact.switched_won[0] + exact.switched_won[1]) / (exact.switched[0] + exact.switched[1]);
+	monty_variant_exact( &offered, SIM_STRATEGY_STAY, &exact );
+	*p_stay = (exact.won[0] + exact.won[1]) / (exact.opened[0] + exact.opened[1]);
+}
+
+int main( int argc, char **argv )
+{
+	monty_nk_rules rules = { 3, 1 };
+	monty_variant host = { 0.5, 0.0, 1.0, 1.0 };
+	int variant = 0;
+	uint64_t max_paths = 100000000;
+	double z = 3.290526731491926;
+	int check = 0;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "d:r:b:f:p:cz:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'd':
+				rules.door_count = (uint32_t)strtoul( optarg, NULL, 10 );
+				break;
+			case 'r':
+				rules.reveal_count = (uint32_t)strtoul( optarg, NULL, 10 );
+				break;
+			case 'b':
+				host.lower_bias = strtod( optarg, NULL );
+				variant = 1;
+				break;
+			case 'f':
+				host.blind = strtod( optarg, NULL );
+				variant = 1;
+				break;
+			case 'p':
+				max_paths = (uint64_t)strtod( optarg, NULL );
+				break;
+			case 'c':
+				check = 1;
+				break;
+			case 'z':
+				z = strtod( optarg, NULL );
+				break;
+			default:
+				fprintf( stderr, "usage: %s [-d doors] [-r reveals] [-b bias] [-f blind] [-p max_paths] [-c] [-z z]\n",
+						 argv[0] );
+				return 1;
+		}
+	}
+
+	check_rate switched = { 0, 0, 0, 0 };
+	check_rate stayed = { 0, 0, 0, 0 };
+	int have_line = 0;
+	if( check )
+	{
+		char line[CHECK_LINE_LENGTH];
+		while( fgets( line, sizeof(line), stdin ) != NULL )
+		{
+			uint64_t games, switches, won, switched_won;
+			uint32_t win_pct, switch_pct, stay_pct, doors, reveals;
+
+			const char *p_stats = strstr( line, "Games Played:" );
+
+			if( (p_stats != NULL) &&
+				(sscanf( p_stats, "Games Played: %" SCNu64 ", Switch Count %" SCNu64 ", Games Win %" SCNu32
+						"%%, Switch Win %" SCNu32 "%% Stay Win %" SCNu32 "%%",
+						&games, &switches, &win_pct, &switch_pct, &stay_pct ) == 5) )
+			{
+				switched = (check_rate){ switches, 0, switch_pct, 0 };
+				stayed = (check_rate){ games - switches, 0, stay_pct, 0 };
+				have_line = 1;
+			}
+			else if( have_line && !switched.exact &&
+					(sscanf( line, "Won %" SCNu64 ", Switched Won %" SCNu64, &won, &switched_won ) == 2) &&
+					(switched_won <= won) && (switched_won <= switched.trials) && (won - switched_won <= stayed.trials) )
+			{
+				// Raw counters following the statistics line
+				switched.won = switched_won;
+				switched.exact = 1;
+				stayed.won = won - switched_won;
+				stayed.exact = 1;
+			}
+			else if( sscanf( line, "%" SCNu32 " doors, Monty opens %" SCNu32, &doors, &reveals ) == 2 )
+			{
+				rules.door_count = doors;
+				rules.reveal_count = reveals;
+			}
+		}
+	}
+
+	monty_nk_state check_rules;
+	if( monty_nk_init( &check_rules, rules.door_count, rules.reveal_count ) != 0 )
+	{
+		fprintf( stderr, "invalid rules: %u doors, %u revealed\n", rules.door_count, rules.reveal_count );
+		return 1;
+	}
+	if( variant && ((rules.door_count != 3) || (rules.reveal_count != 1) || !(host.lower_bias >= 0.0) ||
+					!(host.lower_bias <= 1.0) || !(host.blind >= 0.0) || !(host.blind <= 1.0)) )
+	{
+		fprintf( stderr, "-b and -f need three doors, one revealed and probabilities between 0 and 1\n" );
+		return 1;
+	}
+
+	monty_exact_result closed, walked;
+	monty_exact_closed_form( &rules, &closed );
+	int walk = monty_exact_walk( &rules, max_paths, &walked );
+
+	printf( "%u doors, Monty opens %u\n", rules.door_count, rules.reveal_count );
+	if( walk == 0 )
+	{
+		printf( "walked %" PRIu64 " paths through the game code\n", walked.paths );
+	}
+	else
+	{
+		printf( "not walked: more than %" PRIu64 " paths or the game code misbehaved\n", max_paths );
+	}
+
+	int status = 0;
+	for( uint32_t s = 0; s < 3; ++s )
+	{
+		int agree = (walk == 0) && monty_rational_equal( closed.won[s], walked.won[s] );
+		printf( "%-6s %" PRIu64 "/%" PRIu64 " = %.6f%%", g_strategy_names[s],
+				closed.won[s].num, closed.won[s].den, 100.0 * monty_rational_value( closed.won[s] ) );
+		if( walk == 0 )
+		{
+			printf( ", walk %" PRIu64 "/%" PRIu64 " %s", walked.won[s].num, walked.won[s].den,
+					agree ? "agrees" : "DISAGREES" );
+			status |= !agree;
+		}
+		printf( "\n" );
+	}
+
+	double host_switch = 0.0, host_stay = 0.0;
+	char host_text[64];
+	if( variant )
+	{
+		// The thresholds the simulators apply, not the probabilities as given
+		monty_variant_limits limits;
+		monty_variant_limits_from( &host, &limits );
+		monty_variant_effective( &limits, &host );
+		check_variant_exact( &host, &host_switch, &host_stay );
+		snprintf( host_text, sizeof(host_text), "with bias %.4f, blind %.4f", host.lower_bias, host.blind );
+		printf( "host %s: switch %.6f%%, stay %.6f%% of the games without the prize shown\n",
+				host_text + strlen( "with " ), 100.0 * host_switch, 100.0 * host_stay );
+	}
+
+	if( check )
+	{
+		if( !have_line )
+		{
+			fprintf( stderr, "no \"Games Played:\" line on stdin\n" );
+			return 1;
+		}
+		if( variant )
+		{
+			status |= check_rate_against( "switch", &switched, host_switch, host_text, z );
+			status |= check_rate_against( "stay", &stayed, host_stay, host_text, z );
+		}
+		else
+		{
+			status |= check_rate_against_rational( "switch", &switched, closed.won[SIM_STRATEGY_SWITCH], z );
+			status |= check_rate_against_rational( "stay", &stayed, closed.won[SIM_STRATEGY_STAY], z );
+		}
+	}
+	return status;
+}
@@ -0,0 +1,281 @@
+/**
+ * \file
+ *
+ * \brief Checkpoints of a simulation campaign
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "monty_checkpoint.h"
+
+/** \brief payload bytes of format version 1 */
+#define CHECKPOINT_PAYLOAD 144
+
+/** \brief magic, version, payload length, payload and CRC */
+#define CHECKPOINT_BYTES (12 + CHECKPOINT_PAYLOAD + 4)
+
+/** \brief CRC-32 (IEEE 802.3, as zlib) of a buffer */
+static uint32_t checkpoint_crc32( const uint8_t *p_data, size_t length )
+{
+	uint32_t crc = 0xFFFFFFFFu;
+	for( size_t i = 0; i < length; ++i )
+	{
+		crc ^= p_data[i];
+		for( int bit = 0; bit < 8; ++bit )
+		{
+			crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+		}
+	}
+	return ~crc;
+}
+
+static uint8_t *checkpoint_put32( uint8_t *p, uint32_t value )
+{
+	for( int i = 0; i < 4; ++i )
+	{
+		*p++ = (uint8_t)(value >> (8 * i));
+	}
+	return p;
+}
+
+static uint8_t *checkpoint_put64( uint8_t *p, uint64_t value )
+{
+	for( int i = 0; i < 8; ++i )
+	{
+		*p++ = (uint8_t)(value >> (8 * i));
+	}
+	return p;
+}
+
+static uint8_t *checkpoint_put_double( uint8_t *p, double value )
+{
+	uint64_t bits;
+	memcpy( &bits, &value, sizeof(bits) );
+	return checkpoint_put64( p, bits );
+}
+
+static uint8_t *checkpoint_put_stats( uint8_t *p, const monty_stats *p_stats )
+{
+	p = checkpoint_put64( p, p_stats->number_of_games );
+	p = checkpoint_put64( p, p_stats->times_switched );
+	p = checkpoint_put64( p, p_stats->times_switched_won );
+	return checkpoint_put64( p, p_stats->times_won );
+}
+
+static uint32_t checkpoint_get32( const uint8_t **pp )
+{
+	uint32_t value = 0;
+	for( int i = 0; i < 4; ++i )
+	{
+		value |= (uint32_t)*(*pp)++ << (8 * i);
+	}
+	return value;
+}
+
+static uint64_t checkpoint_get64( const uint8_t **pp )
+{
+	uint64_t value = 0;
+	for( int i = 0; i < 8; ++i )
+	{
+		value |= (uint64_t)*(*pp)++ << (8 * i);
+	}
+	return value;
+}
+
+static double checkpoint_get_double( const uint8_t **pp )
+{
+	uint64_t bits = checkpoint_get64( pp );
+	double value;
+	memcpy( &value, &bits, sizeof(value) );
+	return value;
+}
+
+static void checkpoint_get_stats( const uint8_t **pp, monty_stats *p_stats )
+{
+	p_stats->number_of_games = checkpoint_get64( pp );
+	p_stats->times_switched = checkpoint_get64( pp );
+	p_stats->times_switched_won = checkpoint_get64( pp );
+	p_stats->times_won = checkpoint_get64( pp );
+}
+
+/** \brief writes a checkpoint, replacing the previous one only once the new one is on disk
+ *
+ * \param p_path - checkpoint file
+ * \param p_checkpoint - settings and progress to save
+ * \returns 0 if everything is okay, -1 when the file could not be written
+ */
+int monty_checkpoint_save( const char *p_path, const monty_checkpoint *p_checkpoint )
+{
+	uint8_t buffer[CHECKPOINT_BYTES];
+	uint8_t *p = buffer;
+
+	memcpy( p, "MHCK", 4 );
+	p = checkpoint_put32( p + 4, MONTY_CHECKPOINT_VERSION );
+	p = checkpoint_put32( p, CHECKPOINT_PAYLOAD );
+	p = checkpoint_put64( p, p_checkpoint->seed );
+	p = checkpoint_put64( p, p_checkpoint->games );
+	p = checkpoint_put64( p, p_checkpoint->batch_blocks );
+	p = checkpoint_put32( p, p_checkpoint->strategy );
+	p = checkpoint_put32( p, p_checkpoint->door_count );
+	p = checkpoint_put32( p, p_checkpoint->reveal_count );
+	p = checkpoint_put32( p, p_checkpoint->verify );
+	p = checkpoint_put_double( p, p_checkpoint->half_width );
+	p = checkpoint_put_double( p, p_checkpoint->delta );
+	p = checkpoint_put_double( p, p_checkpoint->alpha );
+	p = checkpoint_put64( p, p_checkpoint->done_blocks );
+	p = checkpoint_put64( p, p_checkpoint->elapsed_ns );
+	p = checkpoint_put_stats( p, &p_checkpoint->totals );
+	p = checkpoint_put_stats( p, &p_checkpoint->reference );
+	p = checkpoint_put32( p, checkpoint_crc32( buffer, (size_t)(p - buffer) ) );
+
+	char temp_path[4096];
+	if( snprintf( temp_path, sizeof(temp_path), "%s.tmp", p_path ) >= (int)sizeof(temp_path) )
+	{
+		return -1;
+	}
+	FILE *p_file = fopen( temp_path, "wb" );
+	if( p_file == NULL )
+	{
+		return -1;
+	}
+	int ok = (fwrite( buffer, 1, sizeof(buffer), p_file ) == sizeof(buffer)) && (fflush( p_file ) == 0) &&
+			(fsync( fileno( p_file ) ) == 0);
+	ok = (fclose( p_file ) == 0) && ok;
+	if( !ok || (rename( temp_path, p_path ) != 0) )
+	{
+		remove( temp_path );
+		return -1;
+	}
+	return 0;
+}
+
+/** \brief reads a checkpoint
+ *
+ * \param p_path - checkpoint file
+ * \param p_checkpoint - settings and progress read
+ * \returns 0 if everything is okay, 1 when there is no checkpoint, -1 when the file is not a valid checkpoint
+ */
+int monty_checkpoint_load( const char *p_path, monty_checkpoint *p_checkpoint )
+{
+	uint8_t buffer[CHECKPOINT_BYTES + 1];
+	FILE *p_file = fopen( p_path, "rb" );
+	if( p_file == NULL )
+	{
+		return 1;
+	}
+	size_t length = fread( buffer, 1, sizeof(buffer), p_file );
+	fclose( p_file );
+
+	const uint8_t *p = buffer + 4;
+	if( (length != CHECKPOINT_BYTES) || (memcmp( buffer, "MHCK", 4 ) != 0) ||
+		(checkpoint_get32( &p ) != MONTY_CHECKPOINT_VERSION) || (checkpoint_get32( &p ) != CHECKPOINT_PAYLOAD) )
+	{
+		return -1;
+	}
+	const uint8_t *p_crc = buffer + CHECKPOINT_BYTES - 4;
+	if( checkpoint_get32( &p_crc ) != checkpoint_crc32( buffer, CHECKPOINT_BYTES - 4 ) )
+	{
+		return -1;
+	}
+
+	p_checkpoint->seed = checkpoint_get64( &p );
+	p_checkpoint->games = checkpoint_get64( &p );
+	p_checkpoint->batch_blocks = checkpoint_get64( &p );
+	p_checkpoint->strategy = checkpoint_get32( &p );
+	p_checkpoint->door_count = checkpoint_get32( &p );
+	p_checkpoint->reveal_count = checkpoint_get32( &p );
+	p_checkpoint->verify = checkpoint_get32( &p );
+	p_checkpoint->half_width = checkpoint_get_double( &p );
+	p_checkpoint->delta = checkpoint_get_double( &p );
+	p_checkpoint->alpha = checkpoint_get_double( &p );
+	p_checkpoint->done_blocks = checkpoint_get64( &p );
+	p_checkpoint->elapsed_ns = checkpoint_get64( &p );
+	checkpoint_get_stats( &p, &p_checkpoint->totals );
+	checkpoint_get_stats( &p, &p_checkpoint->reference );
+	return 0;
+}
+
+/** \brief non-zero when both checkpoints are of the same campaign, whatever their progress */
+int monty_checkpoint_same_campaign( const monty_checkpoint *p_a, const monty_checkpoint *p_b )
+{
+	return (p_a->seed == p_b->seed) && (p_a->games == p_b->games) && (p_a->batch_blocks == p_b->batch_blocks) &&
+			(p_a->strategy == p_b->strategy) && (p_a->door_count == p_b->door_count) &&
+			(p_a->reveal_count == p_b->reveal_count) && (p_a->verify == p_b->verify) &&
+			(p_a->half_width == p_b->half_width) && (p_a->delta == p_b->delta) && (p_a->alpha == p_b->alpha);
+}
+
+/** \brief writer thread, saves the newest posted checkpoint until stopped */
+static void *checkpoint_writer_main( void *p_arg )
+{
+	monty_checkpoint_writer *p_writer = (monty_checkpoint_writer *)p_arg;
+	monty_checkpoint checkpoint;
+
+	pthread_mutex_lock( &p_writer->lock );
+	for( ;; )
+	{
+		while( !p_writer->has_pending && !p_writer->stop )
+		{
+			pthread_cond_wait( &p_writer->wake, &p_writer->lock );
+		}
+		if( !p_writer->has_pending )
+		{
+			break;
+		}
+		checkpoint = p_writer->pending;
+		p_writer->has_pending = 0;
+
+		// The simulation can post the next one while this one is written
+		pthread_mutex_unlock( &p_writer->lock );
+		int result = monty_checkpoint_save( p_writer->p_path, &checkpoint );
+		pthread_mutex_lock( &p_writer->lock );
+		p_writer->written += (result == 0);
+		p_writer->errors += (result != 0);
+	}
+	pthread_mutex_unlock( &p_writer->lock );
+	return NULL;
+}
+
+/** \brief starts the writer thread
+ *
+ * \param p_writer - writer to start
+ * \param p_path - checkpoint file, must stay valid until the writer is stopped
+ * \returns 0 if everything is okay, -1 when the thread could not be started
+ */
+int monty_checkpoint_writer_start( monty_checkpoint_writer *p_writer, const char *p_path )
+{
+	memset( p_writer, 0, sizeof(*p_writer) );
+	p_writer->p_path = p_path;
+	pthread_mutex_init( &p_writer->lock, NULL );
+	pthread_cond_init( &p_writer->wake, NULL );
+	return (pthread_create( &p_writer->thread, NULL, checkpoint_writer_main, p_writer ) == 0) ? 0 : -1;
+}
+
+/** \brief hands a checkpoint to the writer, a checkpoint it has not started on yet is replaced */
+void monty_checkpoint_writer_post( monty_checkpoint_writer *p_writer, const monty_checkpoint *p_checkpoint )
+{
+	pthread_mutex_lock( &p_writer->lock );
+	p_writer->pending = *p_checkpoint;
+	p_writer->has_pending = 1;
+	pthread_cond_signal( &p_writer->wake );
+	pthread_mutex_unlock( &p_writer->lock );
+}
+
+/** \brief writes the last posted checkpoint and stops the writer
+ *
+ * \returns the number of checkpoints that could not be written
+ */
+uint32_t monty_checkpoint_writer_stop( monty_checkpoint_writer *p_writer )
+{
+	pthread_mutex_lock( &p_writer->lock );
+	p_writer->stop = 1;
+	pthread_cond_signal( &p_writer->wake );
+	pthread_mutex_unlock( &p_writer->lock );
+	pthread_join( p_writer->thread, NULL );
+	pthread_mutex_destroy( &p_writer->lock );
+	pthread_cond_destroy( &p_writer->wake );
+	return p_writer->errors;
+}
@@ -0,0 +1,74 @@
+/**
+ * \file
+ *
+ * \brief Checkpoints of a simulation campaign
+ *
+ * The game stream is counter based (see monty_kernel_fill()): the position of
+ * every stream a run draws from is the index of the next block of games. A
+ * checkpoint therefore only holds the campaign's settings, the number of blocks
+ * played and the counters, and a run resumed from it plays the remaining blocks
+ * to exactly the counters of an uninterrupted run.
+ *
+ * The file is 160 bytes: "MHCK", the format version, the payload length, the
+ * payload as little endian integers and a CRC-32 of everything before it. It is
+ * written to <path>.tmp and renamed over <path>, so a run killed while writing
+ * leaves the previous checkpoint in place.
+ *
+ * monty_checkpoint_writer saves from a thread of its own; the simulation posts
+ * a copy of its progress between batches and goes on playing.
+ *
+ */
+
+#ifndef MONTY_CHECKPOINT_H_INCLUDED
+#define MONTY_CHECKPOINT_H_INCLUDED
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "monty_stats.h"
+
+/** \brief current file format */
+#define MONTY_CHECKPOINT_VERSION 1
+
+/** \brief campaign settings and progress */
+typedef struct
+{
+	uint64_t seed;
+	uint64_t games;          /**< Games in the campaign */
+	uint64_t batch_blocks;   /**< Blocks between stop rule checks */
+	uint32_t strategy;       /**< SIM_STRATEGY */
+	uint32_t door_count;
+	uint32_t reveal_count;
+	uint32_t verify;         /**< reference holds the scalar reference counters */
+	double half_width;       /**< Stop rules, see monty_sim.c */
+	double delta;
+	double alpha;
+	uint64_t done_blocks;    /**< Blocks played, the stream position to resume from */
+	uint64_t elapsed_ns;     /**< Time spent playing them, over all sessions */
+	monty_stats totals;
+	monty_stats reference;
+} monty_checkpoint;
+
+/** \brief saves checkpoints in the background */
+typedef struct
+{
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	const char *p_path;
+	monty_checkpoint pending;  /**< Newest checkpoint not written yet */
+	int has_pending;
+	int stop;
+	uint32_t written;
+	uint32_t errors;
+} monty_checkpoint_writer;
+
+int monty_checkpoint_save( const char *p_path, const monty_checkpoint *p_checkpoint );
+int monty_checkpoint_load( const char *p_path, monty_checkpoint *p_checkpoint );
+int monty_checkpoint_same_campaign( const monty_checkpoint *p_a, const monty_checkpoint *p_b );
+
+int monty_checkpoint_writer_start( monty_checkpoint_writer *p_writer, const char *p_path );
+void monty_checkpoint_writer_post( monty_checkpoint_writer *p_writer, const monty_checkpoint *p_checkpoint );
+uint32_t monty_checkpoint_writer_stop( monty_checkpoint_writer *p_writer );
+
+#endif /* MONTY_CHECKPOINT_H_INCLUDED */
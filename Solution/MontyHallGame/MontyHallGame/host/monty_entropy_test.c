@@ -0,0 +1,321 @@
+/**
+ * \file
+ *
+ * \brief Statistical tests of the seeds the entropy pool gives
+ *
+ * First checks the permutation against the ChaCha20 block test vector of RFC
+ * 7539 (section 2.3.2). Then simulates a number of power ons and collects the
+ * 64 bit seed each of them would get from get_seed() in main.c, for two
+ * models of the inputs:
+ *
+ *   noise     what the board feeds the pool: an RTC a few seconds further at
+ *             every power on, a steady temperature, ADC readings whose lowest
+ *             bit is noise and cycle counts with a few cycles of jitter
+ *   counter   the worst case: no noise at all, the power ons differ only in
+ *             the RTC time, so every input is known
+ *
+ * The seeds of each model go through a monobit and a runs test (NIST SP
+ * 800-22), a chi-square test of the byte values, the serial correlation of
+ * consecutive 32 bit words, a search for repeated seeds and an avalanche test
+ * (one input bit flipped should change half of the seed's bits). A test with
+ * a p value below MONTY_ENTROPY_TEST_ALPHA, or any repeated seed, fails the run.
+ *
+ * Usage: monty_entropy_test [-n power_ons] [-S seed] [-o file]
+ *
+ * -o writes the seeds of the counter model as raw bytes, for test suites
+ * such as dieharder (-g 201) or PractRand.
+ *
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "monty_entropy.h"
+#include "prng.h"
+
+/** \brief p values below this fail a test */
+#define MONTY_ENTROPY_TEST_ALPHA 1e-4
+
+/** \brief trials of the avalanche test */
+#define TEST_AVALANCHE_TRIALS 4096
+
+typedef enum
+{
+	TEST_MODEL_NOISE,
+	TEST_MODEL_COUNTER
+} TEST_MODEL;
+
+static const char *const g_model_names[] = { "noise", "counter" };
+
+/** \brief one simulated power on
+ *
+ * \param model - how noisy the inputs are
+ * \param power_on - index of the power on
+ * \param p_noise - source of the simulated noise
+ * \param flip_bit - input bit to flip for the avalanche test, -1 for none
+ * \param p_samples - set to the number of samples the pool took to be ready
+ * \returns the seed get_seed() would return
+ */
+static uint64_t test_power_on( TEST_MODEL model, uint64_t power_on, prng_stream *p_noise, int32_t flip_bit,
+							   uint32_t *p_samples )
+{
+	monty_entropy_pool pool;
+	uint32_t inputs[5];
+	uint32_t noisy = model == TEST_MODEL_NOISE;
+
+	monty_entropy_init( &pool, 0x4D6F6E747948616Cull );
+
+	// RTC time and date as main.c packs them, a power on every 7 seconds
+	uint64_t seconds = power_on * 7;
+	inputs[0] = (uint32_t)(((seconds / 3600) % 24) << 16) | (uint32_t)(((seconds / 60) % 60) << 8) |
+				(uint32_t)(seconds % 60);
+	inputs[1] = (uint32_t)((2024u << 16) + seconds / 86400);
+	// Sensor status and 23.5 degrees as a double
+	inputs[2] = 0;
+	inputs[3] = 0;
+	inputs[4] = 0x40378000u;
+
+	for( uint32_t i = 0; i < 5; ++i )
+	{
+		if( (flip_bit >= 0) && (i == 0) )
+		{
+			inputs[0] ^= 1u << flip_bit;
+		}
+		monty_entropy_add( &pool, inputs[i], 0 );
+	}
+
+	uint32_t cycles = 1200000;
+	while( !monty_entropy_ready( &pool ) )
+	{
+		uint32_t noise = noisy ? prng_next_u32( p_noise ) : 0;
+		// Temperature sensor and two open inputs around their mean, the lowest bit noise
+		monty_entropy_add( &pool, 1860 + (noise & 0x1), 1 );
+		monty_entropy_add( &pool, 2048 + ((noise >> 1) & 0x1), 1 );
+		monty_entropy_add( &pool, 2051 + ((noise >> 2) & 0x1), 1 );
+		// A conversion takes about 3 x 20 ADC clocks of 18.75 CPU cycles, give or take a few
+		cycles += 1125 + ((noise >> 3) & 0x7);
+		monty_entropy_add( &pool, cycles, 0 );
+	}
+	*p_samples = pool.samples;
+
+	uint32_t words[2];
+	monty_entropy_extract( &pool, words, 2 );
+	return ((uint64_t)words[1] << 32) | words[0];
+}
+
+/** \brief p value of a standard normal statistic, two sided */
+static double test_p_normal( double z )
+{
+	return erfc( fabs( z ) / sqrt( 2.0 ) );
+}
+
+static void test_report( const char *p_name, double statistic, double p, int *p_failed )
+{
+	int failed = !(p >= MONTY_ENTROPY_TEST_ALPHA);
+	printf( "  %-22s %12.4f  p = %.6f%s\n", p_name, statistic, p, failed ? "  FAIL" : "" );
+	*p_failed |= failed;
+}
+
+static int test_compare_u64( const void *p_a, const void *p_b )
+{
+	uint64_t a = *(const uint64_t *)p_a;
+	uint64_t b = *(const uint64_t *)p_b;
+	return (a > b) - (a < b);
+}
+
+/** \brief runs every test on the seeds of one model
+ *
+ * \returns non-zero when a test failed
+ */
+static int test_model( TEST_MODEL model, uint64_t power_ons, uint64_t noise_seed, FILE *p_out )
+{
+	uint64_t *p_seeds = malloc( power_ons * sizeof(*p_seeds) );
+	prng_stream noise;
+	uint32_t samples = 0;
+	int failed = 0;
+
+	if( p_seeds == NULL )
+	{
+		fprintf( stderr, "out of memory\n" );
+		return 1;
+	}
+	prng_init( &noise, noise_seed, model );
+	for( uint64_t i = 0; i < power_ons; ++i )
+	{
+		p_seeds[i] = test_power_on( model, i, &noise, -1, &samples );
+	}
+	printf( "%s model: %" PRIu64 " power ons, ready after %u samples\n", g_model_names[model], power_ons, samples );
+	if( p_out != NULL )
+	{
+		fwrite( p_seeds, sizeof(*p_seeds), power_ons, p_out );
+	}
+
+	// Monobit and runs (NIST SP 800-22 2.1 and 2.3) over all bits, lowest bit of each seed first
+	double bits = 64.0 * (double)power_ons;
+	uint64_t ones = 0, runs = 1;
+	uint32_t previous = p_seeds[0] & 0x1;
+	for( uint64_t i = 0; i < power_ons; ++i )
+	{
+		ones += (uint64_t)__builtin_popcountll( p_seeds[i] );
+		// Bit j against bit j-1, bit 0 against the top bit of the previous seed (itself for the first)
+		runs += (uint64_t)__builtin_popcountll( p_seeds[i] ^ ((p_seeds[i] << 1) | previous) );
+		previous = (uint32_t)(p_seeds[i] >> 63);
+	}
+	double monobit = ((double)ones - bits / 2.0) / sqrt( bits / 4.0 );
+	test_report( "monobit z", monobit, test_p_normal( monobit ), &failed );
+	double pi = (double)ones / bits;
+	double runs_z = ((double)runs - 2.0 * bits * pi * (1.0 - pi)) / (2.0 * sqrt( bits ) * pi * (1.0 - pi));
+	test_report( "runs z", runs_z, test_p_normal( runs_z ), &failed );
+
+	// Byte values, 255 degrees of freedom, Wilson-Hilferty to a normal
+	uint64_t counts[256] = { 0 };
+	const uint8_t *p_bytes = (const uint8_t *)p_seeds;
+	for( uint64_t i = 0; i < power_ons * 8; ++i )
+	{
+		counts[p_bytes[i]]++;
+	}
+	double expected = (double)power_ons * 8.0 / 256.0;
+	double chi2 = 0.0;
+	for( uint32_t i = 0; i < 256; ++i )
+	{
+		chi2 += ((double)counts[i] - expected) * ((double)counts[i] - expected) / expected;
+	}
+	double df = 255.0;
+	double chi2_z = (cbrt( chi2 / df ) - (1.0 - 2.0 / (9.0 * df))) / sqrt( 2.0 / (9.0 * df) );
+	test_report( "byte chi-square", chi2, test_p_normal( chi2_z ), &failed );
+
+	// Serial correlation of consecutive 32 bit words taken as uniforms
+	const uint32_t *p_words = (const uint32_t *)p_seeds;
+	uint64_t word_count = power_ons * 2;
+	double sum = 0.0, sum_squares = 0.0, sum_products = 0.0;
+	for( uint64_t i = 0; i < word_count; ++i )
+	{
+		double u = (double)p_words[i] / 4294967296.0 - 0.5;
+		double next = (double)p_words[(i + 1) % word_count] / 4294967296.0 - 0.5;
+		sum += u;
+		sum_squares += u * u;
+		sum_products += u * next;
+	}
+	double mean = sum / (double)word_count;
+	double correlation = (sum_products / (double)word_count - mean * mean) /
+						 (sum_squares / (double)word_count - mean * mean);
+	test_report( "serial correlation", correlation, test_p_normal( correlation * sqrt( (double)word_count ) ), &failed );
+
+	// Repeated seeds, none expected below 2^32 power ons
+	qsort( p_seeds, power_ons, sizeof(*p_seeds), test_compare_u64 );
+	uint64_t repeats = 0;
+	for( uint64_t i = 1; i < power_ons; ++i )
+	{
+		repeats += p_seeds[i] == p_seeds[i - 1];
+	}
+	printf( "  %-22s %12" PRIu64 "%s\n", "repeated seeds", repeats, repeats ? "  FAIL" : "" );
+	failed |= repeats != 0;
+
+	// Avalanche: flipping one RTC bit changes each seed bit with probability 1/2
+	uint64_t changed = 0;
+	for( uint32_t trial = 0; trial < TEST_AVALANCHE_TRIALS; ++trial )
+	{
+		prng_stream same_noise = noise;
+		uint64_t base = test_power_on( model, trial, &noise, -1, &samples );
+		uint64_t flipped = test_power_on( model, trial, &same_noise, (int32_t)(trial % 32), &samples );
+		changed += (uint64_t)__builtin_popcountll( base ^ flipped );
+	}
+	double flips = 64.0 * TEST_AVALANCHE_TRIALS;
+	double avalanche = ((double)changed - flips / 2.0) / sqrt( flips / 4.0 );
+	printf( "  %-22s %12.4f  bits changed per flip\n", "avalanche", (double)changed / TEST_AVALANCHE_TRIALS );
+	test_report( "avalanche z", avalanche, test_p_normal( avalanche ), &failed );
+
+	free( p_seeds );
+	return failed;
+}
+
+/** \brief checks the permutation against RFC 7539 2.3.2
+ *
+ * \returns non-zero on a mismatch
+ */
+static int test_chacha20_vector( void )
+{
+	static const uint32_t input[16] = {
+		0x61707865u, 0x3320646Eu, 0x79622D32u, 0x6B206574u,
+		0x03020100u, 0x07060504u, 0x0B0A0908u, 0x0F0E0D0Cu,
+		0x13121110u, 0x17161514u, 0x1B1A1918u, 0x1F1E1D1Cu,
+		0x00000001u, 0x09000000u, 0x4A000000u, 0x00000000u
+	};
+	static const uint32_t expected[16] = {
+		0xE4E7F110u, 0x15593BD1u, 0x1FDD0F50u, 0xC47120A3u,
+		0xC7F4D1C7u, 0x0368C033u, 0x9AAA2204u, 0x4E6CD4C3u,
+		0x466482D2u, 0x09AA9F07u, 0x05D7C214u, 0xA2028BD9u,
+		0xD19C12B5u, 0xB94E16DEu, 0xE883D0CBu, 0x4E3C50A2u
+	};
+	uint32_t state[16];
+	int errors = 0;
+
+	memcpy( state, input, sizeof(state) );
+	monty_entropy_permute( state );
+	for( uint32_t i = 0; i < 16; ++i )
+	{
+		// The block function adds the input back, the permutation alone does not
+		errors += (state[i] + input[i]) != expected[i];
+	}
+	printf( "ChaCha20 test vector (RFC 7539 2.3.2): %s\n", errors ? "FAIL" : "ok" );
+	return errors != 0;
+}
+
+int main( int argc, char **argv )
+{
+	uint64_t power_ons = 1 << 20;
+	uint64_t noise_seed = 1;
+	const char *p_out_name = NULL;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "n:S:o:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'n':
+				power_ons = (uint64_t)strtod( optarg, NULL );
+				break;
+			case 'S':
+				noise_seed = strtoull( optarg, NULL, 0 );
+				break;
+			case 'o':
+				p_out_name = optarg;
+				break;
+			default:
+				fprintf( stderr, "usage: %s [-n power_ons] [-S seed] [-o file]\n", argv[0] );
+				return 1;
+		}
+	}
+	if( power_ons < 2 )
+	{
+		fprintf( stderr, "need at least 2 power ons\n" );
+		return 1;
+	}
+
+	FILE *p_out = NULL;
+	if( p_out_name != NULL )
+	{
+		p_out = fopen( p_out_name, "wb" );
+		if( p_out == NULL )
+		{
+			perror( p_out_name );
+			return 1;
+		}
+	}
+
+	int failed = test_chacha20_vector();
+	failed |= test_model( TEST_MODEL_NOISE, power_ons, noise_seed, NULL );
+	failed |= test_model( TEST_MODEL_COUNTER, power_ons, noise_seed, p_out );
+
+	if( (p_out != NULL) && (fclose( p_out ) != 0) )
+	{
+		perror( p_out_name );
+		failed = 1;
+	}
+	printf( "%s\n", failed ? "FAILED" : "all tests passed" );
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * \file
+ *
+ * \brief Side by side evaluation of player strategies
+ *
+ * Plays every built-in strategy (see monty_strategy.h) through
+ * handle_current_game_update() in one pass over one game stream: game n gets
+ * the same prize door, the same coin toss for Monty and the same random values
+ * for the player's decisions in every strategy (common random numbers). The
+ * strategies are therefore compared game by game, and the standard error of
+ * the difference to the baseline only contains the games in which the two
+ * disagree. For strategies that mostly agree (greedy against switch) that is
+ * far smaller than for independently played runs; the "games x" column gives
+ * the factor. Strategies that always disagree (switch against stay) gain
+ * nothing, as one wins exactly when the other loses.
+ *
+ * The stream is the one monty_sim plays, so "switch", "stay" and "random" give
+ * the same counters as monty_sim -s with the same seed. Learning strategies
+ * depend on the order of the games, so the pass runs on a single thread.
+ *
+ * Usage: monty_eval [-n games] [-S seed] [-b baseline]
+ *
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "host_rand.h"
+#include "monty_kernel.h"
+#include "monty_sim.h"
+#include "monty_strategy.h"
+
+/** \brief results of one strategy */
+typedef struct
+{
+	monty_stats totals;
+	uint64_t won_alone;      /**< Games won while the baseline lost */
+	uint64_t lost_alone;     /**< Games lost while the baseline won */
+	uint64_t errors;         /**< Games abandoned for invalid presses */
+} eval_result;
+
+/** \brief plays one block of games for every strategy and compares them to the baseline */
+static void eval_block( monty_strategy *p_strategies, monty_hall_state *p_states, eval_result *p_results,
+						uint32_t baseline, const monty_draw_block *p_block, uint32_t games )
+{
+	uint64_t won[MONTY_STRATEGY_COUNT];
+
+	for( uint32_t s = 0; s < MONTY_STRATEGY_COUNT; ++s )
+	{
+		won[s] = 0;
+		for( uint32_t i = 0; i < games; ++i )
+		{
+			host_rand_set_draws( p_block->winning[i], p_block->coin[i] );
+			int32_t result = monty_strategy_play( &p_strategies[s], &p_states[s], p_block->first[i], p_block->player[i] );
+			if( result < 0 )
+			{
+				p_results[s].errors++;
+			}
+			won[s] |= (uint64_t)(result > 0) << i;
+		}
+		monty_stats_merge( &p_results[s].totals, &p_states[s].stats );
+		monty_stats_clear( &p_states[s].stats );
+	}
+
+	for( uint32_t s = 0; s < MONTY_STRATEGY_COUNT; ++s )
+	{
+		p_results[s].won_alone += (uint64_t)__builtin_popcountll( won[s] & ~won[baseline] );
+		p_results[s].lost_alone += (uint64_t)__builtin_popcountll( ~won[s] & won[baseline] );
+	}
+}
+
+int main( int argc, char **argv )
+{
+	uint64_t games = 10000000;
+	uint64_t seed = 1;
+	const char *p_baseline = "switch";
+	int opt;
+
+	while( (opt = getopt( argc, argv, "n:S:b:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'n':
+				games = (uint64_t)strtod( optarg, NULL );
+				break;
+			case 'S':
+				seed = strtoull( optarg, NULL, 0 );
+				break;
+			case 'b':
+				p_baseline = optarg;
+				break;
+			default:
+				fprintf( stderr, "usage: %s [-n games] [-S seed] [-b baseline]\n", argv[0] );
+				return 1;
+		}
+	}
+
+	monty_strategy strategies[MONTY_STRATEGY_COUNT];
+	monty_strategy_learner learners[MONTY_STRATEGY_COUNT];
+	monty_hall_state states[MONTY_STRATEGY_COUNT];
+	eval_result results[MONTY_STRATEGY_COUNT];
+	uint32_t baseline = MONTY_STRATEGY_COUNT;
+
+	memset( learners, 0, sizeof(learners) );
+	memset( results, 0, sizeof(results) );
+	for( uint32_t s = 0; s < MONTY_STRATEGY_COUNT; ++s )
+	{
+		monty_strategy_builtin( (MONTY_STRATEGY_BUILTIN)s, &learners[s], &strategies[s] );
+		states[s] = (monty_hall_state){ { 0, 0, 0, 0 }, MONTY_GAME_STARTED,
+								DOOR_NOT_PRESSED, DOOR_NOT_PRESSED, DOOR_NOT_PRESSED };
+		if( strcmp( strategies[s].p_name, p_baseline ) == 0 )
+		{
+			baseline = s;
+		}
+	}
+	if( baseline == MONTY_STRATEGY_COUNT )
+	{
+		fprintf( stderr, "unknown baseline strategy '%s'\n", p_baseline );
+		return 1;
+	}
+
+	prng_stream stream;
+	prng_init( &stream, seed, 0 );
+
+	struct timespec start, stop;
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	monty_draw_block block;
+	for( uint64_t first_game = 0; first_game < games; first_game += MONTY_KERNEL_LANES )
+	{
+		uint64_t left = games - first_game;
+		monty_kernel_fill( &block, &stream, first_game );
+		eval_block( strategies, states, results, baseline, &block,
+					(left < MONTY_KERNEL_LANES) ? (uint32_t)left : MONTY_KERNEL_LANES );
+	}
+
+	clock_gettime( CLOCK_MONOTONIC, &stop );
+	double seconds = (double)(stop.tv_sec - start.tv_sec) + (double)(stop.tv_nsec - start.tv_nsec) * 1e-9;
+
+	const eval_result *p_base = &results[baseline];
+	double n = (double)games;
+	double base_rate = games ? (double)p_base->totals.times_won / n : 0.0;
+
+	printf( "%" PRIu64 " games per strategy, seed %" PRIu64 ", difference against '%s'\n", games, seed, p_baseline );
+	printf( "%-10s %8s %9s %10s %10s %10s %8s\n", "strategy", "win %", "switch %", "diff %", "paired se", "indep se", "games x" );
+	for( uint32_t s = 0; s < MONTY_STRATEGY_COUNT; ++s )
+	{
+		const eval_result *p_result = &results[s];
+		double rate = games ? (double)p_result->totals.times_won / n : 0.0;
+		double diff = games ? ((double)p_result->won_alone - (double)p_result->lost_alone) / n : 0.0;
+
+		// Per game difference is -1, 0 or 1, so E[d^2] is the fraction of discordant games
+		double discordant = games ? (double)(p_result->won_alone + p_result->lost_alone) / n : 0.0;
+		double paired_se = games ? sqrt( (discordant - diff * diff) / n ) : 0.0;
+		double indep_se = games ? sqrt( (rate * (1.0 - rate) + base_rate * (1.0 - base_rate)) / n ) : 0.0;
+
+		printf( "%-10s %8.4f %9.4f %10.4f %10.6f %10.6f ",
+				strategies[s].p_name,
+				100.0 * rate,
+				games ? 100.0 * (double)p_result->totals.times_switched / n : 0.0,
+				100.0 * diff, 100.0 * paired_se, 100.0 * indep_se );
+		if( paired_se > 0.0 )
+		{
+			// Independent runs need this many times more games for the same error
+			printf( "%8.1f\n", (indep_se * indep_se) / (paired_se * paired_se) );
+		}
+		else
+		{
+			printf( "%8s\n", "-" );
+		}
+		if( p_result->errors )
+		{
+			printf( "  %" PRIu64 " games abandoned for invalid presses\n", p_result->errors );
+		}
+	}
+	printf( "%.3f s, %.0f strategy games/s\n", seconds,
+			(seconds > 0.0) ? n * MONTY_STRATEGY_COUNT / seconds : 0.0 );
+	return 0;
+}
@@ -0,0 +1,328 @@
+/**
+ * \file
+ *
+ * \brief Exact win probabilities of the N door / K reveal game
+ *
+ */
+
+#include <string.h>
+
+#include "host_rand.h"
+#include "monty_exact.h"
+
+/** \brief largest number of draws one game takes: the prize door plus Monty's picks */
+#define MONTY_EXACT_MAX_DRAWS (1 + MONTY_NK_MAX_DOORS)
+
+static uint64_t monty_gcd( uint64_t a, uint64_t b )
+{
+	while( b != 0 )
+	{
+		uint64_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/** \brief reduced fraction, the intermediate values may be up to 128 bits */
+static monty_rational monty_rational_reduce( unsigned __int128 num, unsigned __int128 den )
+{
+	monty_rational result;
+	unsigned __int128 a = num;
+	unsigned __int128 b = den;
+	while( b != 0 )
+	{
+		unsigned __int128 t = a % b;
+		a = b;
+		b = t;
+	}
+	result.num = (uint64_t)(num / a);
+	result.den = (uint64_t)(den / a);
+	return result;
+}
+
+static monty_rational monty_rational_make( uint64_t num, uint64_t den )
+{
+	return (num == 0) ? (monty_rational){ 0, 1 } : monty_rational_reduce( num, den );
+}
+
+static monty_rational monty_rational_add( monty_rational a, monty_rational b )
+{
+	if( a.num == 0 )
+	{
+		return b;
+	}
+	uint64_t g = monty_gcd( a.den, b.den );
+	return monty_rational_reduce( (unsigned __int128)a.num * (b.den / g) + (unsigned __int128)b.num * (a.den / g),
+								(unsigned __int128)a.den * (b.den / g) );
+}
+
+static monty_rational monty_rational_mul( monty_rational a, monty_rational b )
+{
+	if( (a.num == 0) || (b.num == 0) )
+	{
+		return (monty_rational){ 0, 1 };
+	}
+	return monty_rational_reduce( (unsigned __int128)a.num * b.num, (unsigned __int128)a.den * b.den );
+}
+
+/** \brief value of a fraction */
+double monty_rational_value( monty_rational value )
+{
+	return (double)value.num / (double)value.den;
+}
+
+/** \brief non-zero when two reduced fractions are the same */
+int monty_rational_equal( monty_rational a, monty_rational b )
+{
+	return (a.num == b.num) && (a.den == b.den);
+}
+
+/** \brief smallest raw draw that monty_nk_random_index() maps to index */
+static uint32_t monty_exact_draw( uint32_t index, uint32_t range )
+{
+	return (uint32_t)((((uint64_t)index << 32) + range - 1) / range);
+}
+
+/** \brief doors Monty picks at random: the opened ones or the ones he leaves closed */
+static uint32_t monty_exact_choices( const monty_nk_rules *p_rules, uint32_t candidates )
+{
+	uint32_t keep_closed = candidates - p_rules->reveal_count;
+	return (p_rules->reveal_count <= keep_closed) ? p_rules->reveal_count : keep_closed;
+}
+
+/** \brief number of draw sequences Monty's picks can take, saturating */
+static uint64_t monty_exact_sequences( const monty_nk_rules *p_rules, uint32_t candidates )
+{
+	uint64_t sequences = 1;
+	for( uint32_t i = 0; i < monty_exact_choices( p_rules, candidates ); ++i )
+	{
+		if( sequences > UINT64_MAX / (candidates - i) )
+		{
+			return UINT64_MAX;
+		}
+		sequences *= candidates - i;
+	}
+	return sequences;
+}
+
+/** \brief textbook win probabilities
+ *
+ * Staying wins when the first door was right, 1/N. Otherwise the prize is
+ * behind one of the N-K-1 other closed doors and a random switch finds it
+ * with 1/(N-K-1).
+ *
+ * \param p_rules - game rules
+ * \param p_result - probabilities
+ */
+void monty_exact_closed_form( const monty_nk_rules *p_rules, monty_exact_result *p_result )
+{
+	uint64_t doors = p_rules->door_count;
+	uint64_t others = doors - p_rules->reveal_count - 1;
+
+	p_result->won[SIM_STRATEGY_STAY] = monty_rational_make( 1, doors );
+	p_result->won[SIM_STRATEGY_SWITCH] = monty_rational_make( doors - 1, doors * others );
+	p_result->won[SIM_STRATEGY_RANDOM] = monty_rational_mul( monty_rational_make( 1, 2 ),
+		monty_rational_add( p_result->won[SIM_STRATEGY_STAY], p_result->won[SIM_STRATEGY_SWITCH] ) );
+	p_result->paths = 0;
+}
+
+/** \brief adds a winning path to the strategies that take it
+ *
+ * \param p_result - win probabilities to add to
+ * \param stayed - the last press was the first door
+ * \param probability - probability of reaching the last press
+ * \param others - closed doors a switching player picks from
+ */
+static void monty_exact_add_win( monty_exact_result *p_result, uint32_t stayed, monty_rational probability, uint32_t others )
+{
+	monty_rational half = monty_rational_make( 1, 2 );
+	SIM_STRATEGY strategy = SIM_STRATEGY_STAY;
+
+	if( !stayed )
+	{
+		strategy = SIM_STRATEGY_SWITCH;
+		probability = monty_rational_mul( probability, monty_rational_make( 1, others ) );
+	}
+	p_result->won[strategy] = monty_rational_add( p_result->won[strategy], probability );
+	p_result->won[SIM_STRATEGY_RANDOM] = monty_rational_add( p_result->won[SIM_STRATEGY_RANDOM],
+												monty_rational_mul( half, probability ) );
+}
+
+/** \brief presses every closed door of a FIRST_DOOR_OPEN N door game
+ *
+ * \param p_rules - game rules
+ * \param p_game_state - game waiting for the last press, not changed
+ * \param probability - probability of reaching this state
+ * \param p_result - win probabilities to add to
+ * \returns 0 if everything is okay, -1 when the game code misbehaves
+ */
+static int monty_exact_last_press( const monty_nk_rules *p_rules, const monty_nk_state *p_game_state,
+									monty_rational probability, monty_exact_result *p_result )
+{
+	if( (p_game_state->state != FIRST_DOOR_OPEN) ||
+		(monty_door_count( p_game_state->open_doors ) != p_rules->reveal_count) ||
+		(p_game_state->open_doors & (monty_door_bit( p_game_state->first_door ) | monty_door_bit( p_game_state->winning_door ))) )
+	{
+		return -1;
+	}
+
+	for( uint32_t door = DOOR_PRESSED_MIN; door <= p_rules->door_count; ++door )
+	{
+		if( p_game_state->open_doors & monty_door_bit( door ) )
+		{
+			continue;
+		}
+
+		monty_nk_state last = *p_game_state;
+		if( (monty_nk_game_update( &last, door ) != 0) ||
+			((last.state != GAME_OVER_WON) && (last.state != GAME_OVER_LOST)) )
+		{
+			return -1;
+		}
+		p_result->paths++;
+		if( last.state == GAME_OVER_WON )
+		{
+			monty_exact_add_win( p_result, door == p_game_state->first_door, probability,
+								p_rules->door_count - p_rules->reveal_count - 1 );
+		}
+	}
+	return 0;
+}
+
+/** \brief plays the three door game through handle_current_game_update() */
+static int monty_exact_walk_classic( monty_exact_result *p_result )
+{
+	monty_rational probability = monty_rational_make( 1, 3 * 3 * 2 );
+
+	for( uint32_t first_door = DOOR_PRESSED_MIN; first_door <= DOOR_PRESSED_MAX; ++first_door )
+	{
+		for( uint32_t winning = 0; winning < 3; ++winning )
+		{
+			for( uint32_t coin = 0; coin < 2; ++coin )
+			{
+				monty_hall_state game_state = { { 0, 0, 0, 0 }, MONTY_GAME_STARTED,
+											DOOR_NOT_PRESSED, DOOR_NOT_PRESSED, DOOR_NOT_PRESSED };
+				uint32_t draws[2] = { monty_exact_draw( winning, 3 ), coin };
+
+				host_rand_set_sequence( draws, 2 );
+				handle_current_game_update( &game_state, first_door );
+				if( (host_rand_used() != 2) || (game_state.state != FIRST_DOOR_OPEN) ||
+					(game_state.open_door == first_door) || (game_state.open_door == game_state.winning_door) )
+				{
+					return -1;
+				}
+
+				for( uint32_t door = DOOR_PRESSED_MIN; door <= DOOR_PRESSED_MAX; ++door )
+				{
+					monty_hall_state last = game_state;
+					if( door == game_state.open_door )
+					{
+						continue;
+					}
+					if( (handle_current_game_update( &last, door ) != 0) ||
+						((last.state != GAME_OVER_WON) && (last.state != GAME_OVER_LOST)) )
+					{
+						return -1;
+					}
+					p_result->paths++;
+					if( last.state == GAME_OVER_WON )
+					{
+						monty_exact_add_win( p_result, door == first_door, probability, 1 );
+					}
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+/** \brief walks Monty's draw sequences from the given position on
+ *
+ * \param p_rules - game rules
+ * \param p_draws - draws of the game so far, the prize door first
+ * \param drawn - draws filled in
+ * \param needed - draws the game takes
+ * \param candidates - doors Monty can pick from
+ * \param first_door - player's first door
+ * \param probability - probability of the draws so far
+ * \param p_result - win probabilities to add to
+ */
+static int monty_exact_walk_draws( const monty_nk_rules *p_rules, uint32_t *p_draws, uint32_t drawn, uint32_t needed,
+									uint32_t candidates, uint32_t first_door, monty_rational probability,
+									monty_exact_result *p_result )
+{
+	if( drawn == needed )
+	{
+		monty_nk_state game_state;
+		monty_nk_init( &game_state, p_rules->door_count, p_rules->reveal_count );
+		host_rand_set_sequence( p_draws, needed );
+		monty_nk_game_update( &game_state, first_door );
+		if( host_rand_used() != needed )
+		{
+			return -1;
+		}
+		return monty_exact_last_press( p_rules, &game_state, probability, p_result );
+	}
+
+	// Pick number drawn-1 chooses among the candidates not picked yet
+	uint32_t range = candidates - (drawn - 1);
+	monty_rational step = monty_rational_mul( probability, monty_rational_make( 1, range ) );
+	for( uint32_t index = 0; index < range; ++index )
+	{
+		p_draws[drawn] = monty_exact_draw( index, range );
+		if( monty_exact_walk_draws( p_rules, p_draws, drawn + 1, needed, candidates, first_door, step, p_result ) != 0 )
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/** \brief exact win probabilities by walking every path through the game code
+ *
+ * \param p_rules - game rules
+ * \param max_paths - give up when there are more paths than this
+ * \param p_result - probabilities and the number of paths walked
+ * \returns 0 if everything is okay, -1 for too many paths or when the game
+ *          code takes an unexpected number of draws or reaches an unexpected state
+ */
+int monty_exact_walk( const monty_nk_rules *p_rules, uint64_t max_paths, monty_exact_result *p_result )
+{
+	uint32_t doors = p_rules->door_count;
+
+	memset( p_result, 0, sizeof(*p_result) );
+	for( uint32_t i = 0; i < 3; ++i )
+	{
+		p_result->won[i] = monty_rational_make( 0, 1 );
+	}
+
+	// Paths: first door, prize door, Monty's draws, last press (at most doors of them)
+	uint64_t sequences = monty_exact_sequences( p_rules, doors - 1 ) + (doors - 1) * monty_exact_sequences( p_rules, doors - 2 );
+	if( (sequences > max_paths / ((uint64_t)doors * doors)) || (sequences == UINT64_MAX) )
+	{
+		return -1;
+	}
+
+	if( (doors == 3) && (p_rules->reveal_count == 1) )
+	{
+		return monty_exact_walk_classic( p_result );
+	}
+
+	uint32_t draws[MONTY_EXACT_MAX_DRAWS];
+	monty_rational probability = monty_rational_make( 1, (uint64_t)doors * doors );
+	for( uint32_t first_door = DOOR_PRESSED_MIN; first_door <= doors; ++first_door )
+	{
+		for( uint32_t winning = 0; winning < doors; ++winning )
+		{
+			uint32_t candidates = (winning + 1 == first_door) ? (doors - 1) : (doors - 2);
+			draws[0] = monty_exact_draw( winning, doors );
+			if( monty_exact_walk_draws( p_rules, draws, 1, 1 + monty_exact_choices( p_rules, candidates ),
+										candidates, first_door, probability, p_result ) != 0 )
+			{
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,45 @@
+/**
+ * \file
+ *
+ * \brief Exact win probabilities of the N door / K reveal game
+ *
+ * monty_exact_walk() enumerates every reachable path through the game state
+ * machine: each first door, each prize door and each sequence of random draws
+ * Monty's door picking can take, followed by each door the player can press
+ * last. The draws are fed to the real game code (handle_current_game_update()
+ * for the three door game, monty_nk_game_update() otherwise) with exact
+ * rational probabilities, so the result checks the implementation as well as
+ * the arithmetic. monty_exact_closed_form() gives the same numbers from the
+ * textbook formulas.
+ *
+ */
+
+#ifndef MONTY_EXACT_H_INCLUDED
+#define MONTY_EXACT_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_nk.h"
+#include "monty_sim.h"
+
+/** \brief probability as a reduced fraction */
+typedef struct
+{
+	uint64_t num;
+	uint64_t den;
+} monty_rational;
+
+/** \brief exact probabilities of a game */
+typedef struct
+{
+	monty_rational won[3];    /**< Win probability, indexed by SIM_STRATEGY */
+	uint64_t paths;           /**< Paths walked, 0 for the closed form */
+} monty_exact_result;
+
+double monty_rational_value( monty_rational value );
+int monty_rational_equal( monty_rational a, monty_rational b );
+
+void monty_exact_closed_form( const monty_nk_rules *p_rules, monty_exact_result *p_result );
+int monty_exact_walk( const monty_nk_rules *p_rules, uint64_t max_paths, monty_exact_result *p_result );
+
+#endif /* MONTY_EXACT_H_INCLUDED */
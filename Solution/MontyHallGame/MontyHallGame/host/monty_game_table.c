@@ -0,0 +1,142 @@
+/**
+ * \file
+ *
+ * \brief Game state machine as a transition table, for the host benchmark
+ *
+ */
+
+#include "monty_game_table.h"
+
+/**
+ * \brief Game state machine as a transition table
+ *
+ * A button press is first classified into an event from three compares with
+ * the current game (see MONTY_EVENT). The table then gives, for every state
+ * and event, the next state and the actions to take: set up a new game, count
+ * the game and its outcome, or reject the press. The table is generated from
+ * the two macros below and the rules of the game are checked on them at
+ * compile time.
+ */
+#define MONTY_EVENT_OPENED(e)   (((e) >> 2) & 0x1)
+#define MONTY_EVENT_WON(e)      (((e) >> 1) & 0x1)
+#define MONTY_EVENT_SWITCHED(e) ((e) & 0x1)
+
+/** \brief state after a press */
+#define MONTY_NEXT_STATE(s, e) \
+	( ((s) == MONTY_GAME_STARTED) ? FIRST_DOOR_OPEN : \
+	  ((s) == FIRST_DOOR_OPEN) ? (MONTY_EVENT_OPENED(e) ? FIRST_DOOR_OPEN : \
+								  MONTY_EVENT_WON(e) ? GAME_OVER_WON : GAME_OVER_LOST) : \
+	  MONTY_GAME_STARTED )
+
+/** \brief actions taken on a press */
+#define MONTY_ACTIONS(s, e) \
+	( ((s) == MONTY_GAME_STARTED) ? MONTY_ACTION_SETUP : \
+	  ((s) == FIRST_DOOR_OPEN) ? (MONTY_EVENT_OPENED(e) ? MONTY_ACTION_REJECT : \
+		(MONTY_ACTION_COUNT_GAME | \
+		 (MONTY_EVENT_WON(e) ? MONTY_ACTION_COUNT_WON : 0) | \
+		 (MONTY_EVENT_SWITCHED(e) ? MONTY_ACTION_COUNT_SWITCHED : 0) | \
+		 ((MONTY_EVENT_WON(e) && MONTY_EVENT_SWITCHED(e)) ? MONTY_ACTION_COUNT_SWITCHED_WON : 0))) : \
+	  0 )
+
+#define MONTY_ALL_EVENTS(check, s) \
+	( check(s, 0) && check(s, 1) && check(s, 2) && check(s, 3) && \
+	  check(s, 4) && check(s, 5) && check(s, 6) && check(s, 7) )
+#define MONTY_ALL_STATES(check) \
+	( MONTY_ALL_EVENTS(check, MONTY_GAME_STARTED) && MONTY_ALL_EVENTS(check, FIRST_DOOR_OPEN) && \
+	  MONTY_ALL_EVENTS(check, GAME_OVER_WON) && MONTY_ALL_EVENTS(check, GAME_OVER_LOST) )
+
+#define MONTY_CHECK_REJECT_KEEPS_STATE(s, e) \
+	( !(MONTY_ACTIONS(s, e) & MONTY_ACTION_REJECT) || ((MONTY_NEXT_STATE(s, e) == (s)) && (MONTY_ACTIONS(s, e) == MONTY_ACTION_REJECT)) )
+#define MONTY_CHECK_GAME_COUNTED_ONCE(s, e) \
+	( ((MONTY_ACTIONS(s, e) & MONTY_ACTION_COUNT_GAME) != 0) == \
+	  (((s) == FIRST_DOOR_OPEN) && ((MONTY_NEXT_STATE(s, e) == GAME_OVER_WON) || (MONTY_NEXT_STATE(s, e) == GAME_OVER_LOST))) )
+#define MONTY_CHECK_WON_COUNTED(s, e) \
+	( ((MONTY_ACTIONS(s, e) & MONTY_ACTION_COUNT_WON) != 0) == \
+	  (((s) != GAME_OVER_WON) && (MONTY_NEXT_STATE(s, e) == GAME_OVER_WON)) )
+#define MONTY_CHECK_COUNTS_NEED_GAME(s, e) \
+	( !(MONTY_ACTIONS(s, e) & (MONTY_ACTION_COUNT_WON | MONTY_ACTION_COUNT_SWITCHED)) || \
+	  (MONTY_ACTIONS(s, e) & MONTY_ACTION_COUNT_GAME) )
+#define MONTY_CHECK_SWITCHED_WON(s, e) \
+	( !(MONTY_ACTIONS(s, e) & MONTY_ACTION_COUNT_SWITCHED_WON) || \
+	  ((MONTY_ACTIONS(s, e) & MONTY_ACTION_COUNT_SWITCHED) && (MONTY_ACTIONS(s, e) & MONTY_ACTION_COUNT_WON)) )
+#define MONTY_CHECK_SETUP_STARTS_GAME(s, e) \
+	( ((MONTY_ACTIONS(s, e) & MONTY_ACTION_SETUP) != 0) == \
+	  ((MONTY_NEXT_STATE(s, e) == FIRST_DOOR_OPEN) && ((s) != FIRST_DOOR_OPEN)) )
+#define MONTY_CHECK_GAME_OVER_RESTARTS(s, e) \
+	( (((s) != GAME_OVER_WON) && ((s) != GAME_OVER_LOST)) || \
+	  ((MONTY_NEXT_STATE(s, e) == MONTY_GAME_STARTED) && (MONTY_ACTIONS(s, e) == 0)) )
+
+_Static_assert( MONTY_ALL_STATES(MONTY_CHECK_REJECT_KEEPS_STATE),
+				"a rejected press must leave the game as it is" );
+_Static_assert( MONTY_ALL_STATES(MONTY_CHECK_GAME_COUNTED_ONCE),
+				"a game must be counted exactly when it ends" );
+_Static_assert( MONTY_ALL_STATES(MONTY_CHECK_WON_COUNTED),
+				"a win must be counted exactly when the game ends won" );
+_Static_assert( MONTY_ALL_STATES(MONTY_CHECK_COUNTS_NEED_GAME),
+				"an outcome can only be counted with its game" );
+_Static_assert( MONTY_ALL_STATES(MONTY_CHECK_SWITCHED_WON),
+				"a switch win must be both a switch and a win" );
+_Static_assert( MONTY_ALL_STATES(MONTY_CHECK_SETUP_STARTS_GAME),
+				"a game must be set up exactly when the first door is picked" );
+_Static_assert( MONTY_ALL_STATES(MONTY_CHECK_GAME_OVER_RESTARTS),
+				"any press on the game over screen must start the next game" );
+_Static_assert( MONTY_ACTIONS(FIRST_DOOR_OPEN, MONTY_EVENT_OPEN_SWITCH) == MONTY_ACTION_REJECT,
+				"pressing the door Monty opened must be rejected" );
+
+#define MONTY_TRANSITION(s, e) { MONTY_NEXT_STATE(s, e), MONTY_ACTIONS(s, e) }
+#define MONTY_TRANSITION_ROW(s) \
+	{ MONTY_TRANSITION(s, 0), MONTY_TRANSITION(s, 1), MONTY_TRANSITION(s, 2), MONTY_TRANSITION(s, 3), \
+	  MONTY_TRANSITION(s, 4), MONTY_TRANSITION(s, 5), MONTY_TRANSITION(s, 6), MONTY_TRANSITION(s, 7) }
+
+/** \brief next state and actions, indexed by [state][event] */
+const monty_transition monty_transition_table[MONTY_HALL_STATES][MONTY_EVENTS] =
+{
+	MONTY_TRANSITION_ROW(MONTY_GAME_STARTED),
+	MONTY_TRANSITION_ROW(FIRST_DOOR_OPEN),
+	MONTY_TRANSITION_ROW(GAME_OVER_WON),
+	MONTY_TRANSITION_ROW(GAME_OVER_LOST)
+};
+
+/** \brief game state machine, transition table version
+ *
+ * Runs the transition table. Apart from the check of the pointer, the only
+ * branch is the one around setting up a game, which draws the random values
+ * only then so that the sequence of draws is the same as ever.
+ *
+ * Not the one the game runs: it adds every counter on every press and the
+ * setup branch remains, so it takes more cycles per press than the switch in
+ * handle_current_game_update(); bench_game_update checks and times both.
+ *
+ * \param p_game_state - pointer to the current game state, which will be updated
+ * \param new_door_press - the door the player selected most recently
+ * \returns 0 if everything is okay -1 for errors and player picking an open door
+ */
+int32_t handle_current_game_update_table( monty_hall_state *p_game_state, uint32_t new_door_press )
+{
+	if( p_game_state == NULL )
+	{
+		return -1;
+	}
+
+	// States outside the table restart the game, like the game over states
+	uint32_t state = ((uint32_t)p_game_state->state < MONTY_HALL_STATES) ? (uint32_t)p_game_state->state : GAME_OVER_LOST;
+	uint32_t event = ((uint32_t)(new_door_press == p_game_state->open_door) << 2) |
+					 ((uint32_t)(new_door_press == p_game_state->winning_door) << 1) |
+					 (uint32_t)(new_door_press != p_game_state->first_door);
+	monty_transition transition = monty_transition_table[state][event];
+	uint32_t actions = transition.actions;
+
+	if( actions & MONTY_ACTION_SETUP )
+	{
+		p_game_state->winning_door = monty_hall_random_door( monty_hall_rand() );
+		p_game_state->first_door = new_door_press;
+		p_game_state->open_door = pick_open_door( p_game_state->winning_door, new_door_press );
+	}
+	p_game_state->stats.number_of_games += (actions / MONTY_ACTION_COUNT_GAME) & 0x1;
+	p_game_state->stats.times_won += (actions / MONTY_ACTION_COUNT_WON) & 0x1;
+	p_game_state->stats.times_switched += (actions / MONTY_ACTION_COUNT_SWITCHED) & 0x1;
+	p_game_state->stats.times_switched_won += (actions / MONTY_ACTION_COUNT_SWITCHED_WON) & 0x1;
+	p_game_state->state = (MONTY_HALL_STATE)transition.next_state;
+
+	return -(int32_t)((actions / MONTY_ACTION_REJECT) & 0x1);
+}
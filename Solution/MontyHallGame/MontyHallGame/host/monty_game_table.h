@@ -0,0 +1,66 @@
+/**
+ * \file
+ *
+ * \brief Game state machine as a transition table, for the host benchmark
+ *
+ * The same rules as handle_current_game_update() in monty_hall.c, written as
+ * a table of next state and actions for every state and press event, with
+ * the rules of the game checked on it at compile time. It takes more cycles
+ * per press than the switch, so the firmware keeps the switch and the table
+ * only lives here, next to bench_game_update, which compares the two.
+ *
+ */
+
+#ifndef MONTY_GAME_TABLE_H_INCLUDED
+#define MONTY_GAME_TABLE_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_hall.h"
+
+/** \brief number of states in MONTY_HALL_STATE */
+#define MONTY_HALL_STATES 4
+
+/** \brief what a button press means for the current game
+ *
+ * Bit 2 is set when the press is on the door Monty opened, bit 1 when it is
+ * on the prize and bit 0 when it is not on the first door.
+ */
+typedef enum
+{
+	MONTY_EVENT_STAY_LOST,     /**< First door again, not the prize */
+	MONTY_EVENT_SWITCH_LOST,   /**< Other door, not the prize */
+	MONTY_EVENT_STAY_WON,      /**< First door again, the prize */
+	MONTY_EVENT_SWITCH_WON,    /**< Other door, the prize */
+	MONTY_EVENT_OPEN_STAY,     /**< Door Monty opened, also the first door (only before a game) */
+	MONTY_EVENT_OPEN_SWITCH,   /**< Door Monty opened */
+	MONTY_EVENT_OPEN_STAY_WON, /**< Door Monty opened, also the first door and the prize (only before a game) */
+	MONTY_EVENT_OPEN_SWITCH_WON /**< Door Monty opened, also the prize (only before a game) */
+} MONTY_EVENT;
+
+/** \brief number of events in MONTY_EVENT */
+#define MONTY_EVENTS 8
+
+/** \brief actions of a transition, as bits */
+enum MONTY_ACTIONS
+{
+	MONTY_ACTION_SETUP              = 0x01, /**< Draw the prize, store the first door and open Monty's door */
+	MONTY_ACTION_COUNT_GAME         = 0x02, /**< Count a finished game */
+	MONTY_ACTION_COUNT_WON          = 0x04, /**< Count a win */
+	MONTY_ACTION_COUNT_SWITCHED     = 0x08, /**< Count a switch */
+	MONTY_ACTION_COUNT_SWITCHED_WON = 0x10, /**< Count a win after switching */
+	MONTY_ACTION_REJECT             = 0x20  /**< Invalid press, return -1 */
+};
+
+/** \brief entry of the transition table */
+typedef struct
+{
+	uint8_t next_state; /**< MONTY_HALL_STATE after the press */
+	uint8_t actions;    /**< MONTY_ACTIONS bits */
+} monty_transition;
+
+extern const monty_transition monty_transition_table[MONTY_HALL_STATES][MONTY_EVENTS];
+
+int32_t handle_current_game_update_table( monty_hall_state *p_game_state, uint32_t new_door_press );
+
+#endif /* MONTY_GAME_TABLE_H_INCLUDED */
@@ -0,0 +1,314 @@
+/**
+ * \file
+ *
+ * \brief Plays the three door game against biased, blind and selective hosts
+ *
+ * Sweeps a grid of host variants (see monty_variant.h) in one pass: every game
+ * is played for every variant on the same draws. For each variant it prints
+ * the rates the variant changes next to their exact values and flags rates that
+ * deviate by more than MONTY_HOSTS_Z_LIMIT standard errors:
+ *
+ *   switch|L   switching wins, in games in which Monty opened the lower
+ *              numbered free door (1 / (1 + lower_bias) with an informed host
+ *              who always offers)
+ *   switch|H   the same with the higher numbered door (1 / (2 - lower_bias))
+ *   win        games won, over the games not ended by a shown prize
+ *   shown      games in which a blind Monty opened the prize door
+ *
+ * Usage: monty_hosts [-n games] [-t threads] [-s switch|stay|random] [-S seed]
+ *                    [-b biases] [-f blind] [-o offer_right] [-w offer_wrong]
+ *
+ * Lists of values are comma separated ("0,0.25,1") or "first:last:count".
+ *
+ *   ./monty_hosts -n 1e8 -b 0:1:11
+ *   ./monty_hosts -n 1e8 -f 0:1:5 -s stay
+ *   ./monty_hosts -n 1e8 -o 0 -w 1          (only offers after a wrong pick)
+ *
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "monty_variant.h"
+
+/** \brief rates further off their exact value than this many standard errors are flagged */
+#define MONTY_HOSTS_Z_LIMIT 5.0
+
+/** \brief most values in a list */
+#define MONTY_HOSTS_MAX_VALUES 256
+
+/** \brief per thread work item */
+typedef struct
+{
+	pthread_t thread;
+	uint64_t first_game;
+	uint64_t games;
+	SIM_STRATEGY strategy;
+	const prng_stream *p_game_stream;
+	const prng_stream *p_host_stream;
+	const monty_variant_limits *p_limits;
+	uint32_t variant_count;
+	monty_variant_stats *p_stats;   /**< One per variant, valid once the thread is joined */
+} hosts_worker;
+
+static void *hosts_worker_main( void *p_arg )
+{
+	hosts_worker *p_worker = (hosts_worker *)p_arg;
+	monty_variant_play( p_worker->p_game_stream, p_worker->p_host_stream, p_worker->first_game, p_worker->games,
+						p_worker->strategy, p_worker->p_limits, p_worker->variant_count, p_worker->p_stats );
+	return NULL;
+}
+
+/** \brief parses "a,b,c" or "first:last:count"
+ *
+ * \returns number of values, 0 for an invalid list
+ */
+static uint32_t hosts_parse_list( const char *p_text, double *p_values )
+{
+	double first, last;
+	unsigned count;
+	char tail;
+	if( sscanf( p_text, "%lf:%lf:%u%c", &first, &last, &count, &tail ) == 3 )
+	{
+		if( (count == 0) || (count > MONTY_HOSTS_MAX_VALUES) )
+		{
+			return 0;
+		}
+		for( uint32_t i = 0; i < count; ++i )
+		{
+			p_values[i] = (count == 1) ? first : first + (last - first) * (double)i / (double)(count - 1);
+		}
+		return count;
+	}
+
+	uint32_t values = 0;
+	const char *p = p_text;
+	while( values < MONTY_HOSTS_MAX_VALUES )
+	{
+		char *p_end;
+		p_values[values] = strtod( p, &p_end );
+		if( p_end == p )
+		{
+			return 0;
+		}
+		values++;
+		if( *p_end == '\0' )
+		{
+			return values;
+		}
+		if( *p_end != ',' )
+		{
+			return 0;
+		}
+		p = p_end + 1;
+	}
+	return 0;
+}
+
+/** \brief standard errors between a measured and an exact rate, 0 when there is nothing to compare */
+static double hosts_z( uint64_t successes, uint64_t trials, double exact )
+{
+	if( trials == 0 )
+	{
+		return 0.0;
+	}
+	double rate = (double)successes / (double)trials;
+	double variance = exact * (1.0 - exact) / (double)trials;
+	if( variance <= 0.0 )
+	{
+		return (fabs( rate - exact ) > 0.0) ? INFINITY : 0.0;
+	}
+	return (rate - exact) / sqrt( variance );
+}
+
+static double hosts_ratio( double num, double den )
+{
+	return (den > 0.0) ? num / den : 0.0;
+}
+
+static void hosts_usage( const char *p_name )
+{
+	fprintf( stderr, "usage: %s [-n games] [-t threads] [-s switch|stay|random] [-S seed]\n"
+					 "       [-b biases] [-f blind] [-o offer_right] [-w offer_wrong]\n", p_name );
+}
+
+int main( int argc, char **argv )
+{
+	uint64_t games = 10000000;
+	long threads = sysconf( _SC_NPROCESSORS_ONLN );
+	SIM_STRATEGY strategy = SIM_STRATEGY_SWITCH;
+	uint64_t seed = 1;
+	double biases[MONTY_HOSTS_MAX_VALUES] = { 0.5 };
+	double blinds[MONTY_HOSTS_MAX_VALUES] = { 0.0 };
+	uint32_t bias_count = 1;
+	uint32_t blind_count = 1;
+	double offer_right = 1.0;
+	double offer_wrong = 1.0;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "n:t:s:S:b:f:o:w:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'n':
+				games = (uint64_t)strtod( optarg, NULL );
+				break;
+			case 't':
+				threads = strtol( optarg, NULL, 10 );
+				break;
+			case 's':
+				if( strcmp( optarg, "switch" ) == 0 )
+				{
+					strategy = SIM_STRATEGY_SWITCH;
+				}
+				else if( strcmp( optarg, "stay" ) == 0 )
+				{
+					strategy = SIM_STRATEGY_STAY;
+				}
+				else if( strcmp( optarg, "random" ) == 0 )
+				{
+					strategy = SIM_STRATEGY_RANDOM;
+				}
+				else
+				{
+					fprintf( stderr, "unknown strategy '%s'\n", optarg );
+					return 1;
+				}
+				break;
+			case 'S':
+				seed = strtoull( optarg, NULL, 0 );
+				break;
+			case 'b':
+				bias_count = hosts_parse_list( optarg, biases );
+				break;
+			case 'f':
+				blind_count = hosts_parse_list( optarg, blinds );
+				break;
+			case 'o':
+				offer_right = strtod( optarg, NULL );
+				break;
+			case 'w':
+				offer_wrong = strtod( optarg, NULL );
+				break;
+			default:
+				hosts_usage( argv[0] );
+				return 1;
+		}
+	}
+	if( (bias_count == 0) || (blind_count == 0) )
+	{
+		fprintf( stderr, "invalid list of values\n" );
+		return 1;
+	}
+	threads = (threads > 0) ? threads : 1;
+
+	uint32_t variant_count = bias_count * blind_count;
+	monty_variant_limits *p_limits = calloc( variant_count, sizeof(*p_limits) );
+	monty_variant_stats *p_stats = calloc( (size_t)threads * variant_count, sizeof(*p_stats) );
+	hosts_worker *p_workers = calloc( (size_t)threads, sizeof(*p_workers) );
+	if( (p_limits == NULL) || (p_stats == NULL) || (p_workers == NULL) )
+	{
+		fprintf( stderr, "out of memory\n" );
+		return 1;
+	}
+	for( uint32_t blind = 0; blind < blind_count; ++blind )
+	{
+		for( uint32_t bias = 0; bias < bias_count; ++bias )
+		{
+			monty_variant variant = { biases[bias], blinds[blind], offer_right, offer_wrong };
+			monty_variant_limits_from( &variant, &p_limits[blind * bias_count + bias] );
+		}
+	}
+
+	prng_stream game_stream, host_stream;
+	prng_init( &game_stream, seed, 0 );
+	prng_init( &host_stream, seed, MONTY_VARIANT_STREAM );
+
+	struct timespec start, stop;
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	// Whole blocks per thread, the remainder spread over the first threads
+	uint64_t blocks = (games + MONTY_KERNEL_LANES - 1) / MONTY_KERNEL_LANES;
+	uint64_t next_block = 0;
+	for( long i = 0; i < threads; ++i )
+	{
+		uint64_t count = blocks / (uint64_t)threads + (((uint64_t)i < blocks % (uint64_t)threads) ? 1 : 0);
+		uint64_t first_game = next_block * MONTY_KERNEL_LANES;
+		uint64_t end_game = (next_block + count) * MONTY_KERNEL_LANES;
+		end_game = (end_game < games) ? end_game : games;
+		p_workers[i] = (hosts_worker){ 0, first_game, (end_game > first_game) ? end_game - first_game : 0, strategy,
+									&game_stream, &host_stream, p_limits, variant_count, &p_stats[i * variant_count] };
+		next_block += count;
+		if( pthread_create( &p_workers[i].thread, NULL, hosts_worker_main, &p_workers[i] ) != 0 )
+		{
+			fprintf( stderr, "failed to start worker %ld\n", i );
+			return 1;
+		}
+	}
+	for( long i = 0; i < threads; ++i )
+	{
+		pthread_join( p_workers[i].thread, NULL );
+		for( uint32_t v = 0; (i > 0) && (v < variant_count); ++v )
+		{
+			monty_variant_merge( &p_stats[v], &p_stats[i * variant_count + v] );
+		}
+	}
+
+	clock_gettime( CLOCK_MONOTONIC, &stop );
+	double seconds = (double)(stop.tv_sec - start.tv_sec) + (double)(stop.tv_nsec - start.tv_nsec) * 1e-9;
+
+	printf( "%-7s %-7s %-20s %-20s %-20s %-20s %s\n", "bias", "blind", "switch|L [exact]", "switch|H [exact]",
+			"win [exact]", "shown [exact]", "max |z|" );
+	int deviates = 0;
+	for( uint32_t v = 0; v < variant_count; ++v )
+	{
+		const monty_variant_stats *p_v = &p_stats[v];
+		monty_variant effective;
+		monty_variant_exact_result exact;
+		monty_variant_effective( &p_limits[v], &effective );
+		monty_variant_exact( &effective, strategy, &exact );
+
+		double exact_lower = hosts_ratio( exact.switched_won[0], exact.switched[0] );
+		double exact_higher = hosts_ratio( exact.switched_won[1], exact.switched[1] );
+		double exact_win = hosts_ratio( exact.won[0] + exact.won[1], exact.opened[0] + exact.opened[1] );
+		uint64_t played = p_v->opened[0].number_of_games + p_v->opened[1].number_of_games;
+		uint64_t won = p_v->opened[0].times_won + p_v->opened[1].times_won;
+
+		double z[4] = {
+			hosts_z( p_v->opened[0].times_switched_won, p_v->opened[0].times_switched, exact_lower ),
+			hosts_z( p_v->opened[1].times_switched_won, p_v->opened[1].times_switched, exact_higher ),
+			hosts_z( won, played, exact_win ),
+			hosts_z( p_v->car_revealed, played + p_v->car_revealed, exact.car_revealed )
+		};
+		double max_z = 0.0;
+		for( int i = 0; i < 4; ++i )
+		{
+			max_z = (fabs( z[i] ) > max_z) ? fabs( z[i] ) : max_z;
+		}
+		deviates += max_z > MONTY_HOSTS_Z_LIMIT;
+
+		printf( "%-7.4f %-7.4f %7.4f%% [%7.4f%%] %7.4f%% [%7.4f%%] %7.4f%% [%7.4f%%] %7.4f%% [%7.4f%%] %5.2f%s\n",
+				effective.lower_bias, effective.blind,
+				100.0 * hosts_ratio( (double)p_v->opened[0].times_switched_won, (double)p_v->opened[0].times_switched ),
+				100.0 * exact_lower,
+				100.0 * hosts_ratio( (double)p_v->opened[1].times_switched_won, (double)p_v->opened[1].times_switched ),
+				100.0 * exact_higher,
+				100.0 * hosts_ratio( (double)won, (double)played ), 100.0 * exact_win,
+				100.0 * hosts_ratio( (double)p_v->car_revealed, (double)(played + p_v->car_revealed) ),
+				100.0 * exact.car_revealed,
+				max_z, (max_z > MONTY_HOSTS_Z_LIMIT) ? "  DEVIATES" : "" );
+	}
+	printf( "%u variants, %ld threads, %.3f s, %.0f games/s, %.0f variant games/s\n", variant_count, threads, seconds,
+			(seconds > 0.0) ? (double)games / seconds : 0.0,
+			(seconds > 0.0) ? (double)games * variant_count / seconds : 0.0 );
+
+	free( p_workers );
+	free( p_stats );
+	free( p_limits );
+	return (deviates != 0) ? 1 : 0;
+}
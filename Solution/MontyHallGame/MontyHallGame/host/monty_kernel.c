@@ -0,0 +1,368 @@
+/**
+ * \file
+ *
+ * \brief Batch game kernels for the host simulator
+ *
+ * The lane parallel kernels work in two steps. The draws of a block are first
+ * packed into one-hot door masks (bit i of w1 is set when game i has the prize
+ * behind door 1, and so on). The rules of pick_open_door() and the FIRST_DOOR_OPEN
+ * case of handle_current_game_update() are then evaluated on those masks with
+ * plain logic operations, 64 games at a time, and counted with popcount.
+ *
+ * Only the packing step depends on the instruction set.
+ *
+ */
+
+#include <string.h>
+
+#include "host_rand.h"
+#include "monty_kernel.h"
+
+/** \brief largest raw value monty_hall_random_door() maps onto door 1 */
+#define MONTY_DOOR1_LIMIT 0x55555555u
+/** \brief largest raw value monty_hall_random_door() maps onto door 2 */
+#define MONTY_DOOR2_LIMIT 0xAAAAAAAAu
+
+/** \brief one-hot door masks for a block of games, bit i belongs to game i */
+typedef struct
+{
+	uint64_t w1, w2, w3; /**< Winning door */
+	uint64_t f1, f2, f3; /**< Player's first door */
+	uint64_t coin;       /**< Monty's coin toss */
+	uint64_t player;     /**< Player's coin toss */
+} monty_lane_masks;
+
+/** \brief fills a block with the draws for games first_game .. first_game+63
+ *
+ * Game n uses Philox block n of the stream, one word per draw, so the draws of
+ * any game only depend on the stream and n. The rounds run over all lanes at
+ * once so the compiler can vectorize the 32x32->64 multiplies.
+ *
+ * \param p_block - block to fill
+ * \param p_stream - game stream, only its key and stream id are used
+ * \param first_game - index of the first game in the block
+ */
+__attribute__((target_clones("avx512f","avx2","default")))
+void monty_kernel_fill( monty_draw_block *p_block, const prng_stream *p_stream, uint64_t first_game )
+{
+	uint32_t c0[MONTY_KERNEL_LANES], c1[MONTY_KERNEL_LANES], c2[MONTY_KERNEL_LANES], c3[MONTY_KERNEL_LANES];
+	uint32_t key0 = p_stream->key[0];
+	uint32_t key1 = p_stream->key[1];
+
+	for( uint32_t i = 0; i < MONTY_KERNEL_LANES; ++i )
+	{
+		c0[i] = (uint32_t)(first_game + i);
+		c1[i] = (uint32_t)((first_game + i) >> 32);
+		c2[i] = p_stream->stream[0];
+		c3[i] = p_stream->stream[1];
+	}
+	for( uint32_t round = 0; round < 10; ++round )
+	{
+		for( uint32_t i = 0; i < MONTY_KERNEL_LANES; ++i )
+		{
+			uint64_t product0 = (uint64_t)0xD2511F53u * c0[i];
+			uint64_t product1 = (uint64_t)0xCD9E8D57u * c2[i];
+			uint32_t hi1 = c1[i];
+			uint32_t hi3 = c3[i];
+			c0[i] = (uint32_t)(product1 >> 32) ^ hi1 ^ key0;
+			c1[i] = (uint32_t)product1;
+			c2[i] = (uint32_t)(product0 >> 32) ^ hi3 ^ key1;
+			c3[i] = (uint32_t)product0;
+		}
+		key0 += 0x9E3779B9u;
+		key1 += 0xBB67AE85u;
+	}
+	memcpy( p_block->winning, c0, sizeof(c0) );
+	memcpy( p_block->coin, c1, sizeof(c1) );
+	memcpy( p_block->first, c2, sizeof(c2) );
+	memcpy( p_block->player, c3, sizeof(c3) );
+}
+
+/** \brief reference: plays every game of the block press by press */
+static void monty_kernel_run_scalar( const monty_draw_block *p_block, uint32_t games,
+									SIM_STRATEGY strategy, monty_stats *p_totals )
+{
+	monty_hall_state game_state = { { 0, 0, 0, 0 }, MONTY_GAME_STARTED,
+								DOOR_NOT_PRESSED, DOOR_NOT_PRESSED, DOOR_NOT_PRESSED };
+
+	for( uint32_t i = 0; i < games; ++i )
+	{
+		uint32_t first_door = monty_hall_random_door( p_block->first[i] );
+		uint32_t second_door = first_door;
+
+		host_rand_set_draws( p_block->winning[i], p_block->coin[i] );
+		handle_current_game_update( &game_state, first_door );
+
+		if( (strategy == SIM_STRATEGY_SWITCH) ||
+			((strategy == SIM_STRATEGY_RANDOM) && (p_block->player[i] & 0x1)) )
+		{
+			second_door = 6 - first_door - game_state.open_door;
+		}
+		handle_current_game_update( &game_state, second_door );
+
+		// Any press on the game over screen starts the next game
+		handle_current_game_update( &game_state, first_door );
+	}
+	monty_stats_merge( p_totals, &game_state.stats );
+}
+
+/** \brief turns the two threshold compare masks of a draw into one-hot door masks */
+static inline void monty_lanes_one_hot( uint64_t le1, uint64_t le2, uint64_t *p_d1, uint64_t *p_d2, uint64_t *p_d3 )
+{
+	*p_d1 = le1;
+	*p_d2 = le2 & ~le1;
+	*p_d3 = ~le2;
+}
+
+/** \brief plays all lanes of a block on the packed masks
+ *
+ * \param p_masks - packed draws
+ * \param valid - lanes that hold a game
+ * \param strategy - player strategy
+ * \param p_totals - totals to add the results to
+ */
+static inline void monty_lanes_resolve( const monty_lane_masks *p_masks, uint64_t valid,
+										SIM_STRATEGY strategy, monty_stats *p_totals )
+{
+	const uint64_t w1 = p_masks->w1, w2 = p_masks->w2, w3 = p_masks->w3;
+	const uint64_t f1 = p_masks->f1, f2 = p_masks->f2, f3 = p_masks->f3;
+	const uint64_t coin = p_masks->coin;
+
+	// Player picked the prize, Monty tosses his coin: lower remaining door on 0, higher on 1
+	uint64_t same = (w1 & f1) | (w2 & f2) | (w3 & f3);
+	uint64_t o1 = (~same & ~w1 & ~f1) | (same & ~f1 & ~coin);
+	uint64_t o2 = (~same & ~w2 & ~f2) | (same & ((f1 & ~coin) | (f3 & coin)));
+	uint64_t o3 = (~same & ~w3 & ~f3) | (same & ~f3 & coin);
+
+	uint64_t switched;
+	switch( strategy )
+	{
+		case SIM_STRATEGY_SWITCH:
+			switched = ~0ull;
+			break;
+		case SIM_STRATEGY_STAY:
+			switched = 0;
+			break;
+		default:
+		case SIM_STRATEGY_RANDOM:
+			switched = p_masks->player;
+			break;
+	}
+
+	// Final door is the first door, or the one neither picked nor opened
+	uint64_t final1 = (switched & ~f1 & ~o1) | (~switched & f1);
+	uint64_t final2 = (switched & ~f2 & ~o2) | (~switched & f2);
+	uint64_t final3 = (switched & ~f3 & ~o3) | (~switched & f3);
+	uint64_t won = ((final1 & w1) | (final2 & w2) | (final3 & w3)) & valid;
+
+	switched &= valid;
+	p_totals->number_of_games    += (uint64_t)__builtin_popcountll( valid );
+	p_totals->times_switched     += (uint64_t)__builtin_popcountll( switched );
+	p_totals->times_switched_won += (uint64_t)__builtin_popcountll( switched & won );
+	p_totals->times_won          += (uint64_t)__builtin_popcountll( won );
+}
+
+/** \brief lane mask for the first games of a block */
+static inline uint64_t monty_lanes_valid( uint32_t games )
+{
+	return (games >= MONTY_KERNEL_LANES) ? ~0ull : ((1ull << games) - 1);
+}
+
+/** \brief portable packing, one compare per lane */
+static void monty_kernel_run_bitslice( const monty_draw_block *p_block, uint32_t games,
+										SIM_STRATEGY strategy, monty_stats *p_totals )
+{
+	uint64_t wl1 = 0, wl2 = 0, fl1 = 0, fl2 = 0, coin = 0, player = 0;
+	monty_lane_masks masks;
+
+	for( uint32_t i = 0; i < MONTY_KERNEL_LANES; ++i )
+	{
+		wl1    |= (uint64_t)(p_block->winning[i] <= MONTY_DOOR1_LIMIT) << i;
+		wl2    |= (uint64_t)(p_block->winning[i] <= MONTY_DOOR2_LIMIT) << i;
+		fl1    |= (uint64_t)(p_block->first[i] <= MONTY_DOOR1_LIMIT) << i;
+		fl2    |= (uint64_t)(p_block->first[i] <= MONTY_DOOR2_LIMIT) << i;
+		coin   |= (uint64_t)(p_block->coin[i] & 0x1) << i;
+		player |= (uint64_t)(p_block->player[i] & 0x1) << i;
+	}
+	monty_lanes_one_hot( wl1, wl2, &masks.w1, &masks.w2, &masks.w3 );
+	monty_lanes_one_hot( fl1, fl2, &masks.f1, &masks.f2, &masks.f3 );
+	masks.coin = coin;
+	masks.player = player;
+	monty_lanes_resolve( &masks, monty_lanes_valid( games ), strategy, p_totals );
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/** \brief AVX2 has no unsigned compare, bias both sides and compare signed */
+__attribute__((target("avx2")))
+static inline uint64_t monty_avx2_le( __m256i value, __m256i biased_limit )
+{
+	__m256i biased = _mm256_xor_si256( value, _mm256_set1_epi32( (int)0x80000000 ) );
+	__m256i gt = _mm256_cmpgt_epi32( biased, biased_limit );
+	return (uint64_t)(uint8_t)~_mm256_movemask_ps( _mm256_castsi256_ps( gt ) );
+}
+
+/** \brief bit 0 of every lane as a mask */
+__attribute__((target("avx2")))
+static inline uint64_t monty_avx2_bit0( __m256i value )
+{
+	return (uint64_t)(uint32_t)_mm256_movemask_ps( _mm256_castsi256_ps( _mm256_slli_epi32( value, 31 ) ) );
+}
+
+__attribute__((target("avx2,popcnt")))
+static void monty_kernel_run_avx2( const monty_draw_block *p_block, uint32_t games,
+									SIM_STRATEGY strategy, monty_stats *p_totals )
+{
+	const __m256i limit1 = _mm256_set1_epi32( (int)(MONTY_DOOR1_LIMIT ^ 0x80000000u) );
+	const __m256i limit2 = _mm256_set1_epi32( (int)(MONTY_DOOR2_LIMIT ^ 0x80000000u) );
+	uint64_t wl1 = 0, wl2 = 0, fl1 = 0, fl2 = 0, coin = 0, player = 0;
+	monty_lane_masks masks;
+
+	for( uint32_t i = 0; i < MONTY_KERNEL_LANES; i += 8 )
+	{
+		__m256i w = _mm256_loadu_si256( (const __m256i *)&p_block->winning[i] );
+		__m256i f = _mm256_loadu_si256( (const __m256i *)&p_block->first[i] );
+		__m256i c = _mm256_loadu_si256( (const __m256i *)&p_block->coin[i] );
+		__m256i p = _mm256_loadu_si256( (const __m256i *)&p_block->player[i] );
+
+		wl1    |= monty_avx2_le( w, limit1 ) << i;
+		wl2    |= monty_avx2_le( w, limit2 ) << i;
+		fl1    |= monty_avx2_le( f, limit1 ) << i;
+		fl2    |= monty_avx2_le( f, limit2 ) << i;
+		coin   |= monty_avx2_bit0( c ) << i;
+		player |= monty_avx2_bit0( p ) << i;
+	}
+	monty_lanes_one_hot( wl1, wl2, &masks.w1, &masks.w2, &masks.w3 );
+	monty_lanes_one_hot( fl1, fl2, &masks.f1, &masks.f2, &masks.f3 );
+	masks.coin = coin;
+	masks.player = player;
+	monty_lanes_resolve( &masks, monty_lanes_valid( games ), strategy, p_totals );
+}
+
+__attribute__((target("avx512f,popcnt")))
+static void monty_kernel_run_avx512( const monty_draw_block *p_block, uint32_t games,
+									SIM_STRATEGY strategy, monty_stats *p_totals )
+{
+	const __m512i limit1 = _mm512_set1_epi32( (int)MONTY_DOOR1_LIMIT );
+	const __m512i limit2 = _mm512_set1_epi32( (int)MONTY_DOOR2_LIMIT );
+	const __m512i one = _mm512_set1_epi32( 1 );
+	uint64_t wl1 = 0, wl2 = 0, fl1 = 0, fl2 = 0, coin = 0, player = 0;
+	monty_lane_masks masks;
+
+	for( uint32_t i = 0; i < MONTY_KERNEL_LANES; i += 16 )
+	{
+		__m512i w = _mm512_loadu_si512( &p_block->winning[i] );
+		__m512i f = _mm512_loadu_si512( &p_block->first[i] );
+		__m512i c = _mm512_loadu_si512( &p_block->coin[i] );
+		__m512i p = _mm512_loadu_si512( &p_block->player[i] );
+
+		// AVX-512 compares produce lane masks directly
+		wl1    |= (uint64_t)_mm512_cmple_epu32_mask( w, limit1 ) << i;
+		wl2    |= (uint64_t)_mm512_cmple_epu32_mask( w, limit2 ) << i;
+		fl1    |= (uint64_t)_mm512_cmple_epu32_mask( f, limit1 ) << i;
+		fl2    |= (uint64_t)_mm512_cmple_epu32_mask( f, limit2 ) << i;
+		coin   |= (uint64_t)_mm512_test_epi32_mask( c, one ) << i;
+		player |= (uint64_t)_mm512_test_epi32_mask( p, one ) << i;
+	}
+	monty_lanes_one_hot( wl1, wl2, &masks.w1, &masks.w2, &masks.w3 );
+	monty_lanes_one_hot( fl1, fl2, &masks.f1, &masks.f2, &masks.f3 );
+	masks.coin = coin;
+	masks.player = player;
+	monty_lanes_resolve( &masks, monty_lanes_valid( games ), strategy, p_totals );
+}
+#endif
+
+/** \brief resolves MONTY_KERNEL_AUTO and kernels the CPU can't run
+ *
+ * \param kernel - requested kernel
+ * \returns the kernel that will be used
+ */
+MONTY_KERNEL monty_kernel_select( MONTY_KERNEL kernel )
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	int has_avx512 = __builtin_cpu_supports( "avx512f" );
+	int has_avx2 = __builtin_cpu_supports( "avx2" );
+#else
+	int has_avx512 = 0;
+	int has_avx2 = 0;
+#endif
+
+	if( (kernel == MONTY_KERNEL_AUTO) || (kernel == MONTY_KERNEL_AVX512) )
+	{
+		kernel = has_avx512 ? MONTY_KERNEL_AVX512 : MONTY_KERNEL_AVX2;
+	}
+	if( kernel == MONTY_KERNEL_AVX2 )
+	{
+		kernel = has_avx2 ? MONTY_KERNEL_AVX2 : MONTY_KERNEL_BITSLICE;
+	}
+	return kernel;
+}
+
+/** \brief printable kernel name */
+const char *monty_kernel_name( MONTY_KERNEL kernel )
+{
+	switch( kernel )
+	{
+		case MONTY_KERNEL_SCALAR:
+			return "scalar";
+		case MONTY_KERNEL_BITSLICE:
+			return "bitslice";
+		case MONTY_KERNEL_AVX2:
+			return "avx2";
+		case MONTY_KERNEL_AVX512:
+			return "avx512";
+		default:
+		case MONTY_KERNEL_AUTO:
+			return "auto";
+	}
+}
+
+/** \brief parses a kernel name
+ *
+ * \returns 0 if the name is known, -1 otherwise
+ */
+int monty_kernel_parse( const char *p_name, MONTY_KERNEL *p_kernel )
+{
+	for( MONTY_KERNEL kernel = MONTY_KERNEL_AUTO; kernel <= MONTY_KERNEL_AVX512; ++kernel )
+	{
+		if( strcmp( p_name, monty_kernel_name( kernel ) ) == 0 )
+		{
+			*p_kernel = kernel;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/** \brief plays the first games of a block
+ *
+ * \param kernel - kernel to use, as returned by monty_kernel_select()
+ * \param p_block - draws for the block
+ * \param games - number of games in the block, at most MONTY_KERNEL_LANES
+ * \param strategy - player strategy
+ * \param p_totals - totals to add the results to
+ */
+void monty_kernel_run( MONTY_KERNEL kernel, const monty_draw_block *p_block, uint32_t games,
+						SIM_STRATEGY strategy, monty_stats *p_totals )
+{
+	switch( kernel )
+	{
+		case MONTY_KERNEL_SCALAR:
+			monty_kernel_run_scalar( p_block, games, strategy, p_totals );
+			break;
+#if defined(__x86_64__) || defined(__i386__)
+		case MONTY_KERNEL_AVX2:
+			monty_kernel_run_avx2( p_block, games, strategy, p_totals );
+			break;
+		case MONTY_KERNEL_AVX512:
+			monty_kernel_run_avx512( p_block, games, strategy, p_totals );
+			break;
+#endif
+		default:
+		case MONTY_KERNEL_BITSLICE:
+			monty_kernel_run_bitslice( p_block, games, strategy, p_totals );
+			break;
+	}
+}
@@ -0,0 +1,53 @@
+/**
+ * \file
+ *
+ * \brief Batch game kernels for the host simulator
+ *
+ * Games are played in blocks of MONTY_KERNEL_LANES. Every game in a block gets
+ * its own set of random draws, so a block can either be fed press by press
+ * through handle_current_game_update() (the scalar reference) or resolved all
+ * at once by one of the lane parallel kernels. All kernels produce the same
+ * counters for the same block.
+ *
+ */
+
+#ifndef MONTY_KERNEL_H_INCLUDED
+#define MONTY_KERNEL_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_sim.h"
+#include "prng.h"
+
+/** \brief games per block, one bit per game in the bit-sliced masks */
+#define MONTY_KERNEL_LANES 64
+
+/** \brief random draws for one block of games, one array per draw so SIMD loads are contiguous */
+typedef struct
+{
+	uint32_t winning[MONTY_KERNEL_LANES]; /**< Prize door, mapped by monty_hall_random_door() */
+	uint32_t coin[MONTY_KERNEL_LANES];    /**< Monty's coin toss when he has a choice, bit 0 */
+	uint32_t first[MONTY_KERNEL_LANES];   /**< Player's first door, mapped by monty_hall_random_door() */
+	uint32_t player[MONTY_KERNEL_LANES];  /**< Player's coin toss for SIM_STRATEGY_RANDOM, bit 0 */
+} monty_draw_block;
+
+/** \brief available game kernels */
+typedef enum
+{
+	MONTY_KERNEL_AUTO,     /**< Fastest kernel the CPU supports */
+	MONTY_KERNEL_SCALAR,   /**< Press by press through handle_current_game_update() */
+	MONTY_KERNEL_BITSLICE, /**< Portable C, 64 games per uint64_t */
+	MONTY_KERNEL_AVX2,     /**< Bit-sliced, draws packed 8 lanes at a time with AVX2 */
+	MONTY_KERNEL_AVX512    /**< Bit-sliced, draws packed 16 lanes at a time with AVX-512 */
+} MONTY_KERNEL;
+
+void monty_kernel_fill( monty_draw_block *p_block, const prng_stream *p_stream, uint64_t first_game );
+
+MONTY_KERNEL monty_kernel_select( MONTY_KERNEL kernel );
+const char *monty_kernel_name( MONTY_KERNEL kernel );
+int monty_kernel_parse( const char *p_name, MONTY_KERNEL *p_kernel );
+
+void monty_kernel_run( MONTY_KERNEL kernel, const monty_draw_block *p_block, uint32_t games,
+						SIM_STRATEGY strategy, monty_stats *p_totals );
+
+#endif /* MONTY_KERNEL_H_INCLUDED */
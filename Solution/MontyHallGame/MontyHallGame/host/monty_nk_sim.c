@@ -0,0 +1,63 @@
+/**
+ * \file
+ *
+ * \brief Host simulation of the N door / K reveal game
+ *
+ * Games are played press by press through monty_nk_game_update(). Each game
+ * has its own stream, so a range of games can be played on any thread and
+ * gives the same result.
+ *
+ */
+
+#include "host_rand.h"
+#include "monty_nk_sim.h"
+
+/** \brief picks one of the closed doors other than the player's first door */
+static uint32_t monty_nk_sim_switch_door( const monty_nk_state *p_game_state, prng_stream *p_stream )
+{
+	monty_door_set closed = monty_door_all( p_game_state->rules.door_count ) &
+							~p_game_state->open_doors & ~monty_door_bit( p_game_state->first_door );
+	uint32_t index = monty_nk_random_index( prng_next_u32( p_stream ), monty_door_count( closed ) );
+	return (uint32_t)__builtin_ctzll( monty_door_select( closed, index ) ) + 1;
+}
+
+/** \brief plays a range of N door games
+ *
+ * \param p_rules - game rules
+ * \param seed - run seed
+ * \param first_game - index of the first game to play
+ * \param games - number of games to play
+ * \param strategy - player strategy, switching goes to a random other closed door
+ * \param p_totals - totals to add the results to
+ */
+void monty_nk_sim_run( const monty_nk_rules *p_rules, uint64_t seed, uint64_t first_game, uint64_t games,
+						SIM_STRATEGY strategy, monty_stats *p_totals )
+{
+	monty_nk_state game_state;
+	prng_stream stream;
+
+	monty_nk_init( &game_state, p_rules->door_count, p_rules->reveal_count );
+	host_rand_set_stream( &stream );
+
+	for( uint64_t game = first_game; game < first_game + games; ++game )
+	{
+		prng_init( &stream, seed, MONTY_NK_SIM_STREAM + game );
+
+		uint32_t first_door = monty_nk_random_index( prng_next_u32( &stream ), p_rules->door_count ) + 1;
+		uint32_t second_door = first_door;
+
+		monty_nk_game_update( &game_state, first_door );
+		if( (strategy == SIM_STRATEGY_SWITCH) ||
+			((strategy == SIM_STRATEGY_RANDOM) && (prng_next_u32( &stream ) & 0x1)) )
+		{
+			second_door = monty_nk_sim_switch_door( &game_state, &stream );
+		}
+		monty_nk_game_update( &game_state, second_door );
+
+		// Any press on the game over screen starts the next game
+		monty_nk_game_update( &game_state, first_door );
+	}
+	host_rand_set_stream( NULL );
+
+	monty_stats_merge( p_totals, &game_state.stats );
+}
@@ -0,0 +1,22 @@
+/**
+ * \file
+ *
+ * \brief Host simulation of the N door / K reveal game
+ *
+ */
+
+#ifndef MONTY_NK_SIM_H_INCLUDED
+#define MONTY_NK_SIM_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_nk.h"
+#include "monty_sim.h"
+
+/** \brief N door game n draws sequentially from stream MONTY_NK_SIM_STREAM + n of the run's seed */
+#define MONTY_NK_SIM_STREAM (1ull << 63)
+
+void monty_nk_sim_run( const monty_nk_rules *p_rules, uint64_t seed, uint64_t first_game, uint64_t games,
+						SIM_STRATEGY strategy, monty_stats *p_totals );
+
+#endif /* MONTY_NK_SIM_H_INCLUDED */
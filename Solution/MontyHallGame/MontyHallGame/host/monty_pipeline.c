@@ -0,0 +1,409 @@
+/**
+ * \file
+ *
+ * \brief Replays recorded button presses through the game and display code
+ *
+ * Reads the REC/RECD lines a board prints when its recording is full (see
+ * monty_record.h, CONF_MONTY_HALL_RECORD_EVENTS) from a UART capture, or
+ * records a synthetic session with -g, and replays the presses through
+ * monty_ui_press() with the draws recorded for them. The display is the host
+ * model of the SSD1306 (ssd1306_mock.h) under the ASF driver, so the replay
+ * runs the same game, UART, drawing and driver code as the board at full speed.
+ *
+ * It prints the hash of the UART lines, which has to match the board's REPLAY
+ * line for the same recording, the hash of the final display RAM, the bus
+ * bytes per press and the time per press. With -a the screen is flushed in
+ * the background through the model of the SPI PDC (monty_flush.h), as on the
+ * board, with the given microseconds of main loop between presses (0 for
+ * back to back presses); screens that find the bus busy go out later, merged
+ * with the next, and the final display has to come out the same. Every iteration has to come out
+ * with the same hashes, and a synthetic session has to replay to the hashes it
+ * was recorded with.
+ *
+ * Usage: monty_pipeline [-d doors] [-r reveals] [-i iterations] [-c presses] [-a us] [-v] [file]
+ *        monty_pipeline -g presses [-S seed] [-d doors] [-r reveals] [-i iterations] [-a us] [-p] [-v]
+ *
+ *   ./monty_pipeline capture.txt       (REC lines, anything else in the file is skipped)
+ *   ./monty_pipeline -g 100000 -i 10
+ *   ./monty_pipeline -g 100000 -a 200
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "monty_record.h"
+#include "monty_ui.h"
+#include "prng.h"
+#include "ssd1306.h"
+
+/** \brief longest capture line looked at */
+#define PIPELINE_LINE_LENGTH 512
+
+/** \brief draws kept per recorded press, enough for the largest N door game */
+#define PIPELINE_DRAWS_PER_PRESS MONTY_NK_MAX_DOORS
+
+/** \brief core clock of the board, for synthetic press time stamps */
+#define PIPELINE_CPU_HZ 120000000u
+
+/** \brief session being replayed */
+static monty_recording g_recording;
+
+/** \brief draws while recording a synthetic session, NULL while replaying */
+static prng_stream *gp_live_stream;
+
+/** \brief background flush of the replays with -a */
+static monty_flush g_flush;
+
+/** \brief random source for the game core: recorded draws, or new ones while recording */
+uint32_t monty_hall_rand( void )
+{
+	if( gp_live_stream != NULL )
+	{
+		uint32_t value = prng_next_u32( gp_live_stream );
+		monty_record_draw( &g_recording, value );
+		return value;
+	}
+	return monty_record_next_draw( &g_recording );
+}
+
+/** \brief where the UART lines of a run go */
+typedef struct
+{
+	uint32_t hash;
+	uint32_t lines;
+	uint32_t echo;       /**< Print the lines as well */
+} pipeline_uart;
+
+static void pipeline_print( void *p_context, const char *p_line )
+{
+	pipeline_uart *p_uart = p_context;
+	p_uart->hash = monty_record_hash( p_uart->hash, p_line );
+	p_uart->lines++;
+	if( p_uart->echo )
+	{
+		puts( p_line );
+	}
+}
+
+/** \brief result of one run of the pipeline */
+typedef struct
+{
+	uint32_t uart_hash;
+	uint32_t uart_lines;
+	uint32_t display_hash;
+	uint64_t ns;
+	uint32_t deferred;   /**< Presses whose screen found the bus busy */
+} pipeline_run;
+
+static uint64_t pipeline_ns( void )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/** \brief SPI interrupt of the controller model */
+static void pipeline_spi_interrupt( void *p_context )
+{
+	monty_flush_interrupt( p_context );
+}
+
+/** \brief runs the recorded presses through a new game, as record_dump_and_replay() does on the board
+ *
+ * \param p_ui - game to use
+ * \param door_count - doors of the recorded game
+ * \param reveal_count - doors Monty opened in the recorded game
+ * \param echo - print the UART lines
+ * \param async - flush in the background, as the board's main loop does
+ * \param gap_ns - modelled time between presses with async
+ * \param p_run - hashes and time of the run
+ */
+static void pipeline_replay( monty_ui *p_ui, uint32_t door_count, uint32_t reveal_count, uint32_t echo,
+							uint32_t async, uint64_t gap_ns, pipeline_run *p_run )
+{
+	pipeline_uart uart = { MONTY_RECORD_HASH_START, 0, echo };
+
+	ssd1306_mock_reset();
+	monty_ui_init( p_ui, door_count, reveal_count, pipeline_print, &uart, NULL );
+	monty_record_rewind( &g_recording );
+	p_run->deferred = 0;
+	if( async )
+	{
+		monty_flush_init( &g_flush, NULL, NULL );
+		ssd1306_mock_spi_irq( pipeline_spi_interrupt, &g_flush );
+		monty_ui_flush_async( p_ui, &g_flush );
+	}
+
+	uint64_t start = pipeline_ns();
+	ssd1306_clear();
+	monty_ui_start( p_ui );
+	for( uint32_t event = 0; event < g_recording.event_count; ++event )
+	{
+		if( async )
+		{
+			// The main loop goes round while the bus works
+			ssd1306_mock_spi_run( gap_ns );
+			monty_ui_flush( p_ui );
+			p_run->deferred += monty_flush_busy( &g_flush );
+		}
+		monty_ui_press( p_ui, g_recording.p_events[event].button );
+	}
+	while( async && !ssd1306_mock_spi_idle() )
+	{
+		ssd1306_mock_spi_run( UINT64_MAX );
+		monty_ui_flush( p_ui );
+	}
+	p_run->ns = pipeline_ns() - start;
+	p_run->uart_hash = uart.hash;
+	p_run->uart_lines = uart.lines;
+	p_run->display_hash = ssd1306_mock_hash();
+}
+
+/** \brief plays a synthetic session with random presses and records it
+ *
+ * \param p_ui - game to use
+ * \param door_count - doors of the game
+ * \param reveal_count - doors Monty opens
+ * \param presses - button presses to record
+ * \param seed - presses come from stream 1 of the seed, the game's draws from stream 0
+ * \param p_run - hashes of the recorded session
+ */
+static void pipeline_record( monty_ui *p_ui, uint32_t door_count, uint32_t reveal_count, uint32_t presses,
+							uint64_t seed, pipeline_run *p_run )
+{
+	pipeline_uart uart = { MONTY_RECORD_HASH_START, 0, 0 };
+	prng_stream press_stream, draw_stream;
+	prng_init( &press_stream, seed, 1 );
+	prng_init( &draw_stream, seed, 0 );
+
+	ssd1306_mock_reset();
+	monty_ui_init( p_ui, door_count, reveal_count, pipeline_print, &uart, NULL );
+	gp_live_stream = &draw_stream;
+	ssd1306_clear();
+	monty_ui_start( p_ui );
+
+	// A press every 0.25 to 1.25 seconds
+	uint32_t cycles = 0;
+	for( uint32_t press = 0; press < presses; ++press )
+	{
+		uint32_t value = prng_next_u32( &press_stream );
+		uint32_t button = DOOR_PRESSED_MIN + (uint32_t)(((uint64_t)(value >> 16) * 3) >> 16);
+		cycles += PIPELINE_CPU_HZ / 4 + (uint32_t)(((uint64_t)(value & 0xFFFF) * PIPELINE_CPU_HZ) >> 16);
+		if( monty_record_press( &g_recording, cycles, button ) != 0 )
+		{
+			break;
+		}
+		monty_ui_press( p_ui, button );
+	}
+	gp_live_stream = NULL;
+
+	p_run->uart_hash = uart.hash;
+	p_run->uart_lines = uart.lines;
+	p_run->display_hash = ssd1306_mock_hash();
+	p_run->ns = 0;
+}
+
+/** \brief reads the REC/RECD lines of a capture
+ *
+ * \returns 0 if everything is okay, -1 when the capture does not fit or is garbled
+ */
+static int32_t pipeline_load( FILE *p_file )
+{
+	char line[PIPELINE_LINE_LENGTH];
+	while( fgets( line, sizeof(line), p_file ) != NULL )
+	{
+		if( monty_record_parse_line( &g_recording, line ) != 0 )
+		{
+			return -1;
+		}
+	}
+
+	// Every press has to have all the draws its REC line announced
+	uint32_t draws = 0;
+	for( uint32_t event = 0; event < g_recording.event_count; ++event )
+	{
+		draws += g_recording.p_events[event].draw_count;
+	}
+	return (draws == g_recording.draw_count) ? 0 : -1;
+}
+
+static void pipeline_usage( const char *p_name )
+{
+	fprintf( stderr, "usage: %s [-d doors] [-r reveals] [-i iterations] [-c presses] [-a us] [-v] [file]\n"
+					 "       %s -g presses [-S seed] [-d doors] [-r reveals] [-i iterations] [-a us] [-p] [-v]\n",
+					 p_name, p_name );
+}
+
+int main( int argc, char **argv )
+{
+	uint32_t door_count = 3;
+	uint32_t reveal_count = 1;
+	uint32_t iterations = 1;
+	uint32_t capacity = 65536;
+	uint32_t generate = 0;
+	uint32_t print_recording = 0;
+	uint32_t echo = 0;
+	uint64_t seed = 1;
+	uint32_t async = 0;
+	uint64_t gap_ns = 0;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "d:r:i:c:g:S:a:pvh" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'a':
+				async = 1;
+				gap_ns = (uint64_t)(strtod( optarg, NULL ) * 1000.0);
+				break;
+			case 'd':
+				door_count = (uint32_t)strtoul( optarg, NULL, 0 );
+				break;
+			case 'r':
+				reveal_count = (uint32_t)strtoul( optarg, NULL, 0 );
+				break;
+			case 'i':
+				iterations = (uint32_t)strtoul( optarg, NULL, 0 );
+				break;
+			case 'c':
+				capacity = (uint32_t)strtoul( optarg, NULL, 0 );
+				break;
+			case 'g':
+				generate = (uint32_t)strtod( optarg, NULL );
+				break;
+			case 'S':
+				seed = strtoull( optarg, NULL, 0 );
+				break;
+			case 'p':
+				print_recording = 1;
+				break;
+			case 'v':
+				echo = 1;
+				break;
+			default:
+				pipeline_usage( argv[0] );
+				return 1;
+		}
+	}
+	if( (iterations == 0) || (capacity == 0) || ((generate == 0) && (argc - optind > 1)) )
+	{
+		pipeline_usage( argv[0] );
+		return 1;
+	}
+
+	static monty_ui ui;
+	if( monty_ui_init( &ui, door_count, reveal_count, pipeline_print, NULL, NULL ) != 0 )
+	{
+		fprintf( stderr, "invalid game: %u doors, %u reveals\n", door_count, reveal_count );
+		return 1;
+	}
+
+	capacity = (generate != 0) ? generate : capacity;
+	monty_record_event *p_events = malloc( (size_t)capacity * sizeof(*p_events) );
+	uint32_t *p_draws = malloc( (size_t)capacity * PIPELINE_DRAWS_PER_PRESS * sizeof(*p_draws) );
+	if( (p_events == NULL) || (p_draws == NULL) )
+	{
+		fprintf( stderr, "out of memory\n" );
+		return 1;
+	}
+	monty_record_init( &g_recording, p_events, capacity, p_draws, capacity * PIPELINE_DRAWS_PER_PRESS );
+
+	pipeline_run recorded = { 0, 0, 0, 0, 0 };
+	if( generate != 0 )
+	{
+		pipeline_record( &ui, door_count, reveal_count, generate, seed, &recorded );
+		if( g_recording.overflow != 0 )
+		{
+			fprintf( stderr, "recording full after %u presses\n", g_recording.event_count );
+			return 1;
+		}
+		if( print_recording )
+		{
+			char line[16 + 9 * MONTY_RECORD_DRAWS_PER_LINE];
+			for( uint32_t event = 0; event < g_recording.event_count; ++event )
+			{
+				for( uint32_t n = 0; monty_record_format( &g_recording, event, n, line ); ++n )
+				{
+					puts( line );
+				}
+			}
+		}
+	}
+	else
+	{
+		FILE *p_file = (optind < argc) ? fopen( argv[optind], "r" ) : stdin;
+		if( p_file == NULL )
+		{
+			perror( argv[optind] );
+			return 1;
+		}
+		if( pipeline_load( p_file ) != 0 )
+		{
+			fprintf( stderr, "capture does not fit (-c) or has presses with missing draws\n" );
+			return 1;
+		}
+		if( p_file != stdin )
+		{
+			fclose( p_file );
+		}
+	}
+	if( g_recording.event_count == 0 )
+	{
+		fprintf( stderr, "no presses recorded\n" );
+		return 1;
+	}
+
+	pipeline_run first = { 0, 0, 0, 0, 0 };
+	uint64_t best_ns = UINT64_MAX;
+	uint64_t total_ns = 0;
+	int result = 0;
+	for( uint32_t iteration = 0; iteration < iterations; ++iteration )
+	{
+		pipeline_run run;
+		pipeline_replay( &ui, door_count, reveal_count, echo && (iteration == 0), async, gap_ns, &run );
+		if( iteration == 0 )
+		{
+			first = run;
+		}
+		else if( (run.uart_hash != first.uart_hash) || (run.display_hash != first.display_hash) )
+		{
+			fprintf( stderr, "iteration %u: hashes differ from the first replay\n", iteration );
+			result = 1;
+		}
+		best_ns = (run.ns < best_ns) ? run.ns : best_ns;
+		total_ns += run.ns;
+	}
+	if( g_recording.overflow != 0 )
+	{
+		fprintf( stderr, "the replay took more draws than were recorded\n" );
+		result = 1;
+	}
+	if( (generate != 0) && ((first.uart_hash != recorded.uart_hash) || (first.display_hash != recorded.display_hash)) )
+	{
+		fprintf( stderr, "replay differs from the recorded session: uart %08x/%08x display %08x/%08x\n",
+				 first.uart_hash, recorded.uart_hash, first.display_hash, recorded.display_hash );
+		result = 1;
+	}
+
+	// Bus traffic is the same on every replay, the last one is still in the model
+	double presses = (double)g_recording.event_count;
+	fprintf( stderr, "%u presses, %u draws, %u doors, %u reveals\n",
+			 g_recording.event_count, g_recording.draw_count, door_count, reveal_count );
+	fprintf( stderr, "uart hash %08x (%u lines), display hash %08x\n",
+			 first.uart_hash, first.uart_lines, first.display_hash );
+	fprintf( stderr, "bus per press: %.1f commands, %.1f data, %.1f transfers, %.1f us on the board\n",
+			 (double)g_ssd1306_mock.commands / presses, (double)g_ssd1306_mock.data / presses,
+			 (double)g_ssd1306_mock.transfers / presses, (double)g_ssd1306_mock.bus_ns / presses / 1000.0 );
+	if( async )
+	{
+		fprintf( stderr, "background flush: %u of %u presses found the bus busy, %u bytes without chip select\n",
+				 first.deferred, g_recording.event_count, g_ssd1306_mock.errors );
+	}
+	fprintf( stderr, "%u iterations: %.1f ns/press best, %.1f mean\n", iterations,
+			 (double)best_ns / presses, (double)total_ns / presses / iterations );
+	return result;
+}
@@ -0,0 +1,151 @@
+/**
+ * \file
+ *
+ * \brief Checks of the Philox4x32-10 generator and the batch kernels' copy of it
+ *
+ * First checks prng_philox4x32_10() against the known answer vectors of
+ * Random123 (kat_vectors, philox4x32 with 10 rounds), straight and through
+ * prng_block_at() and prng_next_u32() with the key and counter those take
+ * from the seed, stream id and block. Then checks that monty_kernel_fill(),
+ * which runs the same rounds over all lanes of a block, gives every lane the
+ * block prng_block_at() gives for its game, for a few keys, streams and
+ * first games, including blocks across the 2^32 boundary of the counter.
+ *
+ * Usage: monty_prng_test
+ *
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "monty_kernel.h"
+#include "prng.h"
+
+/** \brief one known answer vector */
+typedef struct
+{
+	uint32_t counter[4];
+	uint32_t key[2];
+	uint32_t expected[PRNG_BLOCK_WORDS];
+} test_vector;
+
+/** \brief Random123 kat_vectors, philox4x32 10 */
+static const test_vector g_vectors[] = {
+	{ { 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u }, { 0x00000000u, 0x00000000u },
+	  { 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u } },
+	{ { 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu }, { 0xffffffffu, 0xffffffffu },
+	  { 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu } },
+	{ { 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u }, { 0xa4093822u, 0x299f31d0u },
+	  { 0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u } }
+};
+
+#define TEST_VECTORS (sizeof(g_vectors) / sizeof(g_vectors[0]))
+
+/** \brief counts the words of a block that differ from the expected ones */
+static uint32_t test_compare( const uint32_t p_block[PRNG_BLOCK_WORDS], const uint32_t p_expected[PRNG_BLOCK_WORDS] )
+{
+	uint32_t errors = 0;
+
+	for( uint32_t i = 0; i < PRNG_BLOCK_WORDS; ++i )
+	{
+		errors += p_block[i] != p_expected[i];
+	}
+	return errors;
+}
+
+/** \brief checks the block function and the stream against the known answers
+ *
+ * \returns non-zero on a mismatch
+ */
+static int test_known_answers( void )
+{
+	uint32_t errors = 0;
+
+	for( uint32_t v = 0; v < TEST_VECTORS; ++v )
+	{
+		const test_vector *p_vector = &g_vectors[v];
+		uint32_t block[PRNG_BLOCK_WORDS];
+
+		for( uint32_t i = 0; i < PRNG_BLOCK_WORDS; ++i )
+		{
+			block[i] = p_vector->counter[i];
+		}
+		prng_philox4x32_10( p_vector->key, block );
+		errors += test_compare( block, p_vector->expected );
+
+		// The same counter as block and stream id of a stream keyed by the seed
+		prng_stream stream;
+		uint64_t seed = ((uint64_t)p_vector->key[1] << 32) | p_vector->key[0];
+		uint64_t stream_id = ((uint64_t)p_vector->counter[3] << 32) | p_vector->counter[2];
+		uint64_t block_index = ((uint64_t)p_vector->counter[1] << 32) | p_vector->counter[0];
+
+		prng_init( &stream, seed, stream_id );
+		prng_block_at( &stream, block_index, block );
+		errors += test_compare( block, p_vector->expected );
+
+		if( block_index == 0 )
+		{
+			for( uint32_t i = 0; i < PRNG_BLOCK_WORDS; ++i )
+			{
+				block[i] = prng_next_u32( &stream );
+			}
+			errors += test_compare( block, p_vector->expected );
+		}
+	}
+	printf( "Philox4x32-10 known answers (Random123): %s\n", errors ? "FAIL" : "ok" );
+	return errors != 0;
+}
+
+/** \brief checks the lanes of monty_kernel_fill() against prng_block_at()
+ *
+ * \returns non-zero on a mismatch
+ */
+static int test_kernel_fill( void )
+{
+	static const uint64_t seeds[] = { 0, 1, 0x0123456789ABCDEFull, UINT64_MAX };
+	static const uint64_t streams[] = { 0, 7, 0xFEDCBA9876543210ull, UINT64_MAX };
+	static const uint64_t first_games[] = {
+		0, MONTY_KERNEL_LANES, 123456789, 0xFFFFFFFFull - MONTY_KERNEL_LANES / 2, UINT64_MAX - MONTY_KERNEL_LANES + 1
+	};
+	uint64_t blocks = 0;
+	uint64_t errors = 0;
+
+	for( uint32_t s = 0; s < sizeof(seeds) / sizeof(seeds[0]); ++s )
+	{
+		for( uint32_t t = 0; t < sizeof(streams) / sizeof(streams[0]); ++t )
+		{
+			prng_stream stream;
+			prng_init( &stream, seeds[s], streams[t] );
+
+			for( uint32_t g = 0; g < sizeof(first_games) / sizeof(first_games[0]); ++g )
+			{
+				monty_draw_block lanes;
+				monty_kernel_fill( &lanes, &stream, first_games[g] );
+
+				for( uint32_t i = 0; i < MONTY_KERNEL_LANES; ++i )
+				{
+					uint32_t expected[PRNG_BLOCK_WORDS];
+					uint32_t block[PRNG_BLOCK_WORDS] = {
+						lanes.winning[i], lanes.coin[i], lanes.first[i], lanes.player[i]
+					};
+
+					prng_block_at( &stream, first_games[g] + i, expected );
+					errors += test_compare( block, expected ) != 0;
+					blocks++;
+				}
+			}
+		}
+	}
+	printf( "monty_kernel_fill() lanes against prng_block_at(): %" PRIu64 " of %" PRIu64 " blocks differ%s\n",
+			errors, blocks, errors ? "  FAIL" : "" );
+	return errors != 0;
+}
+
+int main( void )
+{
+	int failed = test_known_answers();
+	failed |= test_kernel_fill();
+
+	printf( "%s\n", failed ? "FAILED" : "all tests passed" );
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,604 @@
+/**
+ * \file
+ *
+ * \brief Rebuilds the game counters from recorded game logs
+ *
+ * Reads binary logs of 16 bit records (see monty_log.h, e.g. the flash log
+ * read back from a board) or UART text logs as written by print_uart(), and
+ * recomputes the monty_hall_state counters over all of them. Each file is
+ * memory mapped (or read with pread() with -R) and split into one byte range
+ * per thread.
+ *
+ * Binary records are independent and go straight through monty_log_replay().
+ * A text log only says whether each game was won ("Won:"/"Lost:" lines); a
+ * game switched when the "Switch Count" of its "Games Played:" line is one
+ * more than on the line before (or 1 on the first game after a reset). Every
+ * thread resolves the games of its range and leaves the first "Games Played:"
+ * line to be resolved against the last one of the range before, after the
+ * threads have joined. Games that cannot be resolved (truncated or garbled
+ * logs) are reported and not counted.
+ *
+ * With -g it writes a synthetic log of the given number of games instead, for
+ * benchmarking, and prints the counters the replay has to arrive at.
+ *
+ * Usage: monty_replay [-f binary|text] [-t threads] [-R] file...
+ *        monty_replay -g file -n games [-f binary|text] [-S seed]
+ *
+ *   ./monty_replay -g big.log -n 1e9 && ./monty_replay big.log
+ *
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "monty_hall.h"
+#include "monty_log.h"
+#include "prng.h"
+
+/** \brief bytes read at a time with -R */
+#define REPLAY_READ_BYTES (1u << 20)
+
+/** \brief records replayed per monty_log_replay() call */
+#define REPLAY_BLOCK_RECORDS (1u << 20)
+
+/** \brief longest text line looked at, longer ones are skipped */
+#define REPLAY_LINE_LENGTH 512
+
+/** \brief games per simulated power on in a synthetic text log */
+#define REPLAY_UNIT_GAMES 100000
+
+/** \brief state of a text range that is not known yet */
+#define REPLAY_UNKNOWN -1
+
+/** \brief what one thread found in its range of a text log */
+typedef struct
+{
+	monty_stats stats;        /**< Games resolved within the range */
+	uint64_t lines;
+	uint64_t unresolved;      /**< Games that could not be resolved */
+	int32_t pending_won;      /**< Won/lost line not followed by its "Games Played:" line yet */
+	int32_t has_played;       /**< Range has a "Games Played:" line */
+	uint64_t first_games;     /**< First "Games Played:" line of the range */
+	uint64_t first_switches;
+	int32_t first_won;        /**< Won/lost line before it in the range, REPLAY_UNKNOWN for none */
+	uint64_t last_games;      /**< Last "Games Played:" line of the range */
+	uint64_t last_switches;
+} replay_text;
+
+/** \brief per thread work item */
+typedef struct
+{
+	pthread_t thread;
+	int fd;
+	const uint8_t *p_map;     /**< Whole file, NULL when reading with pread() */
+	uint64_t begin;           /**< Byte range of this thread */
+	uint64_t end;
+	uint64_t size;            /**< File size */
+	int text;
+	monty_stats stats;        /**< Binary logs: result */
+	uint64_t invalid;         /**< Binary logs: records that were not valid */
+	replay_text text_result;  /**< Text logs: result */
+} replay_worker;
+
+/** \brief parses a decimal number, advancing the pointer */
+static int replay_number( const char **pp_text, const char *p_end, uint64_t *p_value )
+{
+	const char *p = *pp_text;
+	uint64_t value = 0;
+
+	if( (p == p_end) || (*p < '0') || (*p > '9') )
+	{
+		return -1;
+	}
+	while( (p < p_end) && (*p >= '0') && (*p <= '9') )
+	{
+		value = value * 10 + (uint64_t)(*p++ - '0');
+	}
+	*pp_text = p;
+	*p_value = value;
+	return 0;
+}
+
+/** \brief non-zero when the line starts with the prefix */
+static int replay_prefix( const char *p_line, size_t length, const char *p_prefix, size_t prefix_length )
+{
+	return (length >= prefix_length) && (memcmp( p_line, p_prefix, prefix_length ) == 0);
+}
+
+/** \brief counts one game of a text log, switched derived from the previous "Games Played:" line */
+static void replay_text_game( replay_text *p_text, int32_t won, uint64_t games, uint64_t switches,
+							int has_previous, uint64_t previous_games, uint64_t previous_switches )
+{
+	uint64_t switched;
+
+	if( games == 1 )
+	{
+		switched = switches;
+	}
+	else if( has_previous && (games == previous_games + 1) && (switches >= previous_switches) )
+	{
+		switched = switches - previous_switches;
+	}
+	else
+	{
+		switched = 2;
+	}
+
+	if( (won == REPLAY_UNKNOWN) || (switched > 1) )
+	{
+		p_text->unresolved++;
+		return;
+	}
+	p_text->stats.number_of_games++;
+	p_text->stats.times_won += (uint64_t)won;
+	p_text->stats.times_switched += switched;
+	p_text->stats.times_switched_won += (uint64_t)won & switched;
+}
+
+/** \brief one line of a text log */
+static void replay_text_line( replay_text *p_text, const char *p_line, size_t length )
+{
+	static const char won_line[] = "Won: ";
+	static const char lost_line[] = "Lost: ";
+	static const char played_line[] = "Games Played: ";
+	static const char switch_count[] = ", Switch Count ";
+	const char *p_end = p_line + length;
+
+	p_text->lines++;
+	if( replay_prefix( p_line, length, won_line, sizeof(won_line) - 1 ) )
+	{
+		p_text->pending_won = 1;
+		return;
+	}
+	if( replay_prefix( p_line, length, lost_line, sizeof(lost_line) - 1 ) )
+	{
+		p_text->pending_won = 0;
+		return;
+	}
+	if( !replay_prefix( p_line, length, played_line, sizeof(played_line) - 1 ) )
+	{
+		return;
+	}
+
+	uint64_t games, switches;
+	const char *p = p_line + sizeof(played_line) - 1;
+	if( (replay_number( &p, p_end, &games ) != 0) ||
+		((size_t)(p_end - p) < sizeof(switch_count) - 1) || (memcmp( p, switch_count, sizeof(switch_count) - 1 ) != 0) )
+	{
+		return;
+	}
+	p += sizeof(switch_count) - 1;
+	if( replay_number( &p, p_end, &switches ) != 0 )
+	{
+		return;
+	}
+
+	if( !p_text->has_played )
+	{
+		// Resolved against the range before once all threads are done
+		p_text->has_played = 1;
+		p_text->first_games = games;
+		p_text->first_switches = switches;
+		p_text->first_won = p_text->pending_won;
+	}
+	else
+	{
+		replay_text_game( p_text, p_text->pending_won, games, switches, 1, p_text->last_games, p_text->last_switches );
+	}
+	p_text->last_games = games;
+	p_text->last_switches = switches;
+	p_text->pending_won = REPLAY_UNKNOWN;
+}
+
+/** \brief text lines starting in [begin, end) of a block that starts at file offset base
+ *
+ * \returns bytes used, the rest is an incomplete last line unless at_eof
+ */
+static size_t replay_text_block( replay_text *p_text, const char *p_block, size_t length, uint64_t base,
+								uint64_t begin, uint64_t end, int at_eof, int *p_done )
+{
+	size_t start = 0;
+
+	while( start < length )
+	{
+		if( base + start >= end )
+		{
+			*p_done = 1;
+			return start;
+		}
+		const char *p_newline = memchr( p_block + start, '\n', length - start );
+		if( (p_newline == NULL) && !at_eof )
+		{
+			return start;
+		}
+		size_t stop = (p_newline != NULL) ? (size_t)(p_newline - p_block) : length;
+		size_t line_length = stop - start;
+		if( (line_length > 0) && (p_block[stop - 1] == '\r') )
+		{
+			line_length--;
+		}
+		// A range only takes lines that start in it, the one running into it belongs to the range before
+		if( base + start >= begin )
+		{
+			replay_text_line( p_text, p_block + start, line_length );
+		}
+		start = stop + 1;
+	}
+	return length;
+}
+
+/** \brief worker thread, replays its byte range */
+static void *replay_worker_main( void *p_arg )
+{
+	replay_worker *p_worker = (replay_worker *)p_arg;
+	replay_text *p_text = &p_worker->text_result;
+	int done = 0;
+
+	p_text->pending_won = REPLAY_UNKNOWN;
+	p_text->first_won = REPLAY_UNKNOWN;
+
+	if( p_worker->p_map != NULL )
+	{
+		if( !p_worker->text )
+		{
+			const monty_log_record *p_records = (const monty_log_record *)(p_worker->p_map + p_worker->begin);
+			uint64_t count = (p_worker->end - p_worker->begin) / sizeof(monty_log_record);
+			for( uint64_t i = 0; i < count; i += REPLAY_BLOCK_RECORDS )
+			{
+				uint32_t block = (count - i < REPLAY_BLOCK_RECORDS) ? (uint32_t)(count - i) : REPLAY_BLOCK_RECORDS;
+				p_worker->invalid += monty_log_replay( p_records + i, block, &p_worker->stats );
+			}
+			return NULL;
+		}
+		// Start one byte early, so a line starting right at begin is told from one running into it
+		uint64_t base = (p_worker->begin > 0) ? p_worker->begin - 1 : 0;
+		uint64_t length = p_worker->end + REPLAY_LINE_LENGTH - base;
+		length = (base + length > p_worker->size) ? p_worker->size - base : length;
+		replay_text_block( p_text, (const char *)p_worker->p_map + base, length, base, p_worker->begin,
+							p_worker->end, base + length == p_worker->size, &done );
+		return NULL;
+	}
+
+	uint8_t *p_buffer = malloc( REPLAY_READ_BYTES );
+	if( p_buffer == NULL )
+	{
+		return NULL;
+	}
+	uint64_t position = (p_worker->text && (p_worker->begin > 0)) ? p_worker->begin - 1 : p_worker->begin;
+	uint64_t base = position;
+	size_t kept = 0;
+	while( !done )
+	{
+		size_t wanted = REPLAY_READ_BYTES - kept;
+		if( !p_worker->text && (position + wanted > p_worker->end) )
+		{
+			wanted = (size_t)(p_worker->end - position);
+		}
+		ssize_t got = pread( p_worker->fd, p_buffer + kept, wanted, (off_t)position );
+		got = (got < 0) ? 0 : got;
+		position += (uint64_t)got;
+
+		if( !p_worker->text )
+		{
+			p_worker->invalid += monty_log_replay( (const monty_log_record *)p_buffer,
+												(uint32_t)((size_t)got / sizeof(monty_log_record)), &p_worker->stats );
+			done = (got == 0) || (position >= p_worker->end);
+			continue;
+		}
+
+		size_t length = kept + (size_t)got;
+		size_t used = replay_text_block( p_text, (const char *)p_buffer, length, base,
+										p_worker->begin, p_worker->end, got == 0, &done );
+		done |= (got == 0);
+		if( (used == 0) && (length == REPLAY_READ_BYTES) )
+		{
+			// A line longer than the buffer, skip it
+			used = length;
+		}
+		// Keep the incomplete last line for the next read
+		kept = length - used;
+		memmove( p_buffer, p_buffer + used, kept );
+		base += used;
+	}
+	free( p_buffer );
+	return NULL;
+}
+
+/** \brief resolves the first game of every text range against the range before and sums them */
+static void replay_text_merge( replay_worker *p_workers, long threads, monty_stats *p_totals, uint64_t *p_unresolved,
+								uint64_t *p_lines )
+{
+	replay_text carry;
+	memset( &carry, 0, sizeof(carry) );
+	carry.pending_won = REPLAY_UNKNOWN;
+
+	for( long i = 0; i < threads; ++i )
+	{
+		replay_text *p_text = &p_workers[i].text_result;
+
+		if( p_text->has_played )
+		{
+			int32_t won = (p_text->first_won != REPLAY_UNKNOWN) ? p_text->first_won : carry.pending_won;
+			replay_text_game( p_text, won, p_text->first_games, p_text->first_switches,
+							carry.has_played, carry.last_games, carry.last_switches );
+			carry.has_played = 1;
+			carry.last_games = p_text->last_games;
+			carry.last_switches = p_text->last_switches;
+			carry.pending_won = p_text->pending_won;
+		}
+		else if( p_text->pending_won != REPLAY_UNKNOWN )
+		{
+			carry.pending_won = p_text->pending_won;
+		}
+		monty_stats_merge( p_totals, &p_text->stats );
+		*p_unresolved += p_text->unresolved;
+		*p_lines += p_text->lines;
+	}
+}
+
+/** \brief replays one file on all threads
+ *
+ * \returns 0 if everything is okay, -1 when the file could not be read
+ */
+static int replay_file( const char *p_path, int text, long threads, int use_read, monty_stats *p_totals,
+						uint64_t *p_invalid, uint64_t *p_lines, uint64_t *p_bytes )
+{
+	int fd = open( p_path, O_RDONLY );
+	struct stat info;
+	if( (fd < 0) || (fstat( fd, &info ) != 0) )
+	{
+		fprintf( stderr, "cannot open %s\n", p_path );
+		return -1;
+	}
+
+	uint64_t size = (uint64_t)info.st_size;
+	const uint8_t *p_map = NULL;
+	if( !use_read && (size > 0) )
+	{
+		p_map = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if( p_map == MAP_FAILED )
+		{
+			fprintf( stderr, "cannot map %s\n", p_path );
+			close( fd );
+			return -1;
+		}
+		madvise( (void *)p_map, size, MADV_SEQUENTIAL | MADV_WILLNEED );
+	}
+
+	replay_worker *p_workers = calloc( (size_t)threads, sizeof(replay_worker) );
+	if( p_workers == NULL )
+	{
+		return -1;
+	}
+
+	// Binary ranges are whole records, text ranges are cut anywhere and fixed up at line starts
+	uint64_t unit = text ? 1 : sizeof(monty_log_record);
+	uint64_t units = size / unit;
+	uint64_t next = 0;
+	for( long i = 0; i < threads; ++i )
+	{
+		p_workers[i].fd = fd;
+		p_workers[i].p_map = p_map;
+		p_workers[i].size = size;
+		p_workers[i].text = text;
+		p_workers[i].begin = next * unit;
+		next += units / (uint64_t)threads + (((uint64_t)i < units % (uint64_t)threads) ? 1 : 0);
+		p_workers[i].end = next * unit;
+		if( pthread_create( &p_workers[i].thread, NULL, replay_worker_main, &p_workers[i] ) != 0 )
+		{
+			fprintf( stderr, "failed to start worker %ld\n", i );
+			return -1;
+		}
+	}
+	for( long i = 0; i < threads; ++i )
+	{
+		pthread_join( p_workers[i].thread, NULL );
+		monty_stats_merge( p_totals, &p_workers[i].stats );
+		*p_invalid += p_workers[i].invalid;
+	}
+	if( text )
+	{
+		replay_text_merge( p_workers, threads, p_totals, p_invalid, p_lines );
+	}
+	else
+	{
+		*p_lines += units;
+	}
+	*p_bytes += size;
+
+	free( p_workers );
+	if( p_map != NULL )
+	{
+		munmap( (void *)p_map, size );
+	}
+	close( fd );
+	return 0;
+}
+
+/** \brief prints counters in the format of the board's statistics line */
+static void replay_print_stats( const monty_stats *p_stats )
+{
+	printf( "Games Played: %" PRIu64 ", Switch Count %" PRIu64 ", Games Win %" PRIu32 "%%, Switch Win %" PRIu32 "%% Stay Win %" PRIu32 "%%\n",
+			p_stats->number_of_games,
+			p_stats->times_switched,
+			monty_stats_percent( p_stats->times_won, p_stats->number_of_games ),
+			monty_stats_percent( p_stats->times_switched_won, p_stats->times_switched ),
+			monty_stats_percent( monty_stats_stayed_won( p_stats ), monty_stats_stayed( p_stats ) ) );
+	printf( "Won %" PRIu64 ", Switched Won %" PRIu64 "\n", p_stats->times_won, p_stats->times_switched_won );
+}
+
+/** \brief synthetic game n: random prize and first door, Monty's coin and a random switch */
+static monty_log_record replay_synthetic_game( const prng_stream *p_stream, uint64_t game )
+{
+	uint32_t words[PRNG_BLOCK_WORDS];
+	prng_block_at( p_stream, game, words );
+
+	uint32_t winning_door = monty_hall_random_door( words[0] );
+	uint32_t first_door = monty_hall_random_door( words[1] );
+	uint32_t open_door = pick_open_door_coin( winning_door, first_door, words[2] );
+	uint32_t final_door = (words[3] & 1) ? (6 - first_door - open_door) : first_door;
+	return monty_log_encode( first_door, open_door, final_door, winning_door );
+}
+
+/** \brief writes a synthetic log and prints the counters it holds
+ *
+ * \returns 0 if everything is okay, -1 when the file could not be written
+ */
+static int replay_generate( const char *p_path, uint64_t games, int text, uint64_t seed )
+{
+	FILE *p_file = fopen( p_path, "wb" );
+	if( p_file == NULL )
+	{
+		fprintf( stderr, "cannot create %s\n", p_path );
+		return -1;
+	}
+	setvbuf( p_file, NULL, _IOFBF, REPLAY_READ_BYTES );
+
+	prng_stream stream;
+	prng_init( &stream, seed, 0 );
+	monty_stats totals = { 0, 0, 0, 0 };
+	monty_stats unit = { 0, 0, 0, 0 };
+	monty_log_record block[4096];
+	uint32_t filled = 0;
+
+	for( uint64_t game = 0; game < games; ++game )
+	{
+		monty_log_record record = replay_synthetic_game( &stream, game );
+		monty_log_count( &totals, record );
+		if( !text )
+		{
+			block[filled++] = record;
+			if( (filled == sizeof(block) / sizeof(block[0])) || (game + 1 == games) )
+			{
+				fwrite( block, sizeof(record), filled, p_file );
+				filled = 0;
+			}
+			continue;
+		}
+
+		// The lines print_uart() sends for one game
+		monty_log_game played;
+		monty_log_decode( record, &played );
+		if( (game % REPLAY_UNIT_GAMES) == 0 )
+		{
+			monty_stats_clear( &unit );
+			fputs( "Press a button to select a door\n", p_file );
+		}
+		monty_log_count( &unit, record );
+		fprintf( p_file, "Game State 1: selected door %u open door %u\n", played.first_door, played.open_door );
+		fprintf( p_file, "%s: Game State %u: selected door %u open door %u\n", played.won ? "Won" : "Lost",
+				played.won ? GAME_OVER_WON : GAME_OVER_LOST, played.first_door, played.open_door );
+		fprintf( p_file, "Games Played: %lu, Switch Count %lu, Games Win %u%%, Switch Win %u%% Stay Win %u%%\n",
+				(unsigned long)unit.number_of_games, (unsigned long)unit.times_switched,
+				monty_stats_percent( unit.times_won, unit.number_of_games ),
+				monty_stats_percent( unit.times_switched_won, unit.times_switched ),
+				monty_stats_percent( monty_stats_stayed_won( &unit ), monty_stats_stayed( &unit ) ) );
+		fputs( "Press a button to play again\nPress a button to select a door\n", p_file );
+	}
+
+	if( fclose( p_file ) != 0 )
+	{
+		fprintf( stderr, "cannot write %s\n", p_path );
+		return -1;
+	}
+	printf( "wrote %" PRIu64 " games to %s\n", games, p_path );
+	replay_print_stats( &totals );
+	return 0;
+}
+
+static void replay_usage( const char *p_name )
+{
+	fprintf( stderr, "usage: %s [-f binary|text] [-t threads] [-R] file...\n"
+					 "       %s -g file -n games [-f binary|text] [-S seed]\n", p_name, p_name );
+}
+
+int main( int argc, char **argv )
+{
+	long threads = sysconf( _SC_NPROCESSORS_ONLN );
+	const char *p_generate = NULL;
+	uint64_t games = 0;
+	uint64_t seed = 1;
+	int text = 0;
+	int use_read = 0;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "f:t:Rg:n:S:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'f':
+				if( strcmp( optarg, "text" ) == 0 )
+				{
+					text = 1;
+				}
+				else if( strcmp( optarg, "binary" ) != 0 )
+				{
+					replay_usage( argv[0] );
+					return 1;
+				}
+				break;
+			case 't':
+				threads = strtol( optarg, NULL, 0 );
+				break;
+			case 'R':
+				use_read = 1;
+				break;
+			case 'g':
+				p_generate = optarg;
+				break;
+			case 'n':
+				games = (uint64_t)strtod( optarg, NULL );
+				break;
+			case 'S':
+				seed = strtoull( optarg, NULL, 0 );
+				break;
+			default:
+				replay_usage( argv[0] );
+				return 1;
+		}
+	}
+
+	if( p_generate != NULL )
+	{
+		return (replay_generate( p_generate, games, text, seed ) == 0) ? 0 : 1;
+	}
+	if( optind == argc )
+	{
+		replay_usage( argv[0] );
+		return 1;
+	}
+	threads = (threads > 0) ? threads : 1;
+
+	monty_stats totals = { 0, 0, 0, 0 };
+	uint64_t invalid = 0;
+	uint64_t lines = 0;
+	uint64_t bytes = 0;
+	struct timespec start, stop;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+	for( int i = optind; i < argc; ++i )
+	{
+		if( replay_file( argv[i], text, threads, use_read, &totals, &invalid, &lines, &bytes ) != 0 )
+		{
+			return 1;
+		}
+	}
+	clock_gettime( CLOCK_MONOTONIC, &stop );
+	double seconds = (double)(stop.tv_sec - start.tv_sec) + (double)(stop.tv_nsec - start.tv_nsec) * 1e-9;
+
+	replay_print_stats( &totals );
+	printf( "%" PRIu64 " %s, %" PRIu64 " %s\n", lines, text ? "lines" : "records", invalid,
+			text ? "games unresolved" : "records not valid" );
+	printf( "%s, %ld threads, %.3f s, %.2f GB/s, %.0f games/s\n", use_read ? "pread" : "mmap", threads, seconds,
+			(seconds > 0.0) ? (double)bytes / seconds * 1e-9 : 0.0,
+			(seconds > 0.0) ? (double)totals.number_of_games / seconds : 0.0 );
+	return 0;
+}
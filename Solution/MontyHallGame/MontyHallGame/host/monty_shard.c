@@ -0,0 +1,433 @@
+/**
+ * \file
+ *
+ * \brief Runs a simulation campaign in worker processes, one per NUMA node
+ *
+ * The campaign's game stream (the one monty_sim plays) is cut into shards of
+ * consecutive blocks. Blocks draw from their own positions of the counter based
+ * stream, so shards never share draws and the merged counters are exactly the
+ * ones monty_sim prints for the same settings.
+ *
+ * The coordinator forks one worker process per NUMA node (from
+ * /sys/devices/system/node, or a single node with all CPUs). Each worker pins
+ * itself to its node's CPUs before it allocates anything, so its memory is
+ * allocated on the node, and plays the shards it takes from a shared counter
+ * on a thread per CPU (see monty_batch.h). Every shard's counters and time go
+ * to its own slot in an anonymous shared mapping; the coordinator merges the
+ * slots once the workers have exited. Shards a failed worker left unfinished
+ * are played by the coordinator itself.
+ *
+ * Usage: monty_shard [-n games] [-s switch|stay|random] [-S seed] [-k kernel]
+ *                    [-d doors] [-r reveals] [-p processes] [-t threads] [-x shards]
+ *
+ *   ./monty_shard -n 1e12 -s random
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "monty_batch.h"
+
+/** \brief most NUMA nodes looked for */
+#define SHARD_MAX_NODES 64
+
+/** \brief shards per worker process when -x is not given, so fast workers take over from slow ones */
+#define SHARD_PER_PROCESS 16
+
+/** \brief CPUs of a NUMA node */
+typedef struct
+{
+	int id;
+	cpu_set_t cpus;
+} shard_node;
+
+/** \brief result of one shard, written by the worker that played it */
+typedef struct
+{
+	monty_stats totals;
+	uint64_t ns;             /**< Time the worker took for it */
+	uint32_t worker;
+	uint32_t done;           /**< Set last, once the rest of the slot is written */
+} shard_slot;
+
+/** \brief shared between the coordinator and the workers */
+typedef struct
+{
+	uint64_t next_shard;     /**< Next shard to take, taken with an atomic add */
+	shard_slot slots[];
+} shard_board;
+
+/** \brief what the shards are played with */
+typedef struct
+{
+	uint64_t seed;
+	uint64_t games;
+	uint64_t blocks;
+	uint64_t shards;
+	SIM_STRATEGY strategy;
+	MONTY_KERNEL kernel;
+	monty_nk_rules rules;
+	int classic;
+} shard_campaign;
+
+static uint64_t shard_ns( void )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/** \brief parses a cpulist such as "0-3,8-11" */
+static void shard_parse_cpulist( const char *p_text, cpu_set_t *p_cpus )
+{
+	CPU_ZERO( p_cpus );
+	while( *p_text != '\0' )
+	{
+		char *p_end;
+		long first = strtol( p_text, &p_end, 10 );
+		if( p_end == p_text )
+		{
+			break;
+		}
+		long last = first;
+		if( *p_end == '-' )
+		{
+			p_text = p_end + 1;
+			last = strtol( p_text, &p_end, 10 );
+		}
+		for( long cpu = first; (cpu <= last) && (cpu < CPU_SETSIZE); ++cpu )
+		{
+			CPU_SET( cpu, p_cpus );
+		}
+		p_text = (*p_end == ',') ? p_end + 1 : p_end + (*p_end != '\0');
+	}
+}
+
+/** \brief finds the NUMA nodes with CPUs this process may run on
+ *
+ * \returns the number of nodes, at least 1
+ */
+static int shard_find_nodes( shard_node *p_nodes )
+{
+	cpu_set_t allowed;
+	int count = 0;
+
+	sched_getaffinity( 0, sizeof(allowed), &allowed );
+	for( int id = 0; (id < 1024) && (count < SHARD_MAX_NODES); ++id )
+	{
+		char path[64];
+		char text[1024];
+		snprintf( path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id );
+		FILE *p_file = fopen( path, "r" );
+		if( p_file == NULL )
+		{
+			continue;
+		}
+		if( fgets( text, sizeof(text), p_file ) != NULL )
+		{
+			shard_parse_cpulist( text, &p_nodes[count].cpus );
+			CPU_AND( &p_nodes[count].cpus, &p_nodes[count].cpus, &allowed );
+			if( CPU_COUNT( &p_nodes[count].cpus ) > 0 )
+			{
+				p_nodes[count++].id = id;
+			}
+		}
+		fclose( p_file );
+	}
+	if( count == 0 )
+	{
+		p_nodes[0].id = 0;
+		p_nodes[0].cpus = allowed;
+		count = 1;
+	}
+	return count;
+}
+
+/** \brief first block and number of blocks of a shard, the remainder is spread over the first shards */
+static void shard_range( const shard_campaign *p_campaign, uint64_t shard, uint64_t *p_first, uint64_t *p_count )
+{
+	uint64_t per_shard = p_campaign->blocks / p_campaign->shards;
+	uint64_t remainder = p_campaign->blocks % p_campaign->shards;
+	*p_first = shard * per_shard + ((shard < remainder) ? shard : remainder);
+	*p_count = per_shard + ((shard < remainder) ? 1 : 0);
+}
+
+/** \brief sets up the threads that play the shards */
+static void shard_setup( monty_batch_worker *p_workers, long threads, const shard_campaign *p_campaign,
+						const prng_stream *p_stream )
+{
+	for( long i = 0; i < threads; ++i )
+	{
+		p_workers[i].games = p_campaign->games;
+		p_workers[i].p_stream = p_stream;
+		p_workers[i].p_rules = p_campaign->classic ? NULL : &p_campaign->rules;
+		p_workers[i].seed = p_campaign->seed;
+		p_workers[i].strategy = p_campaign->strategy;
+		p_workers[i].kernel = p_campaign->kernel;
+		p_workers[i].verify = 0;
+	}
+}
+
+/** \brief plays one shard into its slot
+ *
+ * \returns 0 if everything is okay, -1 when threads could not be started
+ */
+static int shard_play_one( monty_batch_worker *p_workers, long threads, const shard_campaign *p_campaign,
+							uint64_t shard, shard_slot *p_slot, uint32_t worker )
+{
+	uint64_t first, count;
+	shard_range( p_campaign, shard, &first, &count );
+
+	monty_stats totals = { 0, 0, 0, 0 };
+	monty_stats unused = { 0, 0, 0, 0 };
+	uint64_t start = shard_ns();
+	if( monty_batch_play( p_workers, threads, first, count, &totals, &unused ) != 0 )
+	{
+		return -1;
+	}
+	p_slot->totals = totals;
+	p_slot->ns = shard_ns() - start;
+	p_slot->worker = worker;
+	__atomic_store_n( &p_slot->done, 1, __ATOMIC_RELEASE );
+	return 0;
+}
+
+/** \brief worker process, plays shards from the board until none are left
+ *
+ * \param p_board - shared shard counter and result slots
+ * \param p_campaign - campaign settings
+ * \param worker - worker number, recorded in the slots
+ * \param threads - threads to play each shard on
+ * \returns 0 if everything is okay, -1 when threads could not be started
+ */
+static int shard_worker( shard_board *p_board, const shard_campaign *p_campaign, uint32_t worker, long threads )
+{
+	monty_batch_worker *p_workers = calloc( (size_t)threads, sizeof(monty_batch_worker) );
+	if( p_workers == NULL )
+	{
+		return -1;
+	}
+	prng_stream stream;
+	prng_init( &stream, p_campaign->seed, 0 );
+	shard_setup( p_workers, threads, p_campaign, &stream );
+
+	int result = 0;
+	for( ;; )
+	{
+		uint64_t shard = __atomic_fetch_add( &p_board->next_shard, 1, __ATOMIC_RELAXED );
+		if( (shard >= p_campaign->shards) ||
+			((result = shard_play_one( p_workers, threads, p_campaign, shard, &p_board->slots[shard], worker )) != 0) )
+		{
+			break;
+		}
+	}
+	free( p_workers );
+	return result;
+}
+
+static void shard_usage( const char *p_name )
+{
+	fprintf( stderr, "usage: %s [-n games] [-s switch|stay|random] [-S seed] [-k kernel]\n"
+					 "       [-d doors] [-r reveals] [-p processes] [-t threads] [-x shards]\n", p_name );
+}
+
+int main( int argc, char **argv )
+{
+	shard_campaign campaign = { 1, 10000000, 0, 0, SIM_STRATEGY_SWITCH, MONTY_KERNEL_AUTO, { 3, 1 }, 1 };
+	long processes = 0;
+	long threads = 0;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "n:s:S:k:d:r:p:t:x:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'n':
+				campaign.games = (uint64_t)strtod( optarg, NULL );
+				break;
+			case 's':
+				if( strcmp( optarg, "switch" ) == 0 )
+				{
+					campaign.strategy = SIM_STRATEGY_SWITCH;
+				}
+				else if( strcmp( optarg, "stay" ) == 0 )
+				{
+					campaign.strategy = SIM_STRATEGY_STAY;
+				}
+				else if( strcmp( optarg, "random" ) == 0 )
+				{
+					campaign.strategy = SIM_STRATEGY_RANDOM;
+				}
+				else
+				{
+					fprintf( stderr, "unknown strategy '%s'\n", optarg );
+					return 1;
+				}
+				break;
+			case 'S':
+				campaign.seed = strtoull( optarg, NULL, 0 );
+				break;
+			case 'k':
+				if( monty_kernel_parse( optarg, &campaign.kernel ) != 0 )
+				{
+					fprintf( stderr, "unknown kernel '%s'\n", optarg );
+					return 1;
+				}
+				break;
+			case 'd':
+				campaign.rules.door_count = (uint32_t)strtoul( optarg, NULL, 10 );
+				break;
+			case 'r':
+				campaign.rules.reveal_count = (uint32_t)strtoul( optarg, NULL, 10 );
+				break;
+			case 'p':
+				processes = strtol( optarg, NULL, 10 );
+				break;
+			case 't':
+				threads = strtol( optarg, NULL, 10 );
+				break;
+			case 'x':
+				campaign.shards = strtoull( optarg, NULL, 0 );
+				break;
+			default:
+				shard_usage( argv[0] );
+				return 1;
+		}
+	}
+
+	monty_nk_state check;
+	if( monty_nk_init( &check, campaign.rules.door_count, campaign.rules.reveal_count ) != 0 )
+	{
+		fprintf( stderr, "invalid rules: %u doors, %u revealed\n", campaign.rules.door_count, campaign.rules.reveal_count );
+		return 1;
+	}
+	campaign.classic = (campaign.rules.door_count == 3) && (campaign.rules.reveal_count == 1);
+	campaign.kernel = monty_kernel_select( campaign.classic ? campaign.kernel : MONTY_KERNEL_SCALAR );
+
+	static shard_node nodes[SHARD_MAX_NODES];
+	int node_count = shard_find_nodes( nodes );
+	processes = (processes > 0) ? processes : node_count;
+	campaign.blocks = (campaign.games + MONTY_KERNEL_LANES - 1) / MONTY_KERNEL_LANES;
+	campaign.shards = (campaign.shards > 0) ? campaign.shards : (uint64_t)processes * SHARD_PER_PROCESS;
+	campaign.shards = (campaign.shards < campaign.blocks) ? campaign.shards : campaign.blocks;
+	campaign.shards = (campaign.shards > 0) ? campaign.shards : 1;
+
+	size_t board_bytes = sizeof(shard_board) + campaign.shards * sizeof(shard_slot);
+	shard_board *p_board = mmap( NULL, board_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+	if( p_board == MAP_FAILED )
+	{
+		perror( "mmap" );
+		return 1;
+	}
+
+	pid_t *p_pids = calloc( (size_t)processes, sizeof(pid_t) );
+	if( p_pids == NULL )
+	{
+		return 1;
+	}
+	fflush( stdout );
+	uint64_t start = shard_ns();
+	for( long worker = 0; worker < processes; ++worker )
+	{
+		const shard_node *p_node = &nodes[worker % node_count];
+		p_pids[worker] = fork();
+		if( p_pids[worker] < 0 )
+		{
+			perror( "fork" );
+			break;
+		}
+		if( p_pids[worker] == 0 )
+		{
+			// Pin first, so the worker's memory is allocated on its node
+			sched_setaffinity( 0, sizeof(p_node->cpus), &p_node->cpus );
+			long worker_threads = (threads > 0) ? threads : CPU_COUNT( &p_node->cpus );
+			_exit( (shard_worker( p_board, &campaign, (uint32_t)worker, worker_threads ) == 0) ? 0 : 1 );
+		}
+	}
+
+	for( long worker = 0; worker < processes; ++worker )
+	{
+		int status;
+		if( (p_pids[worker] > 0) && ((waitpid( p_pids[worker], &status, 0 ) < 0) || !WIFEXITED( status ) ||
+									(WEXITSTATUS( status ) != 0)) )
+		{
+			fprintf( stderr, "worker %ld failed\n", worker );
+		}
+	}
+
+	// Whatever a failed worker left is played here, on all CPUs
+	uint64_t replayed = 0;
+	long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+	monty_batch_worker *p_workers = calloc( (size_t)cpus, sizeof(monty_batch_worker) );
+	prng_stream stream;
+	prng_init( &stream, campaign.seed, 0 );
+	if( p_workers == NULL )
+	{
+		return 1;
+	}
+	shard_setup( p_workers, cpus, &campaign, &stream );
+	for( uint64_t shard = 0; shard < campaign.shards; ++shard )
+	{
+		if( !__atomic_load_n( &p_board->slots[shard].done, __ATOMIC_ACQUIRE ) )
+		{
+			if( shard_play_one( p_workers, cpus, &campaign, shard, &p_board->slots[shard], (uint32_t)processes ) != 0 )
+			{
+				return 1;
+			}
+			replayed++;
+		}
+	}
+	free( p_workers );
+	double seconds = (double)(shard_ns() - start) * 1e-9;
+
+	monty_stats totals = { 0, 0, 0, 0 };
+	for( uint64_t shard = 0; shard < campaign.shards; ++shard )
+	{
+		monty_stats_merge( &totals, &p_board->slots[shard].totals );
+	}
+
+	printf( "Games Played: %" PRIu64 ", Switch Count %" PRIu64 ", Games Win %" PRIu32 "%%, Switch Win %" PRIu32 "%% Stay Win %" PRIu32 "%%\n",
+			totals.number_of_games,
+			totals.times_switched,
+			monty_stats_percent( totals.times_won, totals.number_of_games ),
+			monty_stats_percent( totals.times_switched_won, totals.times_switched ),
+			monty_stats_percent( monty_stats_stayed_won( &totals ), monty_stats_stayed( &totals ) ) );
+	printf( "Won %" PRIu64 ", Switched Won %" PRIu64 "\n", totals.times_won, totals.times_switched_won );
+	for( long worker = 0; worker < processes; ++worker )
+	{
+		uint64_t games = 0, ns = 0, shards = 0;
+		for( uint64_t shard = 0; shard < campaign.shards; ++shard )
+		{
+			if( p_board->slots[shard].worker == (uint32_t)worker )
+			{
+				games += p_board->slots[shard].totals.number_of_games;
+				ns += p_board->slots[shard].ns;
+				shards++;
+			}
+		}
+		printf( "worker %ld: node %d, %d cpus, %" PRIu64 " shards, %" PRIu64 " games, %.0f games/s\n", worker,
+				nodes[worker % node_count].id, CPU_COUNT( &nodes[worker % node_count].cpus ), shards, games,
+				(ns > 0) ? (double)games * 1e9 / (double)ns : 0.0 );
+	}
+	if( replayed != 0 )
+	{
+		printf( "%" PRIu64 " shards of failed workers played by the coordinator\n", replayed );
+	}
+	printf( "%s kernel, %ld processes on %d nodes, %" PRIu64 " shards, %.3f s, %.0f games/s\n",
+			monty_kernel_name( campaign.kernel ), processes, node_count, campaign.shards, seconds,
+			(seconds > 0.0) ? (double)totals.number_of_games / seconds : 0.0 );
+
+	munmap( p_board, board_bytes );
+	free( p_pids );
+	return 0;
+}
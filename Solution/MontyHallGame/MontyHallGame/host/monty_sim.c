@@ -0,0 +1,501 @@
+/**
+ * \file
+ *
+ * \brief Host side Monty Hall batch simulator
+ *
+ * Plays games with the same rules as pick_open_door() and handle_current_game_update()
+ * on the board and reports the statistics the OLED shows at the end of a game.
+ * The games form one stream (see monty_kernel_fill()) that is split into ranges of
+ * blocks, one per worker thread, so the result does not depend on the thread count
+ * or on the kernel used.
+ *
+ * Usage: monty_sim [-n games] [-t threads] [-s switch|stay|random] [-S seed]
+ *                  [-k auto|scalar|bitslice|avx2|avx512] [-V] [-d doors] [-r reveals]
+ *                  [-w half_width] [-P delta] [-a alpha] [-B batch]
+ *                  [-m plain|antithetic|stratified|crn] [-C checkpoint] [-I seconds]
+ *
+ * -V also plays every block through the scalar reference and checks that the
+ * counters are identical.
+ *
+ * -d and -r select the N door game in which Monty opens K doors. It is played
+ * press by press through monty_nk_game_update(); switching moves to a random
+ * other closed door.
+ *
+ * -w and -P stop the run early, -n becoming the maximum. The games are then
+ * played in batches of -B games (rounded to whole blocks) and the counters
+ * are checked after every batch. Batches are played in stream order, so an
+ * early stop still doesn't depend on the thread count.
+ *   -w stops once the 95% Wilson interval of every rate with games in it is
+ *      no wider than +-half_width (a fraction, 0.001 is +-0.1%).
+ *   -P runs Wald's SPRT (error rates -a) on how often switching beats staying:
+ *      in the three door game exactly one of the two wins every game, so H0
+ *      is "switching wins half the games" and H1 "switching wins 1/2 + delta".
+ *
+ * -m estimates the switch and stay win rates with one of the variance reduced
+ * modes in monty_vr.h instead, on a single thread, and reports the standard
+ * errors and effective sample sizes.
+ *
+ * -C saves the progress to a checkpoint file (see monty_checkpoint.h) every -I
+ * seconds, from a thread of its own while the workers play the next batch, and
+ * once more at the end. When the file already exists the run resumes from it;
+ * the settings have to be the campaign's. A resumed run ends with the same
+ * counters as one that was never interrupted.
+ *
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "monty_batch.h"
+#include "monty_checkpoint.h"
+#include "monty_kernel.h"
+#include "monty_sim.h"
+#include "monty_vr.h"
+
+/** \brief games between checkpoints when no stop rule sets the batch size */
+#define SIM_CHECKPOINT_BATCH_GAMES (1ull << 28)
+
+/** \brief early stopping settings */
+typedef struct
+{
+	double half_width;      /**< Target Wilson half width, 0 when not used */
+	double delta;           /**< SPRT indifference, 0 when not used */
+	monty_sprt sprt;        /**< Switch against stay test */
+	uint64_t batch_games;   /**< Games between checks */
+} sim_controller;
+
+/** \brief true once the rate's interval is narrow enough, or it has no games */
+static int sim_rate_settled( uint64_t successes, uint64_t trials, double half_width )
+{
+	monty_interval interval;
+	monty_stats_wilson( successes, trials, MONTY_STATS_Z95, &interval );
+	return (trials == 0) || (interval.upper - interval.lower <= 2.0 * half_width);
+}
+
+/** \brief checks the stop rules against the counters so far
+ *
+ * \returns non-zero when the run can stop
+ */
+static int sim_converged( const sim_controller *p_controller, const monty_stats *p_totals, MONTY_SPRT *p_decision )
+{
+	if( p_controller->delta > 0.0 )
+	{
+		// Games switching wins: switched and won, or stayed and lost
+		uint64_t switch_better = p_totals->times_switched_won +
+								(monty_stats_stayed( p_totals ) - monty_stats_stayed_won( p_totals ));
+		*p_decision = monty_sprt_check( &p_controller->sprt, switch_better, p_totals->number_of_games );
+		if( *p_decision != MONTY_SPRT_CONTINUE )
+		{
+			return 1;
+		}
+	}
+	if( p_controller->half_width > 0.0 )
+	{
+		return sim_rate_settled( p_totals->times_won, p_totals->number_of_games, p_controller->half_width ) &&
+				sim_rate_settled( p_totals->times_switched_won, p_totals->times_switched, p_controller->half_width ) &&
+				sim_rate_settled( monty_stats_stayed_won( p_totals ), monty_stats_stayed( p_totals ), p_controller->half_width );
+	}
+	return 0;
+}
+
+/** \brief parses a game count, accepting plain integers and forms like 1e10 */
+static int sim_parse_count( const char *p_text, uint64_t *p_count )
+{
+	char *p_end = NULL;
+	errno = 0;
+	uint64_t value = strtoull( p_text, &p_end, 10 );
+	if( (errno == 0) && (*p_end == '\0') )
+	{
+		*p_count = value;
+		return 0;
+	}
+	double real = strtod( p_text, &p_end );
+	if( (*p_end != '\0') || (real < 0.0) || (real > 1.8e19) )
+	{
+		return -1;
+	}
+	*p_count = (uint64_t)real;
+	return 0;
+}
+
+/** \brief prints a rate with its 95% Wilson and Clopper-Pearson intervals */
+static void sim_print_rate( const char *p_name, uint64_t successes, uint64_t trials )
+{
+	monty_interval wilson, exact;
+	monty_stats_wilson( successes, trials, MONTY_STATS_Z95, &wilson );
+	monty_stats_clopper_pearson( successes, trials, 0.05, &exact );
+
+	printf( "%-11s %9.5f%%  95%% CI Wilson [%.5f%%, %.5f%%] Clopper-Pearson [%.5f%%, %.5f%%]\n", p_name,
+			trials ? 100.0 * (double)successes / (double)trials : 0.0,
+			100.0 * wilson.lower, 100.0 * wilson.upper, 100.0 * exact.lower, 100.0 * exact.upper );
+}
+
+/** \brief prints one variance reduced estimate */
+static void sim_print_estimate( const char *p_name, const monty_vr_estimate *p_estimate, uint64_t games )
+{
+	printf( "%-11s %9.5f%%  se %.5f%%  ", p_name, 100.0 * p_estimate->estimate, 100.0 * sqrt( p_estimate->variance ) );
+	if( p_estimate->effective_games > 0.0 )
+	{
+		printf( "effective games %.4g (%.2fx)\n", p_estimate->effective_games, p_estimate->effective_games / (double)games );
+	}
+	else
+	{
+		printf( "exact, no variance left\n" );
+	}
+}
+
+/** \brief runs a variance reduced estimate and prints it */
+static int sim_run_vr( MONTY_VR_MODE mode, uint64_t seed, uint64_t games )
+{
+	monty_vr_result result;
+	struct timespec start, stop;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+	monty_vr_run( mode, seed, games, &result );
+	clock_gettime( CLOCK_MONOTONIC, &stop );
+	double seconds = (double)(stop.tv_sec - start.tv_sec) + (double)(stop.tv_nsec - start.tv_nsec) * 1e-9;
+
+	printf( "%s sampling, %" PRIu64 " games, %.3f s\n", monty_vr_name( mode ), result.games, seconds );
+	sim_print_estimate( "Switch win", &result.switching, result.games );
+	sim_print_estimate( "Stay win", &result.staying, result.games );
+	sim_print_estimate( "Difference", &result.difference, result.games );
+	return 0;
+}
+
+static void sim_usage( const char *p_name )
+{
+	fprintf( stderr, "usage: %s [-n games] [-t threads] [-s switch|stay|random] [-S seed]\n"
+					 "       [-k auto|scalar|bitslice|avx2|avx512] [-V] [-d doors] [-r reveals]\n"
+					 "       [-w half_width] [-P delta] [-a alpha] [-B batch]\n"
+					 "       [-m plain|antithetic|stratified|crn] [-C checkpoint] [-I seconds]\n", p_name );
+}
+
+int main( int argc, char **argv )
+{
+	uint64_t games = 10000000;
+	long threads = sysconf( _SC_NPROCESSORS_ONLN );
+	SIM_STRATEGY strategy = SIM_STRATEGY_SWITCH;
+	uint64_t seed = 1;
+	MONTY_KERNEL kernel = MONTY_KERNEL_AUTO;
+	int verify = 0;
+	monty_nk_rules rules = { 3, 1 };
+	sim_controller controller = { 0.0, 0.0, { 0.0, 0.0, 0.0, 0.0 }, 1 << 16 };
+	double alpha = 0.001;
+	int vr = 0;
+	MONTY_VR_MODE vr_mode = MONTY_VR_PLAIN;
+	const char *p_checkpoint_path = NULL;
+	double checkpoint_interval = 60.0;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "n:t:s:S:k:Vd:r:w:P:a:B:m:C:I:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'n':
+				if( sim_parse_count( optarg, &games ) != 0 )
+				{
+					fprintf( stderr, "invalid game count '%s'\n", optarg );
+					return 1;
+				}
+				break;
+			case 't':
+				threads = strtol( optarg, NULL, 10 );
+				break;
+			case 's':
+				if( strcmp( optarg, "switch" ) == 0 )
+				{
+					strategy = SIM_STRATEGY_SWITCH;
+				}
+				else if( strcmp( optarg, "stay" ) == 0 )
+				{
+					strategy = SIM_STRATEGY_STAY;
+				}
+				else if( strcmp( optarg, "random" ) == 0 )
+				{
+					strategy = SIM_STRATEGY_RANDOM;
+				}
+				else
+				{
+					fprintf( stderr, "unknown strategy '%s'\n", optarg );
+					return 1;
+				}
+				break;
+			case 'S':
+				seed = strtoull( optarg, NULL, 0 );
+				break;
+			case 'k':
+				if( monty_kernel_parse( optarg, &kernel ) != 0 )
+				{
+					fprintf( stderr, "unknown kernel '%s'\n", optarg );
+					return 1;
+				}
+				break;
+			case 'V':
+				verify = 1;
+				break;
+			case 'd':
+				rules.door_count = (uint32_t)strtoul( optarg, NULL, 10 );
+				break;
+			case 'r':
+				rules.reveal_count = (uint32_t)strtoul( optarg, NULL, 10 );
+				break;
+			case 'w':
+				controller.half_width = strtod( optarg, NULL );
+				break;
+			case 'P':
+				controller.delta = strtod( optarg, NULL );
+				break;
+			case 'a':
+				alpha = strtod( optarg, NULL );
+				break;
+			case 'B':
+				if( sim_parse_count( optarg, &controller.batch_games ) != 0 )
+				{
+					fprintf( stderr, "invalid batch size '%s'\n", optarg );
+					return 1;
+				}
+				break;
+			case 'm':
+				if( monty_vr_parse( optarg, &vr_mode ) != 0 )
+				{
+					fprintf( stderr, "unknown mode '%s'\n", optarg );
+					return 1;
+				}
+				vr = 1;
+				break;
+			case 'C':
+				p_checkpoint_path = optarg;
+				break;
+			case 'I':
+				checkpoint_interval = strtod( optarg, NULL );
+				break;
+			default:
+				sim_usage( argv[0] );
+				return 1;
+		}
+	}
+	if( threads < 1 )
+	{
+		threads = 1;
+	}
+	if( vr )
+	{
+		if( p_checkpoint_path != NULL )
+		{
+			fprintf( stderr, "-C does not work with -m\n" );
+			return 1;
+		}
+		return sim_run_vr( vr_mode, seed, games );
+	}
+
+	monty_nk_state check;
+	if( monty_nk_init( &check, rules.door_count, rules.reveal_count ) != 0 )
+	{
+		fprintf( stderr, "invalid rules: %u doors, %u revealed (need 3..%u doors, 1..doors-2 revealed)\n",
+				rules.door_count, rules.reveal_count, MONTY_NK_MAX_DOORS );
+		return 1;
+	}
+	int classic = (rules.door_count == 3) && (rules.reveal_count == 1);
+	if( !classic )
+	{
+		kernel = MONTY_KERNEL_SCALAR;
+		verify = 0;
+	}
+	kernel = monty_kernel_select( kernel );
+
+	if( (controller.delta > 0.0) && !classic )
+	{
+		fprintf( stderr, "-P needs the three door game\n" );
+		return 1;
+	}
+	if( (controller.delta >= 0.5) || (alpha <= 0.0) || (alpha >= 0.5) )
+	{
+		fprintf( stderr, "need delta below 0.5 and alpha between 0 and 0.5\n" );
+		return 1;
+	}
+	monty_sprt_init( &controller.sprt, 0.5, 0.5 + controller.delta, alpha, alpha );
+	int early_stop = (controller.half_width > 0.0) || (controller.delta > 0.0);
+
+	prng_stream stream;
+	prng_init( &stream, seed, 0 );
+
+	monty_batch_worker *p_workers = calloc( (size_t)threads, sizeof(monty_batch_worker) );
+	if( p_workers == NULL )
+	{
+		return 1;
+	}
+
+	struct timespec start, stop;
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for( long i = 0; i < threads; ++i )
+	{
+		p_workers[i].games = games;
+		p_workers[i].p_stream = &stream;
+		p_workers[i].p_rules = classic ? NULL : &rules;
+		p_workers[i].seed = seed;
+		p_workers[i].strategy = strategy;
+		p_workers[i].kernel = kernel;
+		p_workers[i].verify = verify;
+	}
+
+	uint64_t blocks = (games + MONTY_KERNEL_LANES - 1) / MONTY_KERNEL_LANES;
+	uint64_t batch_blocks = blocks;
+	if( early_stop )
+	{
+		batch_blocks = (controller.batch_games + MONTY_KERNEL_LANES - 1) / MONTY_KERNEL_LANES;
+	}
+	else if( p_checkpoint_path != NULL )
+	{
+		batch_blocks = SIM_CHECKPOINT_BATCH_GAMES / MONTY_KERNEL_LANES;
+	}
+	batch_blocks = (batch_blocks > 0) ? batch_blocks : 1;
+
+	monty_checkpoint checkpoint = { seed, games, batch_blocks, (uint32_t)strategy, rules.door_count, rules.reveal_count,
+									(uint32_t)verify, controller.half_width, controller.delta, alpha,
+									0, 0, { 0, 0, 0, 0 }, { 0, 0, 0, 0 } };
+	monty_checkpoint_writer writer;
+	if( p_checkpoint_path != NULL )
+	{
+		monty_checkpoint saved;
+		int result = monty_checkpoint_load( p_checkpoint_path, &saved );
+		if( result < 0 )
+		{
+			fprintf( stderr, "%s is not a valid checkpoint\n", p_checkpoint_path );
+			return 1;
+		}
+		if( (result == 0) && !monty_checkpoint_same_campaign( &saved, &checkpoint ) )
+		{
+			fprintf( stderr, "%s is a checkpoint of a different campaign (seed %" PRIu64 ", %" PRIu64 " games, %u doors)\n",
+					p_checkpoint_path, saved.seed, saved.games, saved.door_count );
+			return 1;
+		}
+		if( result == 0 )
+		{
+			checkpoint = saved;
+			printf( "resuming at %" PRIu64 " of %" PRIu64 " games\n", checkpoint.totals.number_of_games, games );
+		}
+		if( monty_checkpoint_writer_start( &writer, p_checkpoint_path ) != 0 )
+		{
+			fprintf( stderr, "failed to start the checkpoint writer\n" );
+			return 1;
+		}
+	}
+
+	uint64_t done = checkpoint.done_blocks;
+	monty_stats totals = checkpoint.totals;
+	monty_stats reference = checkpoint.reference;
+	uint64_t resumed_games = totals.number_of_games;
+	uint64_t resumed_ns = checkpoint.elapsed_ns;
+	MONTY_SPRT decision = MONTY_SPRT_CONTINUE;
+	int converged = (done > 0) && early_stop && sim_converged( &controller, &totals, &decision );
+	struct timespec last_checkpoint = start;
+
+	while( (done < blocks) && !converged )
+	{
+		uint64_t count = (blocks - done < batch_blocks) ? (blocks - done) : batch_blocks;
+		if( monty_batch_play( p_workers, threads, done, count, &totals, &reference ) != 0 )
+		{
+			return 1;
+		}
+		done += count;
+		converged = early_stop && sim_converged( &controller, &totals, &decision );
+
+		if( p_checkpoint_path != NULL )
+		{
+			clock_gettime( CLOCK_MONOTONIC, &stop );
+			if( (double)(stop.tv_sec - last_checkpoint.tv_sec) + (double)(stop.tv_nsec - last_checkpoint.tv_nsec) * 1e-9 >=
+				checkpoint_interval )
+			{
+				checkpoint.done_blocks = done;
+				checkpoint.elapsed_ns = resumed_ns + (uint64_t)(stop.tv_sec - start.tv_sec) * 1000000000u +
+										(uint64_t)(stop.tv_nsec - start.tv_nsec);
+				checkpoint.totals = totals;
+				checkpoint.reference = reference;
+				monty_checkpoint_writer_post( &writer, &checkpoint );
+				last_checkpoint = stop;
+			}
+		}
+	}
+
+	clock_gettime( CLOCK_MONOTONIC, &stop );
+	double seconds = (double)(stop.tv_sec - start.tv_sec) + (double)(stop.tv_nsec - start.tv_nsec) * 1e-9;
+
+	if( p_checkpoint_path != NULL )
+	{
+		checkpoint.done_blocks = done;
+		checkpoint.elapsed_ns = resumed_ns + (uint64_t)(seconds * 1e9);
+		checkpoint.totals = totals;
+		checkpoint.reference = reference;
+		monty_checkpoint_writer_post( &writer, &checkpoint );
+		uint32_t errors = monty_checkpoint_writer_stop( &writer );
+		if( errors != 0 )
+		{
+			fprintf( stderr, "%u checkpoints could not be written to %s\n", errors, p_checkpoint_path );
+		}
+	}
+
+	uint32_t win_pct = monty_stats_percent( totals.times_won, totals.number_of_games );
+	uint32_t switching_win_pct = monty_stats_percent( totals.times_switched_won, totals.times_switched );
+	uint32_t staying_win_pct = monty_stats_percent( monty_stats_stayed_won( &totals ), monty_stats_stayed( &totals ) );
+
+	printf( "Games Played: %" PRIu64 ", Switch Count %" PRIu64 ", Games Win %" PRIu32 "%%, Switch Win %" PRIu32 "%% Stay Win %" PRIu32 "%%\n",
+			totals.number_of_games,
+			totals.times_switched,
+			win_pct,
+			switching_win_pct,
+			staying_win_pct );
+	printf( "Won %" PRIu64 ", Switched Won %" PRIu64 "\n", totals.times_won, totals.times_switched_won );
+	sim_print_rate( "Games win", totals.times_won, totals.number_of_games );
+	sim_print_rate( "Switch win", totals.times_switched_won, totals.times_switched );
+	sim_print_rate( "Stay win", monty_stats_stayed_won( &totals ), monty_stats_stayed( &totals ) );
+	if( !classic )
+	{
+		printf( "%u doors, Monty opens %u\n", rules.door_count, rules.reveal_count );
+	}
+	printf( "%s kernel, %ld threads, %.3f s, %.0f games/s\n", monty_kernel_name( kernel ), threads, seconds,
+			(seconds > 0.0) ? (double)(totals.number_of_games - resumed_games) / seconds : 0.0 );
+	if( resumed_games != 0 )
+	{
+		printf( "resumed after %" PRIu64 " games, %.3f s over all sessions\n", resumed_games,
+				(double)checkpoint.elapsed_ns * 1e-9 );
+	}
+	if( decision != MONTY_SPRT_CONTINUE )
+	{
+		printf( "SPRT: %s (alpha = beta = %g)\n", (decision == MONTY_SPRT_ACCEPT_H1) ?
+				"switching beats staying" : "switching is no better than staying", alpha );
+	}
+	if( early_stop )
+	{
+		// The fixed count run is estimated at the same games/s
+		double fixed_seconds = totals.number_of_games ? seconds * (double)games / (double)totals.number_of_games : 0.0;
+		printf( "early stop: %s after %" PRIu64 " of %" PRIu64 " games (%.2f%%), about %.3f s saved of %.3f s\n",
+				converged ? "converged" : "not converged", totals.number_of_games, games,
+				games ? 100.0 * (double)totals.number_of_games / (double)games : 0.0,
+				fixed_seconds - seconds, fixed_seconds );
+	}
+
+	int status = 0;
+	if( verify )
+	{
+		if( memcmp( &totals, &reference, sizeof(totals) ) == 0 )
+		{
+			printf( "verify: %s counters identical to the scalar reference\n", monty_kernel_name( kernel ) );
+		}
+		else
+		{
+			printf( "verify: MISMATCH, scalar reference played %" PRIu64 " games, %" PRIu64 " switched, %" PRIu64 " switched won, %" PRIu64 " won\n",
+					reference.number_of_games, reference.times_switched, reference.times_switched_won, reference.times_won );
+			status = 1;
+		}
+	}
+
+	free( p_workers );
+	return status;
+}
@@ -0,0 +1,24 @@
+/**
+ * \file
+ *
+ * \brief Types shared by the host side simulation tools
+ *
+ */
+
+#ifndef MONTY_SIM_H_INCLUDED
+#define MONTY_SIM_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_hall.h"
+#include "monty_stats.h"
+
+/** \brief how the simulated player answers Monty's offer */
+typedef enum
+{
+	SIM_STRATEGY_SWITCH, /**< Always take the remaining closed door */
+	SIM_STRATEGY_STAY,   /**< Always keep the first door */
+	SIM_STRATEGY_RANDOM  /**< Toss a coin */
+} SIM_STRATEGY;
+
+#endif /* MONTY_SIM_H_INCLUDED */
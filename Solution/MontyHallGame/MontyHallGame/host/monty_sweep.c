@@ -0,0 +1,670 @@
+/**
+ * \file
+ *
+ * \brief Plays a grid of game settings on all threads
+ *
+ * Every combination of the lists of door counts, strategies, host biases and
+ * game counts is a cell. Cells are cut into pieces of at most
+ * SWEEP_PIECE_GAMES games, and consecutive small pieces are packed into one
+ * task until it holds about as many games, so a task is either part of a big
+ * cell or a batch of small ones.
+ *
+ * Each thread starts with an equal run of the task list. A thread that has
+ * played its own tasks steals the second half of the tasks another thread has
+ * left, so the threads finish together however uneven the cells are.
+ *
+ * A cell's row is written as soon as its last piece is played, in the order
+ * the cells finish, with the wall time from its first piece starting to its
+ * last finishing, the thread time spent on it and the games per thread
+ * second. The lower_ columns count the three door games in which Monty opened
+ * the lower numbered free door, which is where the host bias shows; they are
+ * 0 for more doors.
+ *
+ *   three doors  played by monty_variant_play() with a host that opens the
+ *                lower numbered free door with probability bias when the
+ *                first pick is the prize (0.5 is the board's host); every
+ *                cell plays on the same draws of the run's seed
+ *   more doors   played press by press by monty_nk_sim_run(), Monty opening
+ *                -r doors (all but one by default); the host is always fair,
+ *                so a bias other than 0.5 is rejected
+ *
+ * Usage: monty_sweep [-d doors] [-s strategies] [-b biases] [-n games] [-r reveals]
+ *                    [-t threads] [-S seed] [-o csv] [-B binary]
+ *
+ * Lists are comma separated; -b and -n also take "first:last:count".
+ *
+ *   ./monty_sweep -d 3,4,10 -s switch,stay -n 1e6,1e8
+ *   ./monty_sweep -b 0:1:11 -s switch,stay,random -n 1e8 -B bias.bin
+ *
+ * The binary file is SWEEP_MAGIC, SWEEP_VERSION and the record size as little
+ * endian 32 bit values, followed by one record per cell in the order written:
+ * doors, reveals, strategy and a zero word (32 bit), bias (double), games,
+ * times switched, times switched and won, times won, the same four counters
+ * of the lower_ games, wall ns and thread ns (64 bit), all little endian.
+ *
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "monty_nk_sim.h"
+#include "monty_variant.h"
+
+/** \brief most games in a piece of a cell and in a task */
+#define SWEEP_PIECE_GAMES (1ull << 22)
+
+/** \brief most values in a list */
+#define SWEEP_MAX_VALUES 256
+
+#define SWEEP_MAGIC 0x5753484Du   /* "MHSW" */
+#define SWEEP_VERSION 1
+#define SWEEP_RECORD_BYTES 112
+
+/** \brief one combination of the settings and its counters */
+typedef struct
+{
+	monty_nk_rules rules;
+	SIM_STRATEGY strategy;
+	double bias;
+	monty_variant_limits limits;
+	uint64_t games;
+
+	pthread_mutex_t lock;   /**< Guards the fields below */
+	monty_stats totals;
+	monty_stats lower;      /**< Three door games in which Monty opened the lower numbered free door */
+	uint64_t games_left;
+	uint64_t start_ns;      /**< When its first piece started, 0 before */
+	uint64_t busy_ns;       /**< Thread time spent on its pieces */
+} sweep_cell;
+
+/** \brief range of games of one cell */
+typedef struct
+{
+	uint32_t cell;
+	uint64_t first_game;
+	uint64_t games;
+} sweep_piece;
+
+/** \brief consecutive pieces played together */
+typedef struct
+{
+	uint32_t first_piece;
+	uint32_t piece_count;
+} sweep_task;
+
+/** \brief tasks a thread has left, next..end-1 */
+typedef struct
+{
+	pthread_mutex_t lock;
+	uint32_t next;
+	uint32_t end;
+} sweep_queue;
+
+/** \brief state shared by the threads */
+typedef struct
+{
+	sweep_cell *p_cells;
+	const sweep_piece *p_pieces;
+	const sweep_task *p_tasks;
+	sweep_queue *p_queues;
+	uint32_t threads;
+	uint64_t seed;
+	prng_stream game_stream;
+	prng_stream host_stream;
+
+	pthread_mutex_t output_lock;   /**< Guards the outputs and the counters below */
+	FILE *p_csv;
+	FILE *p_binary;
+	uint32_t cells_done;
+	uint32_t steals;
+	int write_failed;
+} sweep_run;
+
+/** \brief per thread argument */
+typedef struct
+{
+	pthread_t thread;
+	sweep_run *p_run;
+	uint32_t index;
+} sweep_worker;
+
+static const char *const sweep_strategy_names[] = { "switch", "stay", "random" };
+
+static uint64_t sweep_ns( void )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static uint8_t *sweep_put32( uint8_t *p, uint32_t value )
+{
+	for( int i = 0; i < 4; ++i )
+	{
+		*p++ = (uint8_t)(value >> (8 * i));
+	}
+	return p;
+}
+
+static uint8_t *sweep_put64( uint8_t *p, uint64_t value )
+{
+	for( int i = 0; i < 8; ++i )
+	{
+		*p++ = (uint8_t)(value >> (8 * i));
+	}
+	return p;
+}
+
+/** \brief writes the row of a finished cell, called with the output lock held */
+static void sweep_write_cell( sweep_run *p_run, const sweep_cell *p_cell, uint64_t wall_ns )
+{
+	const monty_stats *p_totals = &p_cell->totals;
+	const monty_stats *p_lower = &p_cell->lower;
+	double games = (double)p_totals->number_of_games;
+	double switched = (double)p_totals->times_switched;
+	double stayed = games - switched;
+	double stay_won = (double)(p_totals->times_won - p_totals->times_switched_won);
+	double busy = (double)p_cell->busy_ns * 1e-9;
+
+	if( p_run->p_csv != NULL )
+	{
+		int written = fprintf( p_run->p_csv, "%" PRIu32 ",%" PRIu32 ",%s,%.6f,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+							   ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.6f,%.6f,%.6f,%.6f,%.6f,%.0f\n",
+							   p_cell->rules.door_count, p_cell->rules.reveal_count,
+							   sweep_strategy_names[p_cell->strategy], p_cell->bias, p_totals->number_of_games,
+							   p_totals->times_switched, p_totals->times_switched_won, p_totals->times_won,
+							   p_lower->number_of_games, p_lower->times_switched, p_lower->times_switched_won,
+							   p_lower->times_won,
+							   (games > 0.0) ? (double)p_totals->times_won / games : 0.0,
+							   (switched > 0.0) ? (double)p_totals->times_switched_won / switched : 0.0,
+							   (stayed > 0.0) ? stay_won / stayed : 0.0,
+							   (double)wall_ns * 1e-9, busy, (busy > 0.0) ? games / busy : 0.0 );
+		if( (written < 0) || (fflush( p_run->p_csv ) != 0) )
+		{
+			p_run->write_failed = 1;
+		}
+	}
+
+	if( p_run->p_binary != NULL )
+	{
+		uint8_t record[SWEEP_RECORD_BYTES];
+		uint8_t *p = record;
+		uint64_t bias_bits;
+		memcpy( &bias_bits, &p_cell->bias, sizeof(bias_bits) );
+		p = sweep_put32( p, p_cell->rules.door_count );
+		p = sweep_put32( p, p_cell->rules.reveal_count );
+		p = sweep_put32( p, (uint32_t)p_cell->strategy );
+		p = sweep_put32( p, 0 );
+		p = sweep_put64( p, bias_bits );
+		p = sweep_put64( p, p_totals->number_of_games );
+		p = sweep_put64( p, p_totals->times_switched );
+		p = sweep_put64( p, p_totals->times_switched_won );
+		p = sweep_put64( p, p_totals->times_won );
+		p = sweep_put64( p, p_lower->number_of_games );
+		p = sweep_put64( p, p_lower->times_switched );
+		p = sweep_put64( p, p_lower->times_switched_won );
+		p = sweep_put64( p, p_lower->times_won );
+		p = sweep_put64( p, wall_ns );
+		sweep_put64( p, p_cell->busy_ns );
+		if( (fwrite( record, sizeof(record), 1, p_run->p_binary ) != 1) || (fflush( p_run->p_binary ) != 0) )
+		{
+			p_run->write_failed = 1;
+		}
+	}
+	p_run->cells_done++;
+}
+
+/** \brief plays one piece and writes its cell once the cell is complete */
+static void sweep_play_piece( sweep_run *p_run, const sweep_piece *p_piece )
+{
+	sweep_cell *p_cell = &p_run->p_cells[p_piece->cell];
+	monty_stats totals, lower;
+	uint64_t start = sweep_ns();
+
+	monty_stats_clear( &totals );
+	monty_stats_clear( &lower );
+	if( p_cell->rules.door_count == 3 )
+	{
+		monty_variant_stats stats;
+		memset( &stats, 0, sizeof(stats) );
+		monty_variant_play( &p_run->game_stream, &p_run->host_stream, p_piece->first_game, p_piece->games,
+							p_cell->strategy, &p_cell->limits, 1, &stats );
+		monty_stats_merge( &totals, &stats.opened[0] );
+		monty_stats_merge( &totals, &stats.opened[1] );
+		lower = stats.opened[0];
+	}
+	else
+	{
+		monty_nk_sim_run( &p_cell->rules, p_run->seed, p_piece->first_game, p_piece->games, p_cell->strategy, &totals );
+	}
+	uint64_t stop = sweep_ns();
+
+	pthread_mutex_lock( &p_cell->lock );
+	monty_stats_merge( &p_cell->totals, &totals );
+	monty_stats_merge( &p_cell->lower, &lower );
+	p_cell->busy_ns += stop - start;
+	if( (p_cell->start_ns == 0) || (start < p_cell->start_ns) )
+	{
+		p_cell->start_ns = start;
+	}
+	p_cell->games_left -= p_piece->games;
+	int complete = p_cell->games_left == 0;
+	pthread_mutex_unlock( &p_cell->lock );
+
+	if( complete )
+	{
+		// No other piece of the cell is left, so its counters stay as they are
+		pthread_mutex_lock( &p_run->output_lock );
+		sweep_write_cell( p_run, p_cell, sweep_ns() - p_cell->start_ns );
+		pthread_mutex_unlock( &p_run->output_lock );
+	}
+}
+
+/** \brief takes the next task of a thread's own queue
+ *
+ * \returns 1 with the task in *p_task, 0 when the queue is empty
+ */
+static int sweep_pop( sweep_queue *p_queue, uint32_t *p_task )
+{
+	int found = 0;
+	pthread_mutex_lock( &p_queue->lock );
+	if( p_queue->next < p_queue->end )
+	{
+		*p_task = p_queue->next++;
+		found = 1;
+	}
+	pthread_mutex_unlock( &p_queue->lock );
+	return found;
+}
+
+/** \brief moves the second half of another thread's tasks to a thread's queue
+ *
+ * \returns 1 when tasks were stolen, 0 when every other queue is empty
+ */
+static int sweep_steal( sweep_run *p_run, uint32_t thief )
+{
+	for( uint32_t offset = 1; offset < p_run->threads; ++offset )
+	{
+		sweep_queue *p_victim = &p_run->p_queues[(thief + offset) % p_run->threads];
+		uint32_t first = 0, end = 0;
+
+		pthread_mutex_lock( &p_victim->lock );
+		if( p_victim->next < p_victim->end )
+		{
+			end = p_victim->end;
+			first = p_victim->next + (p_victim->end - p_victim->next) / 2;
+			p_victim->end = first;
+		}
+		pthread_mutex_unlock( &p_victim->lock );
+
+		if( first < end )
+		{
+			sweep_queue *p_own = &p_run->p_queues[thief];
+			pthread_mutex_lock( &p_own->lock );
+			p_own->next = first;
+			p_own->end = end;
+			pthread_mutex_unlock( &p_own->lock );
+
+			pthread_mutex_lock( &p_run->output_lock );
+			p_run->steals++;
+			pthread_mutex_unlock( &p_run->output_lock );
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void *sweep_worker_main( void *p_arg )
+{
+	sweep_worker *p_worker = (sweep_worker *)p_arg;
+	sweep_run *p_run = p_worker->p_run;
+	uint32_t task;
+
+	do
+	{
+		while( sweep_pop( &p_run->p_queues[p_worker->index], &task ) )
+		{
+			const sweep_task *p_task = &p_run->p_tasks[task];
+			for( uint32_t i = 0; i < p_task->piece_count; ++i )
+			{
+				sweep_play_piece( p_run, &p_run->p_pieces[p_task->first_piece + i] );
+			}
+		}
+	} while( sweep_steal( p_run, p_worker->index ) );
+	return NULL;
+}
+
+/** \brief parses a comma separated list of numbers, or "first:last:count" when ranges are allowed
+ *
+ * \returns number of values, 0 for an invalid list
+ */
+static uint32_t sweep_parse_list( const char *p_text, int ranges, double *p_values )
+{
+	double first, last;
+	unsigned count;
+	char tail;
+	if( ranges && (sscanf( p_text, "%lf:%lf:%u%c", &first, &last, &count, &tail ) == 3) )
+	{
+		if( (count == 0) || (count > SWEEP_MAX_VALUES) )
+		{
+			return 0;
+		}
+		for( uint32_t i = 0; i < count; ++i )
+		{
+			p_values[i] = (count == 1) ? first : first + (last - first) * (double)i / (double)(count - 1);
+		}
+		return count;
+	}
+
+	uint32_t values = 0;
+	const char *p = p_text;
+	while( values < SWEEP_MAX_VALUES )
+	{
+		char *p_end;
+		p_values[values] = strtod( p, &p_end );
+		if( p_end == p )
+		{
+			return 0;
+		}
+		values++;
+		if( *p_end == '\0' )
+		{
+			return values;
+		}
+		if( *p_end != ',' )
+		{
+			return 0;
+		}
+		p = p_end + 1;
+	}
+	return 0;
+}
+
+/** \brief parses a comma separated list of strategy names
+ *
+ * \returns number of strategies, 0 for an invalid list
+ */
+static uint32_t sweep_parse_strategies( const char *p_text, SIM_STRATEGY *p_strategies )
+{
+	uint32_t count = 0;
+	while( count < SWEEP_MAX_VALUES )
+	{
+		size_t length = strcspn( p_text, "," );
+		uint32_t s = 0;
+		while( (s < 3) && ((strlen( sweep_strategy_names[s] ) != length) ||
+						   (strncmp( p_text, sweep_strategy_names[s], length ) != 0)) )
+		{
+			s++;
+		}
+		if( s == 3 )
+		{
+			return 0;
+		}
+		p_strategies[count++] = (SIM_STRATEGY)s;
+		if( p_text[length] == '\0' )
+		{
+			return count;
+		}
+		p_text += length + 1;
+	}
+	return 0;
+}
+
+static void sweep_usage( const char *p_name )
+{
+	fprintf( stderr, "usage: %s [-d doors] [-s strategies] [-b biases] [-n games] [-r reveals]\n"
+					 "       [-t threads] [-S seed] [-o csv] [-B binary]\n", p_name );
+}
+
+int main( int argc, char **argv )
+{
+	double doors[SWEEP_MAX_VALUES] = { 3 };
+	SIM_STRATEGY strategies[SWEEP_MAX_VALUES] = { SIM_STRATEGY_SWITCH, SIM_STRATEGY_STAY };
+	double biases[SWEEP_MAX_VALUES] = { 0.5 };
+	double game_counts[SWEEP_MAX_VALUES] = { 1e7 };
+	uint32_t door_values = 1, strategy_values = 2, bias_values = 1, game_values = 1;
+	uint32_t reveals = 0;
+	long threads = sysconf( _SC_NPROCESSORS_ONLN );
+	uint64_t seed = 1;
+	const char *p_csv_name = NULL;
+	const char *p_binary_name = NULL;
+	int opt;
+
+	while( (opt = getopt( argc, argv, "d:s:b:n:r:t:S:o:B:h" )) != -1 )
+	{
+		switch( opt )
+		{
+			case 'd':
+				door_values = sweep_parse_list( optarg, 0, doors );
+				break;
+			case 's':
+				strategy_values = sweep_parse_strategies( optarg, strategies );
+				break;
+			case 'b':
+				bias_values = sweep_parse_list( optarg, 1, biases );
+				break;
+			case 'n':
+				game_values = sweep_parse_list( optarg, 1, game_counts );
+				break;
+			case 'r':
+				reveals = (uint32_t)strtoul( optarg, NULL, 10 );
+				break;
+			case 't':
+				threads = strtol( optarg, NULL, 10 );
+				break;
+			case 'S':
+				seed = strtoull( optarg, NULL, 0 );
+				break;
+			case 'o':
+				p_csv_name = optarg;
+				break;
+			case 'B':
+				p_binary_name = optarg;
+				break;
+			default:
+				sweep_usage( argv[0] );
+				return 1;
+		}
+	}
+	if( (door_values == 0) || (strategy_values == 0) || (bias_values == 0) || (game_values == 0) )
+	{
+		fprintf( stderr, "invalid list of values\n" );
+		return 1;
+	}
+	threads = (threads > 0) ? threads : 1;
+
+	// Check the grid before playing any of it
+	for( uint32_t d = 0; d < door_values; ++d )
+	{
+		uint32_t door_count = (uint32_t)doors[d];
+		if( ((double)door_count != doors[d]) || (door_count < 3) || (door_count > MONTY_NK_MAX_DOORS) )
+		{
+			fprintf( stderr, "doors must be whole numbers from 3 to %d\n", MONTY_NK_MAX_DOORS );
+			return 1;
+		}
+		if( reveals > door_count - 2 )
+		{
+			fprintf( stderr, "Monty can open at most %u of %u doors\n", door_count - 2, door_count );
+			return 1;
+		}
+		for( uint32_t b = 0; (door_count != 3) && (b < bias_values); ++b )
+		{
+			if( biases[b] != 0.5 )
+			{
+				fprintf( stderr, "a host bias other than 0.5 needs the three door game\n" );
+				return 1;
+			}
+		}
+	}
+	for( uint32_t b = 0; b < bias_values; ++b )
+	{
+		if( !((biases[b] >= 0.0) && (biases[b] <= 1.0)) )
+		{
+			fprintf( stderr, "host bias must be from 0 to 1\n" );
+			return 1;
+		}
+	}
+
+	uint32_t cell_count = door_values * strategy_values * bias_values * game_values;
+	sweep_run run;
+	memset( &run, 0, sizeof(run) );
+	run.p_cells = calloc( cell_count, sizeof(*run.p_cells) );
+	run.threads = (uint32_t)threads;
+	run.seed = seed;
+	if( run.p_cells == NULL )
+	{
+		fprintf( stderr, "out of memory\n" );
+		return 1;
+	}
+
+	uint64_t total_games = 0;
+	uint64_t piece_count = 0;
+	uint32_t cell_index = 0;
+	for( uint32_t d = 0; d < door_values; ++d )
+	{
+		for( uint32_t s = 0; s < strategy_values; ++s )
+		{
+			for( uint32_t b = 0; b < bias_values; ++b )
+			{
+				for( uint32_t n = 0; n < game_values; ++n )
+				{
+					sweep_cell *p_cell = &run.p_cells[cell_index++];
+					uint32_t door_count = (uint32_t)doors[d];
+					monty_variant variant = { biases[b], 0.0, 1.0, 1.0 };
+
+					p_cell->rules.door_count = door_count;
+					p_cell->rules.reveal_count = (reveals != 0) ? reveals : door_count - 2;
+					p_cell->strategy = strategies[s];
+					monty_variant_limits_from( &variant, &p_cell->limits );
+					monty_variant_effective( &p_cell->limits, &variant );
+					p_cell->bias = variant.lower_bias;
+					p_cell->games = (uint64_t)game_counts[n];
+					p_cell->games_left = p_cell->games;
+					pthread_mutex_init( &p_cell->lock, NULL );
+					total_games += p_cell->games;
+					piece_count += (p_cell->games + SWEEP_PIECE_GAMES - 1) / SWEEP_PIECE_GAMES;
+				}
+			}
+		}
+	}
+
+	// Cut big cells into pieces and pack runs of small pieces into tasks
+	sweep_piece *p_pieces = calloc( piece_count, sizeof(*p_pieces) );
+	sweep_task *p_tasks = calloc( piece_count, sizeof(*p_tasks) );
+	run.p_queues = calloc( run.threads, sizeof(*run.p_queues) );
+	sweep_worker *p_workers = calloc( run.threads, sizeof(*p_workers) );
+	if( ((piece_count != 0) && ((p_pieces == NULL) || (p_tasks == NULL))) || (run.p_queues == NULL) || (p_workers == NULL) )
+	{
+		fprintf( stderr, "out of memory\n" );
+		return 1;
+	}
+	uint32_t pieces = 0, tasks = 0;
+	uint64_t task_games = 0;
+	for( uint32_t c = 0; c < cell_count; ++c )
+	{
+		for( uint64_t first = 0; first < run.p_cells[c].games; first += SWEEP_PIECE_GAMES )
+		{
+			uint64_t games = run.p_cells[c].games - first;
+			games = (games < SWEEP_PIECE_GAMES) ? games : SWEEP_PIECE_GAMES;
+			if( (tasks == 0) || (task_games + games > SWEEP_PIECE_GAMES) )
+			{
+				p_tasks[tasks++] = (sweep_task){ pieces, 0 };
+				task_games = 0;
+			}
+			p_pieces[pieces++] = (sweep_piece){ c, first, games };
+			p_tasks[tasks - 1].piece_count++;
+			task_games += games;
+		}
+	}
+	run.p_pieces = p_pieces;
+	run.p_tasks = p_tasks;
+
+	prng_init( &run.game_stream, seed, 0 );
+	prng_init( &run.host_stream, seed, MONTY_VARIANT_STREAM );
+	pthread_mutex_init( &run.output_lock, NULL );
+
+	run.p_csv = stdout;
+	if( p_csv_name != NULL )
+	{
+		run.p_csv = fopen( p_csv_name, "w" );
+		if( run.p_csv == NULL )
+		{
+			perror( p_csv_name );
+			return 1;
+		}
+	}
+	fprintf( run.p_csv, "doors,reveals,strategy,bias,games,switched,switched_won,won,"
+						"lower_games,lower_switched,lower_switched_won,lower_won,"
+						"win_rate,switch_win_rate,stay_win_rate,seconds,thread_seconds,games_per_thread_s\n" );
+	if( p_binary_name != NULL )
+	{
+		uint8_t header[12];
+		sweep_put32( sweep_put32( sweep_put32( header, SWEEP_MAGIC ), SWEEP_VERSION ), SWEEP_RECORD_BYTES );
+		run.p_binary = fopen( p_binary_name, "wb" );
+		if( (run.p_binary == NULL) || (fwrite( header, sizeof(header), 1, run.p_binary ) != 1) )
+		{
+			perror( p_binary_name );
+			return 1;
+		}
+	}
+
+	// Cells without games are complete before anything is played
+	for( uint32_t c = 0; c < cell_count; ++c )
+	{
+		if( run.p_cells[c].games == 0 )
+		{
+			sweep_write_cell( &run, &run.p_cells[c], 0 );
+		}
+	}
+
+	uint64_t start = sweep_ns();
+	for( uint32_t i = 0; i < run.threads; ++i )
+	{
+		pthread_mutex_init( &run.p_queues[i].lock, NULL );
+		run.p_queues[i].next = (uint32_t)((uint64_t)tasks * i / run.threads);
+		run.p_queues[i].end = (uint32_t)((uint64_t)tasks * (i + 1) / run.threads);
+	}
+	for( uint32_t i = 0; i < run.threads; ++i )
+	{
+		p_workers[i].p_run = &run;
+		p_workers[i].index = i;
+		if( pthread_create( &p_workers[i].thread, NULL, sweep_worker_main, &p_workers[i] ) != 0 )
+		{
+			fprintf( stderr, "failed to start worker %u\n", i );
+			return 1;
+		}
+	}
+	for( uint32_t i = 0; i < run.threads; ++i )
+	{
+		pthread_join( p_workers[i].thread, NULL );
+	}
+	double seconds = (double)(sweep_ns() - start) * 1e-9;
+
+	if( (run.p_csv != stdout) && (fclose( run.p_csv ) != 0) )
+	{
+		run.write_failed = 1;
+	}
+	if( (run.p_binary != NULL) && (fclose( run.p_binary ) != 0) )
+	{
+		run.write_failed = 1;
+	}
+	fprintf( stderr, "%u cells, %" PRIu64 " games in %u tasks, %u threads, %u steals, %.3f s, %.0f games/s\n",
+			 run.cells_done, total_games, tasks, run.threads, run.steals, seconds,
+			 (seconds > 0.0) ? (double)total_games / seconds : 0.0 );
+	if( run.write_failed )
+	{
+		fprintf( stderr, "failed to write the results\n" );
+	}
+
+	free( p_workers );
+	free( run.p_queues );
+	free( p_tasks );
+	free( p_pieces );
+	free( run.p_cells );
+	return run.write_failed ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+/**
+ * \file
+ *
+ * \brief Three door games with hosts that do not follow the textbook rules
+ *
+ */
+
+#include <math.h>
+
+#include "monty_variant.h"
+
+/** \brief 2^32, a threshold that every draw is below */
+#define VARIANT_ALWAYS (1ull << 32)
+
+static uint64_t variant_limit( double probability )
+{
+	if( !(probability > 0.0) )
+	{
+		return 0;
+	}
+	if( probability >= 1.0 )
+	{
+		return VARIANT_ALWAYS;
+	}
+	return (uint64_t)llround( probability * (double)VARIANT_ALWAYS );
+}
+
+/** \brief turns probabilities into draw thresholds, clamped to 0..1 */
+void monty_variant_limits_from( const monty_variant *p_variant, monty_variant_limits *p_limits )
+{
+	p_limits->lower_bias = variant_limit( p_variant->lower_bias );
+	p_limits->blind = variant_limit( p_variant->blind );
+	p_limits->offer_right = variant_limit( p_variant->offer_right );
+	p_limits->offer_wrong = variant_limit( p_variant->offer_wrong );
+}
+
+/** \brief probabilities the thresholds really apply */
+void monty_variant_effective( const monty_variant_limits *p_limits, monty_variant *p_variant )
+{
+	p_variant->lower_bias = (double)p_limits->lower_bias / (double)VARIANT_ALWAYS;
+	p_variant->blind = (double)p_limits->blind / (double)VARIANT_ALWAYS;
+	p_variant->offer_right = (double)p_limits->offer_right / (double)VARIANT_ALWAYS;
+	p_variant->offer_wrong = (double)p_limits->offer_wrong / (double)VARIANT_ALWAYS;
+}
+
+/** \brief plays a block of games for every variant
+ *
+ * \param p_game - draws of the game stream: prize, Monty's coin, first door, player's coin
+ * \param p_host - draws of the host stream: blind or not, blind Monty's coin, offer
+ * \param games - games in the block, the rest of the lanes are ignored
+ * \param strategy - player strategy when Monty offers the switch
+ * \param p_limits - variants
+ * \param variant_count - number of variants
+ * \param p_stats - counters of each variant to add to
+ */
+__attribute__((target_clones("avx512f","avx2","default")))
+void monty_variant_run( const monty_draw_block *p_game, const monty_draw_block *p_host, uint32_t games,
+						SIM_STRATEGY strategy, const monty_variant_limits *p_limits, uint32_t variant_count,
+						monty_variant_stats *p_stats )
+{
+	uint32_t winning[MONTY_KERNEL_LANES], first[MONTY_KERNEL_LANES], lower[MONTY_KERNEL_LANES];
+	uint32_t higher[MONTY_KERNEL_LANES], forced[MONTY_KERNEL_LANES], blind_open[MONTY_KERNEL_LANES];
+	uint32_t wants[MONTY_KERNEL_LANES], valid[MONTY_KERNEL_LANES];
+
+	// Everything that does not depend on the variant
+	for( uint32_t i = 0; i < MONTY_KERNEL_LANES; ++i )
+	{
+		winning[i] = monty_hall_random_door( p_game->winning[i] );
+		first[i] = monty_hall_random_door( p_game->first[i] );
+		lower[i] = 1 + (first[i] == 1);
+		higher[i] = 3 - (first[i] == 3);
+		forced[i] = 6 - first[i] - winning[i];
+		blind_open[i] = (p_host->coin[i] >> 31) ? higher[i] : lower[i];
+		wants[i] = (strategy == SIM_STRATEGY_SWITCH) || ((strategy == SIM_STRATEGY_RANDOM) && (p_game->player[i] & 0x1));
+		valid[i] = i < games;
+	}
+
+	for( uint32_t v = 0; v < variant_count; ++v )
+	{
+		const monty_variant_limits *p_limit = &p_limits[v];
+		uint32_t games_all = 0, games_higher = 0;
+		uint32_t switched_all = 0, switched_higher = 0;
+		uint32_t switched_won_all = 0, switched_won_higher = 0;
+		uint32_t won_all = 0, won_higher = 0;
+		uint32_t revealed = 0, no_offer = 0;
+
+		for( uint32_t i = 0; i < MONTY_KERNEL_LANES; ++i )
+		{
+			uint32_t right = winning[i] == first[i];
+			uint32_t blind = (uint64_t)p_host->winning[i] < p_limit->blind;
+			uint32_t informed_open = right ? (((uint64_t)p_game->coin[i] < p_limit->lower_bias) ? lower[i] : higher[i])
+											: forced[i];
+			uint32_t open = blind ? blind_open[i] : informed_open;
+			uint32_t shown = open == winning[i];
+			uint32_t is_higher = open == higher[i];
+			uint32_t offered = (uint64_t)p_host->first[i] < (right ? p_limit->offer_right : p_limit->offer_wrong);
+			uint32_t switched = offered & wants[i];
+			// The door left is the prize exactly when the first pick was not
+			uint32_t won = right ^ switched;
+			uint32_t counted = valid[i] & !shown;
+
+			games_all += counted;
+			games_higher += counted & is_higher;
+			switched_all += counted & switched;
+			switched_higher += counted & switched & is_higher;
+			switched_won_all += counted & switched & won;
+			switched_won_higher += counted & switched & won & is_higher;
+			won_all += counted & won;
+			won_higher += counted & won & is_higher;
+			revealed += valid[i] & shown;
+			no_offer += counted & !offered;
+		}
+
+		monty_variant_stats *p_out = &p_stats[v];
+		p_out->opened[0].number_of_games += games_all - games_higher;
+		p_out->opened[0].times_switched += switched_all - switched_higher;
+		p_out->opened[0].times_switched_won += switched_won_all - switched_won_higher;
+		p_out->opened[0].times_won += won_all - won_higher;
+		p_out->opened[1].number_of_games += games_higher;
+		p_out->opened[1].times_switched += switched_higher;
+		p_out->opened[1].times_switched_won += switched_won_higher;
+		p_out->opened[1].times_won += won_higher;
+		p_out->car_revealed += revealed;
+		p_out->no_offer += no_offer;
+	}
+}
+
+/** \brief plays a range of games for every variant
+ *
+ * Game n takes Philox block n of both streams, so a range can be played on
+ * any thread and gives the same counters.
+ *
+ * \param p_game_stream - prize, Monty's coin, first door and player's coin
+ * \param p_host_stream - blind or not, blind Monty's coin and the offer
+ * \param first_game - index of the first game
+ * \param games - number of games
+ * \param strategy - player strategy when Monty offers the switch
+ * \param p_limits - variants
+ * \param variant_count - number of variants
+ * \param p_stats - counters of each variant to add to
+ */
+void monty_variant_play( const prng_stream *p_game_stream, const prng_stream *p_host_stream, uint64_t first_game,
+						uint64_t games, SIM_STRATEGY strategy, const monty_variant_limits *p_limits,
+						uint32_t variant_count, monty_variant_stats *p_stats )
+{
+	monty_draw_block game, host;
+
+	for( uint64_t game_index = first_game; game_index < first_game + games; game_index += MONTY_KERNEL_LANES )
+	{
+		uint64_t left = first_game + games - game_index;
+		monty_kernel_fill( &game, p_game_stream, game_index );
+		monty_kernel_fill( &host, p_host_stream, game_index );
+		monty_variant_run( &game, &host, (left < MONTY_KERNEL_LANES) ? (uint32_t)left : MONTY_KERNEL_LANES,
+						strategy, p_limits, variant_count, p_stats );
+	}
+}
+
+/** \brief adds the counters of one variant to another */
+void monty_variant_merge( monty_variant_stats *p_to, const monty_variant_stats *p_from )
+{
+	monty_stats_merge( &p_to->opened[0], &p_from->opened[0] );
+	monty_stats_merge( &p_to->opened[1], &p_from->opened[1] );
+	p_to->car_revealed += p_from->car_revealed;
+	p_to->no_offer += p_from->no_offer;
+}
+
+/** \brief exact probabilities per game of a variant, by enumerating every path
+ *
+ * \param p_variant - host behaviour, see monty_variant_effective() for the values a run applies
+ * \param strategy - player strategy when Monty offers the switch
+ * \param p_result - probabilities
+ */
+void monty_variant_exact( const monty_variant *p_variant, SIM_STRATEGY strategy, monty_variant_exact_result *p_result )
+{
+	double wants_switch = (strategy == SIM_STRATEGY_SWITCH) ? 1.0 : ((strategy == SIM_STRATEGY_RANDOM) ? 0.5 : 0.0);
+
+	*p_result = (monty_variant_exact_result){ { 0.0, 0.0 }, { 0.0, 0.0 }, { 0.0, 0.0 }, { 0.0, 0.0 }, 0.0, 0.0 };
+	for( uint32_t winning = 1; winning <= 3; ++winning )
+	{
+		for( uint32_t first = 1; first <= 3; ++first )
+		{
+			uint32_t right = winning == first;
+			uint32_t doors[2] = { 1u + (first == 1), 3u - (first == 3) };
+			double offer = right ? p_variant->offer_right : p_variant->offer_wrong;
+
+			for( uint32_t side = 0; side < 2; ++side )
+			{
+				// Probability that Monty opens this door: blind half the time each, informed by the rules
+				double informed = right ? ((side == 0) ? p_variant->lower_bias : 1.0 - p_variant->lower_bias)
+										: ((doors[side] != winning) ? 1.0 : 0.0);
+				double p_open = (p_variant->blind * 0.5 + (1.0 - p_variant->blind) * informed) / 9.0;
+				if( doors[side] == winning )
+				{
+					// Only a blind Monty opens the prize door
+					p_result->car_revealed += p_open;
+					continue;
+				}
+				double p_switched = p_open * offer * wants_switch;
+				p_result->opened[side] += p_open;
+				p_result->switched[side] += p_switched;
+				p_result->switched_won[side] += right ? 0.0 : p_switched;
+				p_result->won[side] += right ? (p_open - p_switched) : p_switched;
+				p_result->no_offer += p_open * (1.0 - offer);
+			}
+		}
+	}
+}
@@ -0,0 +1,98 @@
+/**
+ * \file
+ *
+ * \brief Three door games with hosts that do not follow the textbook rules
+ *
+ * A variant changes how Monty behaves in pick_open_door() and after it:
+ *
+ *   lower_bias   when the player picked the prize Monty opens the lower
+ *                numbered of the two other doors with this probability
+ *                instead of tossing a fair coin (0.5 is the board's host)
+ *   blind        probability that Monty opens one of the two other doors at
+ *                random, prize or not ("Monty Fall"); games in which he shows
+ *                the prize end there and are only counted as car_revealed
+ *   offer_right  probability that Monty offers the switch when the first
+ *                pick is the prize
+ *   offer_wrong  probability of the offer when the first pick is wrong; 0 and 1
+ *                is the host who only offers after a wrong pick, 1 and 0 the
+ *                one who only offers after a right one
+ *
+ * Without an offer the player keeps the first door. With a fair, informed
+ * host who always offers the counters follow the rules of the board.
+ *
+ * Which door Monty opened is what the bias shows: the counters are kept
+ * separately for games in which he opened the lower and the higher numbered
+ * of the doors the player did not pick.
+ *
+ * monty_variant_run() plays a block of games (the draws of monty_kernel_fill()
+ * from two streams) for a whole list of variants at once, every variant on the
+ * same draws, so a sweep over the host parameters takes one pass over the
+ * games. The inner loop over the games of a block is branch free and
+ * vectorizes. Every probability is applied as a 32 bit threshold on a draw,
+ * so it is really threshold / 2^32; monty_variant_exact() works with the same
+ * values.
+ *
+ */
+
+#ifndef MONTY_VARIANT_H_INCLUDED
+#define MONTY_VARIANT_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_kernel.h"
+#include "monty_sim.h"
+
+/** \brief host behaviour */
+typedef struct
+{
+	double lower_bias;
+	double blind;
+	double offer_right;
+	double offer_wrong;
+} monty_variant;
+
+/** \brief variant as thresholds on 32 bit draws, a draw below the threshold means yes */
+typedef struct
+{
+	uint64_t lower_bias;
+	uint64_t blind;
+	uint64_t offer_right;
+	uint64_t offer_wrong;
+} monty_variant_limits;
+
+/** \brief counters of one variant */
+typedef struct
+{
+	monty_stats opened[2];   /**< Games in which Monty opened the lower [0] or the higher [1] numbered free door */
+	uint64_t car_revealed;   /**< Games ended by a blind Monty opening the prize door */
+	uint64_t no_offer;       /**< Games in opened[] without an offer to switch */
+} monty_variant_stats;
+
+/** \brief probabilities per game, the exact counterpart of monty_variant_stats */
+typedef struct
+{
+	double opened[2];        /**< Game counted in opened[] */
+	double switched[2];
+	double switched_won[2];
+	double won[2];
+	double car_revealed;
+	double no_offer;
+} monty_variant_exact_result;
+
+/** \brief stream id of the second set of draws of a game: blind host, his coin and the offer */
+#define MONTY_VARIANT_STREAM 1
+
+void monty_variant_limits_from( const monty_variant *p_variant, monty_variant_limits *p_limits );
+void monty_variant_effective( const monty_variant_limits *p_limits, monty_variant *p_variant );
+
+void monty_variant_run( const monty_draw_block *p_game, const monty_draw_block *p_host, uint32_t games,
+						SIM_STRATEGY strategy, const monty_variant_limits *p_limits, uint32_t variant_count,
+						monty_variant_stats *p_stats );
+void monty_variant_play( const prng_stream *p_game_stream, const prng_stream *p_host_stream, uint64_t first_game,
+						uint64_t games, SIM_STRATEGY strategy, const monty_variant_limits *p_limits,
+						uint32_t variant_count, monty_variant_stats *p_stats );
+void monty_variant_merge( monty_variant_stats *p_to, const monty_variant_stats *p_from );
+
+void monty_variant_exact( const monty_variant *p_variant, SIM_STRATEGY strategy, monty_variant_exact_result *p_result );
+
+#endif /* MONTY_VARIANT_H_INCLUDED */
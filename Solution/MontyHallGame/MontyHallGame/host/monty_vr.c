@@ -0,0 +1,233 @@
+/**
+ * \file
+ *
+ * \brief Variance reduced estimation of the switch and stay win rates
+ *
+ */
+
+#include <string.h>
+
+#include "host_rand.h"
+#include "monty_strategy.h"
+#include "monty_vr.h"
+#include "prng.h"
+
+/** \brief number of (prize door, first door) strata */
+#define MONTY_VR_STRATA 9
+
+/** \brief turns a uniform draw half way round the circle */
+#define MONTY_VR_HALF_TURN 0x80000000u
+
+/** \brief running sums of one sampled quantity */
+typedef struct
+{
+	uint64_t count;
+	double sum;
+	double sum_squares;
+} vr_samples;
+
+static void vr_add( vr_samples *p_samples, double value )
+{
+	p_samples->count++;
+	p_samples->sum += value;
+	p_samples->sum_squares += value * value;
+}
+
+static double vr_mean( const vr_samples *p_samples )
+{
+	return p_samples->count ? p_samples->sum / (double)p_samples->count : 0.0;
+}
+
+/** \brief variance of the mean, from the sample variance */
+static double vr_mean_variance( const vr_samples *p_samples )
+{
+	if( p_samples->count < 2 )
+	{
+		return 0.0;
+	}
+	double n = (double)p_samples->count;
+	double variance = (p_samples->sum_squares - p_samples->sum * p_samples->sum / n) / (n - 1.0);
+	return (variance > 0.0) ? variance / n : 0.0;
+}
+
+/** \brief fills in an estimate
+ *
+ * \param p_estimate - estimate to fill in
+ * \param estimate - estimated value
+ * \param variance - variance of the estimate
+ * \param plain_variance_games - variance of plain sampling times the number of games
+ */
+static void vr_estimate( monty_vr_estimate *p_estimate, double estimate, double variance, double plain_variance_games )
+{
+	p_estimate->estimate = estimate;
+	p_estimate->variance = variance;
+	p_estimate->effective_games = (variance > 0.0) ? plain_variance_games / variance : 0.0;
+}
+
+/** \brief raw draw that monty_hall_random_door() maps to the door */
+static uint32_t vr_door_draw( uint32_t door )
+{
+	return (uint32_t)((((uint64_t)(door - DOOR_PRESSED_MIN) << 32) + 2) / 3);
+}
+
+/** \brief plays one game through handle_current_game_update()
+ *
+ * \param p_strategy - switching or staying
+ * \param p_game_state - game waiting for its first press
+ * \param winning - raw draw for the prize door
+ * \param coin - raw draw for Monty's coin toss
+ * \param first - raw draw for the player's first door
+ * \returns 1 for a win
+ */
+static uint32_t vr_play( monty_strategy *p_strategy, monty_hall_state *p_game_state,
+						uint32_t winning, uint32_t coin, uint32_t first )
+{
+	host_rand_set_draws( winning, coin );
+	return (monty_strategy_play( p_strategy, p_game_state, first, 0 ) > 0);
+}
+
+/** \brief returns the name of a mode */
+const char *monty_vr_name( MONTY_VR_MODE mode )
+{
+	switch( mode )
+	{
+		case MONTY_VR_ANTITHETIC:
+			return "antithetic";
+		case MONTY_VR_STRATIFIED:
+			return "stratified";
+		case MONTY_VR_CRN:
+			return "crn";
+		default:
+		case MONTY_VR_PLAIN:
+			return "plain";
+	}
+}
+
+/** \brief parses a mode name
+ *
+ * \returns 0 if the name is known, -1 otherwise
+ */
+int monty_vr_parse( const char *p_name, MONTY_VR_MODE *p_mode )
+{
+	for( MONTY_VR_MODE mode = MONTY_VR_PLAIN; mode <= MONTY_VR_CRN; ++mode )
+	{
+		if( strcmp( p_name, monty_vr_name( mode ) ) == 0 )
+		{
+			*p_mode = mode;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/** \brief estimates the switch and stay win rates
+ *
+ * \param mode - how the draws of the games are tied together
+ * \param seed - run seed, game (or pair) n uses block n of stream 0
+ * \param games - budget, rounded down to whole pairs or strata rounds
+ * \param p_result - estimates
+ */
+void monty_vr_run( MONTY_VR_MODE mode, uint64_t seed, uint64_t games, monty_vr_result *p_result )
+{
+	monty_strategy strategies[2];
+	monty_hall_state game_state = { { 0, 0, 0, 0 }, MONTY_GAME_STARTED,
+								DOOR_NOT_PRESSED, DOOR_NOT_PRESSED, DOOR_NOT_PRESSED };
+	vr_samples arms[MONTY_VR_STRATA][2];  /**< [stratum][0 switch, 1 stay], stratum 0 unless stratified */
+	vr_samples difference;
+	prng_stream stream;
+	uint32_t draws[PRNG_BLOCK_WORDS];
+
+	monty_strategy_builtin( MONTY_STRATEGY_SWITCH, NULL, &strategies[0] );
+	monty_strategy_builtin( MONTY_STRATEGY_STAY, NULL, &strategies[1] );
+	memset( arms, 0, sizeof(arms) );
+	memset( &difference, 0, sizeof(difference) );
+	prng_init( &stream, seed, 0 );
+	p_result->games = 0;
+
+	switch( mode )
+	{
+		default:
+		case MONTY_VR_PLAIN:
+		{
+			// The player's coin picks the arm, same as monty_sim -s random
+			for( uint64_t i = 0; i < games; ++i )
+			{
+				prng_block_at( &stream, i, draws );
+				uint32_t arm = (draws[3] & 0x1) ? 0 : 1;
+				vr_add( &arms[0][arm], vr_play( &strategies[arm], &game_state, draws[0], draws[1], draws[2] ) );
+			}
+			p_result->games = games;
+			break;
+		}
+
+		case MONTY_VR_ANTITHETIC:
+		{
+			// The arms take turns, a sample is the mean of a pair
+			for( uint64_t i = 0; i < games / 2; ++i )
+			{
+				prng_block_at( &stream, i, draws );
+				uint32_t arm = (uint32_t)(i & 0x1);
+				uint32_t won = vr_play( &strategies[arm], &game_state, draws[0], draws[1], draws[2] );
+				won += vr_play( &strategies[arm], &game_state, draws[0] + MONTY_VR_HALF_TURN, draws[1], draws[2] );
+				vr_add( &arms[0][arm], 0.5 * won );
+			}
+			p_result->games = games / 2 * 2;
+			break;
+		}
+
+		case MONTY_VR_STRATIFIED:
+		{
+			// Round robin over the strata, then over the arms; Monty's coin is still drawn
+			uint64_t rounds = games / (2 * MONTY_VR_STRATA);
+			for( uint64_t i = 0; i < rounds * 2 * MONTY_VR_STRATA; ++i )
+			{
+				prng_block_at( &stream, i, draws );
+				uint32_t stratum = (uint32_t)(i % MONTY_VR_STRATA);
+				uint32_t arm = (uint32_t)((i / MONTY_VR_STRATA) & 0x1);
+				uint32_t winning = vr_door_draw( DOOR_PRESSED_MIN + stratum / 3 );
+				uint32_t first = vr_door_draw( DOOR_PRESSED_MIN + stratum % 3 );
+				vr_add( &arms[stratum][arm], vr_play( &strategies[arm], &game_state, winning, draws[1], first ) );
+			}
+			p_result->games = rounds * 2 * MONTY_VR_STRATA;
+			break;
+		}
+
+		case MONTY_VR_CRN:
+		{
+			// Both arms play the same draws, the difference is sampled per pair
+			for( uint64_t i = 0; i < games / 2; ++i )
+			{
+				prng_block_at( &stream, i, draws );
+				uint32_t switch_won = vr_play( &strategies[0], &game_state, draws[0], draws[1], draws[2] );
+				uint32_t stay_won = vr_play( &strategies[1], &game_state, draws[0], draws[1], draws[2] );
+				vr_add( &arms[0][0], switch_won );
+				vr_add( &arms[0][1], stay_won );
+				vr_add( &difference, (double)switch_won - (double)stay_won );
+			}
+			p_result->games = games / 2 * 2;
+			break;
+		}
+	}
+
+	// Stratified estimates weight every stratum with 1/9, the others only use stratum 0
+	uint32_t strata = (mode == MONTY_VR_STRATIFIED) ? MONTY_VR_STRATA : 1;
+	double estimates[2] = { 0.0, 0.0 };
+	double variances[2] = { 0.0, 0.0 };
+	for( uint32_t arm = 0; arm < 2; ++arm )
+	{
+		for( uint32_t stratum = 0; stratum < strata; ++stratum )
+		{
+			estimates[arm] += vr_mean( &arms[stratum][arm] ) / strata;
+			variances[arm] += vr_mean_variance( &arms[stratum][arm] ) / ((double)strata * strata);
+		}
+	}
+
+	// Plain sampling gives each arm half the games: its variance times the games played
+	double plain_switch = 2.0 * estimates[0] * (1.0 - estimates[0]);
+	double plain_stay = 2.0 * estimates[1] * (1.0 - estimates[1]);
+	vr_estimate( &p_result->switching, estimates[0], variances[0], plain_switch );
+	vr_estimate( &p_result->staying, estimates[1], variances[1], plain_stay );
+	vr_estimate( &p_result->difference, estimates[0] - estimates[1],
+				(mode == MONTY_VR_CRN) ? vr_mean_variance( &difference ) : (variances[0] + variances[1]),
+				plain_switch + plain_stay );
+}
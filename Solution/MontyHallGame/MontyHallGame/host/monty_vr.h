@@ -0,0 +1,59 @@
+/**
+ * \file
+ *
+ * \brief Variance reduced estimation of the switch and stay win rates
+ *
+ * Every mode plays its games press by press through handle_current_game_update()
+ * and spends the same budget of games, half of them switching and half staying
+ * (plain sampling leaves the split to the player's coin). What differs is how
+ * the random draws of the games are tied together:
+ *
+ *   plain       every game gets its own draws (the monty_sim -s random stream)
+ *   antithetic  games come in pairs, the second one turns the prize door draw
+ *               by half the range, which always moves the prize to another door
+ *   stratified  equal numbers of games for each of the 9 (prize, first door)
+ *               pairs, each is weighted with its exact probability 1/9
+ *   crn         every set of draws is played once switching and once staying
+ *
+ * Each mode reports the estimates with their standard errors measured from
+ * the samples, and the effective sample size: the number of plain games that
+ * would give the same variance.
+ *
+ */
+
+#ifndef MONTY_VR_H_INCLUDED
+#define MONTY_VR_H_INCLUDED
+
+#include <stdint.h>
+
+/** \brief estimation modes */
+typedef enum
+{
+	MONTY_VR_PLAIN,
+	MONTY_VR_ANTITHETIC,
+	MONTY_VR_STRATIFIED,
+	MONTY_VR_CRN
+} MONTY_VR_MODE;
+
+/** \brief one estimated quantity */
+typedef struct
+{
+	double estimate;
+	double variance;        /**< Variance of the estimate, measured from the samples */
+	double effective_games; /**< Plain games with the same variance, 0 when the variance is 0 */
+} monty_vr_estimate;
+
+/** \brief result of a run */
+typedef struct
+{
+	uint64_t games;              /**< Games played */
+	monty_vr_estimate switching; /**< Win rate when switching */
+	monty_vr_estimate staying;   /**< Win rate when staying */
+	monty_vr_estimate difference;/**< Switching minus staying */
+} monty_vr_result;
+
+const char *monty_vr_name( MONTY_VR_MODE mode );
+int monty_vr_parse( const char *p_name, MONTY_VR_MODE *p_mode );
+void monty_vr_run( MONTY_VR_MODE mode, uint64_t seed, uint64_t games, monty_vr_result *p_result );
+
+#endif /* MONTY_VR_H_INCLUDED */
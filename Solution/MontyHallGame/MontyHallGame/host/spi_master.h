@@ -0,0 +1,13 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for the ASF spi_master.h, the SPI of the controller model
+ *
+ */
+
+#ifndef SPI_MASTER_H_INCLUDED
+#define SPI_MASTER_H_INCLUDED
+
+#include "ssd1306_mock.h"
+
+#endif /* SPI_MASTER_H_INCLUDED */
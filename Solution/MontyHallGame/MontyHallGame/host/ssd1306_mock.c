@@ -0,0 +1,390 @@
+/**
+ * \file
+ *
+ * \brief Host model of the SSD1306 OLED controller and its SPI
+ *
+ */
+
+#include <string.h>
+
+#include "ssd1306.h"
+
+/** \brief time one byte takes on the bus */
+#define SSD1306_MOCK_BYTE_NS (8 * 1000000000ull / SSD1306_MOCK_CLOCK_HZ)
+
+/** \brief interrupt calls in a row without any progress before the model gives up */
+#define SSD1306_MOCK_IRQ_STORM 16
+
+ssd1306_mock_state g_ssd1306_mock;
+Spi g_ssd1306_mock_spi;
+
+static ssd1306_mock_irq_fn g_irq_handler;
+static void *gp_irq_context;
+
+/** \brief puts the address registers of the controller into their state after a reset
+ *
+ * Page addressing at page 0, column 0, the window on the whole display RAM.
+ * The display RAM keeps what it has.
+ */
+static void ssd1306_mock_controller_reset( void )
+{
+	g_ssd1306_mock.mode = SSD1306_ADDRESSING_PAGE;
+	g_ssd1306_mock.page = 0;
+	g_ssd1306_mock.column = 0;
+	g_ssd1306_mock.column_start = 0;
+	g_ssd1306_mock.column_end = SSD1306_MOCK_COLUMNS - 1;
+	g_ssd1306_mock.page_start = 0;
+	g_ssd1306_mock.page_end = SSD1306_MOCK_PAGES - 1;
+	g_ssd1306_mock.arguments = 0;
+}
+
+/** \brief blank display RAM, idle SPI and the controller set up by ssd1306_init()
+ *
+ * Runs the driver's ssd1306_init() on the model, then zeroes the counters so
+ * they only count what comes after.
+ */
+void ssd1306_mock_reset( void )
+{
+	memset( &g_ssd1306_mock, 0, sizeof(g_ssd1306_mock) );
+	memset( &g_ssd1306_mock_spi, 0, sizeof(g_ssd1306_mock_spi) );
+	ssd1306_mock_controller_reset();
+	ssd1306_init();
+	ssd1306_mock_clear_counters();
+}
+
+/** \brief zeroes the byte, transfer and bus time counters, for example after ssd1306_init() */
+void ssd1306_mock_clear_counters( void )
+{
+	g_ssd1306_mock.commands = 0;
+	g_ssd1306_mock.data = 0;
+	g_ssd1306_mock.transfers = 0;
+	g_ssd1306_mock.bus_ns = 0;
+	g_ssd1306_mock.errors = 0;
+}
+
+/** \brief FNV-1a hash of the display RAM */
+uint32_t ssd1306_mock_hash( void )
+{
+	uint32_t hash = 0x811C9DC5u;
+	for( uint32_t page = 0; page < SSD1306_MOCK_PAGES; ++page )
+	{
+		for( uint32_t column = 0; column < SSD1306_MOCK_COLUMNS; ++column )
+		{
+			hash = (hash ^ g_ssd1306_mock.ram[page][column]) * 0x01000193u;
+		}
+	}
+	return hash;
+}
+
+/** \brief argument bytes that follow a command */
+static uint32_t ssd1306_mock_arguments( uint8_t command )
+{
+	switch( command )
+	{
+		case SSD1306_CMD_SET_COLUMN_ADDRESS:
+		case SSD1306_CMD_SET_PAGE_ADDRESS:
+			return 2;
+		case SSD1306_CMD_SET_MEMORY_ADDRESSING_MODE:
+		case 0x81:  // Contrast
+		case 0x8D:  // Charge pump
+		case 0xA8:  // Multiplex ratio
+		case 0xD3:  // Display offset
+		case 0xD5:  // Clock divide ratio
+		case 0xD9:  // Pre-charge period
+		case 0xDA:  // COM pins
+		case 0xDB:  // VCOMH deselect level
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+/** \brief applies a command that came with its arguments */
+static void ssd1306_mock_command_arguments( const uint8_t *p_command )
+{
+	switch( p_command[0] )
+	{
+		case SSD1306_CMD_SET_MEMORY_ADDRESSING_MODE:
+			g_ssd1306_mock.mode = p_command[1] & 0x03;
+			break;
+		case SSD1306_CMD_SET_COLUMN_ADDRESS:
+			if( g_ssd1306_mock.mode != SSD1306_ADDRESSING_PAGE )
+			{
+				g_ssd1306_mock.column_start = p_command[1] & 0x7F;
+				g_ssd1306_mock.column_end = p_command[2] & 0x7F;
+				g_ssd1306_mock.column = g_ssd1306_mock.column_start;
+			}
+			break;
+		case SSD1306_CMD_SET_PAGE_ADDRESS:
+			if( g_ssd1306_mock.mode != SSD1306_ADDRESSING_PAGE )
+			{
+				g_ssd1306_mock.page_start = p_command[1] & 0x07;
+				g_ssd1306_mock.page_end = p_command[2] & 0x07;
+				g_ssd1306_mock.page = g_ssd1306_mock.page_start;
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+/** \brief applies a command byte to the controller state */
+static void ssd1306_mock_command( uint8_t command )
+{
+	g_ssd1306_mock.commands++;
+	if( g_ssd1306_mock.arguments > 0 )
+	{
+		uint32_t received = ssd1306_mock_arguments( g_ssd1306_mock.command[0] ) - g_ssd1306_mock.arguments + 1;
+		g_ssd1306_mock.command[received] = command;
+		if( --g_ssd1306_mock.arguments == 0 )
+		{
+			ssd1306_mock_command_arguments( g_ssd1306_mock.command );
+		}
+		return;
+	}
+	g_ssd1306_mock.arguments = ssd1306_mock_arguments( command );
+	if( g_ssd1306_mock.arguments > 0 )
+	{
+		g_ssd1306_mock.command[0] = command;
+		return;
+	}
+
+	if( g_ssd1306_mock.mode != SSD1306_ADDRESSING_PAGE )
+	{
+		return;
+	}
+	if( (command & 0xF8) == 0xB0 )
+	{
+		g_ssd1306_mock.page = command & 0x07;
+	}
+	else if( (command & 0xF0) == 0x10 )
+	{
+		g_ssd1306_mock.column = (g_ssd1306_mock.column & 0x0F) | ((uint32_t)(command & 0x0F) << 4);
+	}
+	else if( (command & 0xF0) == 0x00 )
+	{
+		g_ssd1306_mock.column = (g_ssd1306_mock.column & 0xF0) | (command & 0x0F);
+	}
+}
+
+/** \brief applies a data byte to the display RAM and moves the address on */
+static void ssd1306_mock_data( uint8_t data )
+{
+	ssd1306_mock_state *p_mock = &g_ssd1306_mock;
+
+	p_mock->data++;
+	p_mock->ram[p_mock->page][p_mock->column] = data;
+	switch( p_mock->mode )
+	{
+		case SSD1306_ADDRESSING_HORIZONTAL:
+			if( p_mock->column++ == p_mock->column_end )
+			{
+				p_mock->column = p_mock->column_start;
+				p_mock->page = (p_mock->page == p_mock->page_end) ? p_mock->page_start : p_mock->page + 1;
+			}
+			break;
+		case SSD1306_ADDRESSING_VERTICAL:
+			if( p_mock->page++ == p_mock->page_end )
+			{
+				p_mock->page = p_mock->page_start;
+				p_mock->column = (p_mock->column == p_mock->column_end) ? p_mock->column_start : p_mock->column + 1;
+			}
+			break;
+		default:
+			p_mock->column = (p_mock->column + 1) % SSD1306_MOCK_COLUMNS;
+			break;
+	}
+}
+
+void spi_master_init( Spi *p_spi )
+{
+	(void)p_spi;
+}
+
+void spi_master_setup_device( Spi *p_spi, struct spi_device *p_device, spi_flags_t flags, uint32_t baud_rate,
+							  board_spi_select_id_t select_id )
+{
+	(void)p_spi;
+	(void)p_device;
+	(void)flags;
+	(void)baud_rate;
+	(void)select_id;
+}
+
+void spi_select_device( Spi *p_spi, struct spi_device *p_device )
+{
+	(void)p_spi;
+	(void)p_device;
+	g_ssd1306_mock.selected = 1;
+	g_ssd1306_mock.transfers++;
+}
+
+void spi_deselect_device( Spi *p_spi, struct spi_device *p_device )
+{
+	(void)p_spi;
+	(void)p_device;
+	g_ssd1306_mock.selected = 0;
+}
+
+/** \brief sends one byte at once, by the level of D/C# */
+void spi_write_single( Spi *p_spi, uint8_t data )
+{
+	(void)p_spi;
+	g_ssd1306_mock.bus_ns += SSD1306_MOCK_BYTE_NS;
+	if( !g_ssd1306_mock.selected )
+	{
+		g_ssd1306_mock.errors++;
+	}
+	else if( g_ssd1306_mock.dc )
+	{
+		ssd1306_mock_data( data );
+	}
+	else
+	{
+		ssd1306_mock_command( data );
+	}
+}
+
+/** \brief D/C# and reset of the controller, the other pins are not modelled */
+void arch_ioport_set_pin_level( uint32_t pin, bool level )
+{
+	if( pin == SSD1306_MOCK_DC_PIN )
+	{
+		g_ssd1306_mock.dc = level;
+	}
+	else if( (pin == SSD1306_MOCK_RES_PIN) && !level )
+	{
+		ssd1306_mock_controller_reset();
+	}
+}
+
+/** \brief adds the delay to the modelled bus time, the driver waits with the bus idle */
+void delay_us( uint32_t us )
+{
+	g_ssd1306_mock.bus_ns += (uint64_t)us * 1000u;
+}
+
+/** \brief sets the function called for the SPI interrupt */
+void ssd1306_mock_spi_irq( ssd1306_mock_irq_fn handler, void *p_context )
+{
+	g_irq_handler = handler;
+	gp_irq_context = p_context;
+}
+
+/** \brief takes in what was written to the write only registers and updates the status */
+static void ssd1306_mock_spi_registers( void )
+{
+	Spi *p_spi = &g_ssd1306_mock_spi;
+	Pdc *p_pdc = &p_spi->pdc;
+
+	p_spi->SPI_IMR = (p_spi->SPI_IMR | p_spi->SPI_IER) & ~p_spi->SPI_IDR;
+	p_spi->SPI_IER = 0;
+	p_spi->SPI_IDR = 0;
+	if( p_pdc->PERIPH_PTCR & PERIPH_PTCR_TXTDIS )
+	{
+		p_pdc->PERIPH_PTSR &= ~PERIPH_PTSR_TXTEN;
+	}
+	if( p_pdc->PERIPH_PTCR & PERIPH_PTCR_TXTEN )
+	{
+		p_pdc->PERIPH_PTSR |= PERIPH_PTSR_TXTEN;
+	}
+	p_pdc->PERIPH_PTCR = 0;
+
+	// ENDTX once the PDC has handed over its last byte, TXEMPTY once that is out too
+	uint32_t pending = (p_pdc->PERIPH_PTSR & PERIPH_PTSR_TXTEN) && (p_pdc->PERIPH_TCR > 0);
+	p_spi->SPI_SR = ((p_pdc->PERIPH_TCR == 0) ? SPI_SR_ENDTX : 0) |
+					((!pending && !g_ssd1306_mock.shifting) ? SPI_SR_TXEMPTY : 0);
+}
+
+/** \brief advances the model of the SPI and its PDC
+ *
+ * Bytes move from memory to the shift register as soon as it is free and
+ * take SSD1306_MOCK_BYTE_NS each; the interrupt handler is called whenever
+ * an enabled status bit is set, at no cost in time.
+ *
+ * \param ns - time to advance, UINT64_MAX to run until nothing is left to send
+ */
+void ssd1306_mock_spi_run( uint64_t ns )
+{
+	Spi *p_spi = &g_ssd1306_mock_spi;
+	Pdc *p_pdc = &p_spi->pdc;
+	uint64_t end = (ns > UINT64_MAX - g_ssd1306_mock.now_ns) ? UINT64_MAX : g_ssd1306_mock.now_ns + ns;
+	uint32_t calls = 0;
+
+	for( ;; )
+	{
+		ssd1306_mock_spi_registers();
+		if( (p_spi->SPI_SR & p_spi->SPI_IMR) && (g_irq_handler != NULL) && (calls < SSD1306_MOCK_IRQ_STORM) )
+		{
+			g_ssd1306_mock.in_irq = 1;
+			g_irq_handler( gp_irq_context );
+			g_ssd1306_mock.in_irq = 0;
+			calls++;
+			continue;
+		}
+		calls = 0;
+
+		if( g_ssd1306_mock.shifting )
+		{
+			if( g_ssd1306_mock.shift_end_ns > end )
+			{
+				g_ssd1306_mock.now_ns = end;
+				return;
+			}
+			g_ssd1306_mock.now_ns = g_ssd1306_mock.shift_end_ns;
+			g_ssd1306_mock.shifting = 0;
+			g_ssd1306_mock.bus_ns += SSD1306_MOCK_BYTE_NS;
+			if( !g_ssd1306_mock.selected )
+			{
+				g_ssd1306_mock.errors++;
+			}
+			else if( g_ssd1306_mock.dc )
+			{
+				ssd1306_mock_data( g_ssd1306_mock.shift );
+			}
+			else
+			{
+				ssd1306_mock_command( g_ssd1306_mock.shift );
+			}
+			continue;
+		}
+
+		if( (p_pdc->PERIPH_PTSR & PERIPH_PTSR_TXTEN) && (p_pdc->PERIPH_TCR > 0) )
+		{
+			g_ssd1306_mock.shift = *(const uint8_t *)p_pdc->PERIPH_TPR;
+			g_ssd1306_mock.shifting = 1;
+			g_ssd1306_mock.shift_end_ns = g_ssd1306_mock.now_ns + SSD1306_MOCK_BYTE_NS;
+			p_pdc->PERIPH_TPR++;
+			p_pdc->PERIPH_TCR--;
+			continue;
+		}
+
+		// Nothing to send
+		if( end != UINT64_MAX )
+		{
+			g_ssd1306_mock.now_ns = end;
+		}
+		return;
+	}
+}
+
+/** \brief SSD1306_SPI: the SPI, run on by a byte when the driver polls it during a transfer */
+Spi *ssd1306_mock_spi( void )
+{
+	Pdc *p_pdc = &g_ssd1306_mock_spi.pdc;
+
+	ssd1306_mock_spi_registers();
+	if( !g_ssd1306_mock.in_irq && (p_pdc->PERIPH_PTSR & PERIPH_PTSR_TXTEN) &&
+		((p_pdc->PERIPH_TCR > 0) || g_ssd1306_mock.shifting) )
+	{
+		ssd1306_mock_spi_run( SSD1306_MOCK_BYTE_NS );
+	}
+	return &g_ssd1306_mock_spi;
+}
+
+/** \brief non-zero when the SPI has nothing left to send */
+uint32_t ssd1306_mock_spi_idle( void )
+{
+	ssd1306_mock_spi_registers();
+	return (g_ssd1306_mock_spi.SPI_SR & SPI_SR_TXEMPTY) != 0;
+}
@@ -0,0 +1,164 @@
+/**
+ * \file
+ *
+ * \brief Host model of the SSD1306 OLED controller and the SPI it hangs on
+ *
+ * The host tools build the ASF driver itself (ssd1306.h and ssd1306.c) against
+ * this model: the stand-ins for the ASF headers it includes (conf_ssd1306.h,
+ * ioport.h, delay.h, spi_master.h, ...) all come down to this file. Instead of
+ * going out over SPI, the commands and data the driver sends are applied to a
+ * model of the controller's display RAM, and every byte that would have gone
+ * over the bus is counted, so drawing code can be checked pixel for pixel and
+ * its bus traffic compared on the host.
+ *
+ * The three memory addressing modes are modelled. In page mode 0xB0|page
+ * selects the page, 0x1h and 0x0l the column, and each data byte is written at
+ * the column, which then moves on by one, wrapping within the page. In
+ * horizontal and vertical mode 0x21 and 0x22 set the window and move to its
+ * start, and the address runs along the page (horizontal) or down the column
+ * (vertical) within it, on to the next one at the edge and back to the start
+ * after the last. The page mode commands are ignored in the other modes and
+ * the window commands in page mode, as on the controller.
+ *
+ * The time the transfers would take on the board is modelled too: each byte
+ * takes 8 clocks at SSD1306_MOCK_CLOCK_HZ and delay_us(), which the driver
+ * calls after every chip select cycle, adds its time.
+ *
+ * The SPI peripheral and its PDC channel are modelled with the registers the
+ * driver and the flush (monty_flush.h) use, the D/C# pin and the chip select.
+ * spi_write_single() sends its byte at once. A PDC transfer runs on the
+ * model's clock: ssd1306_mock_spi_run() advances it, shifting out the bytes
+ * the PDC hands over, applying each to the display RAM as command or data by
+ * the level of D/C# when its last bit is out, and calling the interrupt
+ * handler while an enabled status bit is set. SSD1306_SPI is
+ * ssd1306_mock_spi(), which also moves the clock on by a byte each time the
+ * driver looks at the SPI outside the interrupt while a transfer is going, so
+ * the driver's own wait for ENDTX and TXEMPTY runs the transfer.
+ *
+ */
+
+#ifndef SSD1306_MOCK_H_INCLUDED
+#define SSD1306_MOCK_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief SPI clock of the OLED on the SAM4S Xplained Pro (UG_2832HSWEG04_BAUDRATE) */
+#define SSD1306_MOCK_CLOCK_HZ 5000000u
+
+/** \brief display RAM of the controller, 8 pages of 128 columns */
+#define SSD1306_MOCK_PAGES   8
+#define SSD1306_MOCK_COLUMNS 128
+
+/** \brief pins of the OLED, as ioport pin numbers */
+#define SSD1306_MOCK_DC_PIN  1
+#define SSD1306_MOCK_CS_PIN  2
+#define SSD1306_MOCK_RES_PIN 3
+
+/** \brief state of the modelled controller */
+typedef struct
+{
+	uint8_t ram[SSD1306_MOCK_PAGES][SSD1306_MOCK_COLUMNS];
+	uint32_t page;
+	uint32_t column;
+	uint32_t mode;           /**< Memory addressing mode */
+	uint32_t column_start;   /**< Window, horizontal and vertical mode */
+	uint32_t column_end;
+	uint32_t page_start;
+	uint32_t page_end;
+	uint8_t command[3];      /**< Command being received, with its arguments so far */
+	uint32_t arguments;      /**< Argument bytes it still waits for */
+	uint64_t commands;       /**< Command bytes sent */
+	uint64_t data;           /**< Data bytes sent */
+	uint64_t transfers;      /**< Chip select cycles, one per byte or burst */
+	uint64_t bus_ns;         /**< Modelled time the transfers take on the board */
+	uint64_t now_ns;         /**< Clock of the SPI model */
+	uint32_t dc;             /**< D/C# pin, 1 for data */
+	uint32_t selected;       /**< Chip select asserted */
+	uint32_t errors;         /**< Bytes shifted out without the chip selected */
+	uint32_t shifting;       /**< A byte is in the shift register */
+	uint8_t shift;           /**< That byte */
+	uint64_t shift_end_ns;   /**< When its last bit is out */
+	uint32_t in_irq;         /**< The interrupt handler is running */
+} ssd1306_mock_state;
+
+extern ssd1306_mock_state g_ssd1306_mock;
+
+/** \brief PDC channel of the SPI, transmit half */
+typedef struct
+{
+	volatile uintptr_t PERIPH_TPR;      /**< Next byte to send */
+	volatile uint32_t PERIPH_TCR;       /**< Bytes left */
+	volatile uint32_t PERIPH_PTCR;      /**< Write only: enable or disable */
+	volatile uint32_t PERIPH_PTSR;      /**< Enabled */
+} Pdc;
+
+/** \brief SPI peripheral, the registers the driver and the flush use */
+typedef struct
+{
+	volatile uint32_t SPI_SR;
+	volatile uint32_t SPI_IER;          /**< Write only */
+	volatile uint32_t SPI_IDR;          /**< Write only */
+	volatile uint32_t SPI_IMR;
+	Pdc pdc;
+} Spi;
+
+#define SPI_SR_ENDTX        (0x1u << 5)
+#define SPI_SR_TXEMPTY      (0x1u << 9)
+#define SPI_IER_ENDTX       SPI_SR_ENDTX
+#define SPI_IER_TXEMPTY     SPI_SR_TXEMPTY
+#define SPI_IDR_ENDTX       SPI_SR_ENDTX
+#define SPI_IDR_TXEMPTY     SPI_SR_TXEMPTY
+#define PERIPH_PTCR_TXTEN   (0x1u << 8)
+#define PERIPH_PTCR_TXTDIS  (0x1u << 9)
+#define PERIPH_PTSR_TXTEN   (0x1u << 8)
+
+extern Spi g_ssd1306_mock_spi;
+
+/** \brief the parts of the ASF SPI master service the driver uses */
+typedef uint32_t spi_flags_t;
+typedef uint32_t board_spi_select_id_t;
+
+#define SPI_MODE_0 0
+
+struct spi_device
+{
+	uint32_t id;
+};
+
+static inline Pdc *spi_get_pdc_base( Spi *p_spi )
+{
+	return &p_spi->pdc;
+}
+
+Spi *ssd1306_mock_spi( void );
+void spi_master_init( Spi *p_spi );
+void spi_master_setup_device( Spi *p_spi, struct spi_device *p_device, spi_flags_t flags, uint32_t baud_rate,
+							  board_spi_select_id_t select_id );
+void spi_select_device( Spi *p_spi, struct spi_device *p_device );
+void spi_deselect_device( Spi *p_spi, struct spi_device *p_device );
+void spi_write_single( Spi *p_spi, uint8_t data );
+
+void arch_ioport_set_pin_level( uint32_t pin, bool level );
+void delay_us( uint32_t us );
+
+/** \brief interrupt handler of the modelled SPI */
+typedef void (*ssd1306_mock_irq_fn)( void *p_context );
+
+void ssd1306_mock_spi_irq( ssd1306_mock_irq_fn handler, void *p_context );
+void ssd1306_mock_spi_run( uint64_t ns );
+uint32_t ssd1306_mock_spi_idle( void );
+
+void ssd1306_mock_reset( void );
+void ssd1306_mock_clear_counters( void );
+uint32_t ssd1306_mock_hash( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SSD1306_MOCK_H_INCLUDED */
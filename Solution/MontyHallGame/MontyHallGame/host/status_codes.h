@@ -0,0 +1,11 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for the ASF status_codes.h, nothing of it is needed
+ *
+ */
+
+#ifndef STATUS_CODES_H_INCLUDED
+#define STATUS_CODES_H_INCLUDED
+
+#endif /* STATUS_CODES_H_INCLUDED */
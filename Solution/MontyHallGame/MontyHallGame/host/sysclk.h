@@ -0,0 +1,11 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for the ASF sysclk.h, nothing of it is needed
+ *
+ */
+
+#ifndef SYSCLK_H_INCLUDED
+#define SYSCLK_H_INCLUDED
+
+#endif /* SYSCLK_H_INCLUDED */
@@ -147,16 +147,24 @@ void ssd1306_write_text(const char *string)
 {
 	uint8_t *char_ptr;
 	uint8_t i;
+	// Columns are collected and sent in as few bursts as fit the line
+	uint8_t line[128];
+	uint32_t length = 0;
 
 	while (*string != 0) {
 		if (*string < 0x7F) {
 			char_ptr = font_table[*string - 32];
+			if (length + char_ptr[0] + 1 > sizeof(line)) {
+				ssd1306_write_data_buffer(line, length);
+				length = 0;
+			}
 			for (i = 1; i <= char_ptr[0]; i++) {
-				ssd1306_write_data(char_ptr[i]);
+				line[length++] = char_ptr[i];
 			}
-			ssd1306_write_data(0x00);
+			line[length++] = 0x00;
 		}
 			string++;
 	}
+	ssd1306_write_data_buffer(line, length);
 }
 
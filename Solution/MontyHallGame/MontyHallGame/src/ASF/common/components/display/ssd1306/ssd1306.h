@@ -236,6 +236,74 @@ static inline void ssd1306_write_data(uint8_t data)
 #endif
 }
 
+/**
+ * \brief Write a run of bytes to the display controller
+ *
+ * Same as calling ssd1306_write_command() or ssd1306_write_data() for every
+ * byte, but the device is selected and D/C# set only once and, on the SPI
+ * peripheral, the bytes are streamed back to back by the PDC instead of one
+ * at a time with SSD1306_LATENCY after each. Returns once the last byte is
+ * out.
+ *
+ * \param data the bytes to write
+ * \param length number of bytes
+ * \param display_data true for display data, false for commands
+ */
+static inline void ssd1306_write_burst(const uint8_t *data, uint32_t length, bool display_data)
+{
+	if (length == 0) {
+		return;
+	}
+#if defined(SSD1306_USART_SPI_INTERFACE)
+	struct usart_spi_device device = {.id = SSD1306_CS_PIN};
+	usart_spi_select_device(SSD1306_USART_SPI, &device);
+	arch_ioport_set_pin_level(SSD1306_DC_PIN, display_data);
+	while (length-- > 0) {
+		usart_spi_transmit(SSD1306_USART_SPI, *data++);
+	}
+	ssd1306_sel_cmd();
+	usart_spi_deselect_device(SSD1306_USART_SPI, &device);
+#elif defined(SSD1306_SPI_INTERFACE)
+	struct spi_device device = {.id = SSD1306_CS_PIN};
+	Pdc *pdc = spi_get_pdc_base(SSD1306_SPI);
+	spi_select_device(SSD1306_SPI, &device);
+	arch_ioport_set_pin_level(SSD1306_DC_PIN, display_data);
+	pdc->PERIPH_TPR = (uintptr_t)data;
+	pdc->PERIPH_TCR = length;
+	pdc->PERIPH_PTCR = PERIPH_PTCR_TXTEN;
+	// The PDC has handed over the last byte, then wait for it to leave the shifter
+	while (!(SSD1306_SPI->SPI_SR & SPI_SR_ENDTX)) {
+	}
+	while (!(SSD1306_SPI->SPI_SR & SPI_SR_TXEMPTY)) {
+	}
+	pdc->PERIPH_PTCR = PERIPH_PTCR_TXTDIS;
+	delay_us(SSD1306_LATENCY); // At least 3us
+	spi_deselect_device(SSD1306_SPI, &device);
+#endif
+}
+
+/**
+ * \brief Write a run of data bytes to the display controller in one burst
+ *
+ * \param data the data to write
+ * \param length number of bytes
+ */
+static inline void ssd1306_write_data_buffer(const uint8_t *data, uint32_t length)
+{
+	ssd1306_write_burst(data, length, true);
+}
+
+/**
+ * \brief Write a run of command bytes to the display controller in one burst
+ *
+ * \param commands the commands and their arguments
+ * \param length number of bytes
+ */
+static inline void ssd1306_write_command_buffer(const uint8_t *commands, uint32_t length)
+{
+	ssd1306_write_burst(commands, length, false);
+}
+
 /**
  * \brief Read data from the controller
  *
@@ -306,7 +374,8 @@ static inline void ssd1306_sleep_disable(void)
  *
  * This command is usually followed by the configuration of the column address
  * because this scheme will provide access to all locations in the display
- * RAM.
+ * RAM. Page addressing mode only, the mode ssd1306_init() leaves the
+ * controller in.
  *
  * \param address the page address
  */
@@ -320,6 +389,8 @@ static inline void ssd1306_set_page_address(uint8_t address)
 /**
  * \brief Set current column in display RAM
  *
+ * Page addressing mode only, the mode ssd1306_init() leaves the controller in.
+ *
  * \param address the column address
  */
 static inline void ssd1306_set_column_address(uint8_t address)
@@ -330,6 +401,137 @@ static inline void ssd1306_set_column_address(uint8_t address)
 	ssd1306_write_command(SSD1306_CMD_SET_LOW_COL(address & 0x0F));
 }
 
+/**
+ * \name Memory addressing modes
+ *
+ * In page addressing mode (after reset) data runs along one page and wraps
+ * back to its start. In horizontal mode it runs along the page within the
+ * window set by ssd1306_set_window() and on to the next page of the window,
+ * in vertical mode down the pages of the window and on to the next column.
+ * ssd1306_init() leaves the controller in page mode, which the address
+ * functions above and ssd1306_write_text() rely on; ssd1306_blit() switches to
+ * horizontal mode for a window of several pages and back.
+ */
+//@{
+#define SSD1306_ADDRESSING_HORIZONTAL 0x00
+#define SSD1306_ADDRESSING_VERTICAL   0x01
+#define SSD1306_ADDRESSING_PAGE       0x02
+//@}
+
+//! \brief Bytes of the commands that set page and column in page mode
+#define SSD1306_PAGE_COMMAND_BYTES    3
+
+//! \brief Bytes of the commands that set a window
+#define SSD1306_WINDOW_COMMAND_BYTES  6
+
+/**
+ * \brief Set the memory addressing mode
+ *
+ * \param mode SSD1306_ADDRESSING_HORIZONTAL, _VERTICAL or _PAGE
+ */
+static inline void ssd1306_set_memory_addressing_mode(uint8_t mode)
+{
+	ssd1306_write_command(SSD1306_CMD_SET_MEMORY_ADDRESSING_MODE);
+	ssd1306_write_command(mode & 0x03);
+}
+
+/**
+ * \brief Fill in the commands that set page and column, page addressing mode
+ *
+ * The same as ssd1306_set_page_address() and ssd1306_set_column_address(), to
+ * be sent as one burst.
+ *
+ * \param commands SSD1306_PAGE_COMMAND_BYTES bytes to fill in
+ * \param page the page address
+ * \param column the column address
+ */
+static inline void ssd1306_page_commands(uint8_t *commands, uint8_t page, uint8_t column)
+{
+	commands[0] = SSD1306_CMD_SET_PAGE_START_ADDRESS(page);
+	commands[1] = SSD1306_CMD_SET_HIGH_COL((column & 0x7F) >> 4);
+	commands[2] = SSD1306_CMD_SET_LOW_COL(column & 0x0F);
+}
+
+/**
+ * \brief Fill in the commands that set a window
+ *
+ * \param commands SSD1306_WINDOW_COMMAND_BYTES bytes to fill in
+ * \param column first column of the window
+ * \param last_column last column of the window
+ * \param page first page of the window
+ * \param last_page last page of the window
+ */
+static inline void ssd1306_window_commands(uint8_t *commands, uint8_t column, uint8_t last_column,
+		uint8_t page, uint8_t last_page)
+{
+	commands[0] = SSD1306_CMD_SET_COLUMN_ADDRESS;
+	commands[1] = column & 0x7F;
+	commands[2] = last_column & 0x7F;
+	commands[3] = SSD1306_CMD_SET_PAGE_ADDRESS;
+	commands[4] = page & 0x07;
+	commands[5] = last_page & 0x07;
+}
+
+/**
+ * \brief Set the window of display RAM the data goes to and move to its start
+ *
+ * Horizontal and vertical addressing modes only.
+ *
+ * \param column first column of the window
+ * \param last_column last column of the window
+ * \param page first page of the window
+ * \param last_page last page of the window
+ */
+static inline void ssd1306_set_window(uint8_t column, uint8_t last_column, uint8_t page, uint8_t last_page)
+{
+	uint8_t commands[SSD1306_WINDOW_COMMAND_BYTES];
+
+	ssd1306_window_commands(commands, column, last_column, page, last_page);
+	ssd1306_write_command_buffer(commands, sizeof(commands));
+}
+
+/**
+ * \brief Copy a rectangle of pages to the display
+ *
+ * Page addressing mode, as ssd1306_init() leaves it, and so it is left. A
+ * single page goes out as its page and column address and one burst. Several
+ * pages go out as one window in horizontal mode and one burst, with the mode
+ * switched around them.
+ *
+ * \param column first column of the rectangle
+ * \param page first page of the rectangle
+ * \param width columns
+ * \param pages pages
+ * \param data width bytes for each page in turn, bit 0 at the top
+ */
+static inline void ssd1306_blit(uint8_t column, uint8_t page, uint8_t width, uint8_t pages, const uint8_t *data)
+{
+	static const uint8_t page_mode[2] = {
+		SSD1306_CMD_SET_MEMORY_ADDRESSING_MODE, SSD1306_ADDRESSING_PAGE
+	};
+
+	if ((width == 0) || (pages == 0)) {
+		return;
+	}
+	if (pages == 1) {
+		uint8_t commands[SSD1306_PAGE_COMMAND_BYTES];
+
+		ssd1306_page_commands(commands, page, column);
+		ssd1306_write_command_buffer(commands, sizeof(commands));
+		ssd1306_write_data_buffer(data, width);
+		return;
+	}
+
+	uint8_t commands[2 + SSD1306_WINDOW_COMMAND_BYTES] = {
+		SSD1306_CMD_SET_MEMORY_ADDRESSING_MODE, SSD1306_ADDRESSING_HORIZONTAL
+	};
+
+	ssd1306_window_commands(&commands[2], column, column + width - 1, page, page + pages - 1);
+	ssd1306_write_command_buffer(commands, sizeof(commands));
+	ssd1306_write_data_buffer(data, (uint32_t)width * pages);
+	ssd1306_write_command_buffer(page_mode, sizeof(page_mode));
+}
+
 /**
  * \brief Set the display start draw line address
  *
@@ -403,17 +605,12 @@ static inline void ssd1306_display_invert_disable(void)
 
 static inline void ssd1306_clear(void)
 {
+	static const uint8_t blank[128] = { 0 };
 	uint8_t page = 0;
-	uint8_t col = 0;
 
 	for (page = 0; page < 4; ++page)
 	{
-		ssd1306_set_page_address(page);
-		ssd1306_set_column_address(0);
-		for (col = 0; col < 128; ++col)
-		{
-			ssd1306_write_data(0x00);
-		}
+		ssd1306_blit(0, page, sizeof(blank), 1, blank);
 	}
 }
 //@}
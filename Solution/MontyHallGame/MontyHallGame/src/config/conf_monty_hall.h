@@ -0,0 +1,53 @@
+/**
+ * \file
+ *
+ * \brief Monty Hall game configuration file.
+ *
+ */
+#ifndef CONF_MONTY_HALL_H_INCLUDED
+#define CONF_MONTY_HALL_H_INCLUDED
+
+// Seed (Philox key) for the game's random stream with
+// CONF_MONTY_HALL_REPRODUCIBLE; otherwise it only personalizes the entropy pool
+#define CONF_MONTY_HALL_SEED         0x4D6F6E747948616CULL
+
+// Uncomment to play the same game sequence after every reset. Otherwise the
+// seed comes from the entropy pool (see monty_entropy.h), filled at power on
+// from the RTC, the AT30TSE75x temperature and ADC noise, and reseeded at the
+// first door press with the cycles the player took.
+//#define CONF_MONTY_HALL_REPRODUCIBLE
+#define CONF_MONTY_HALL_STREAM       0
+
+// ADC inputs sampled for noise at power on: the internal temperature sensor
+// and inputs that are left open with the IO1 and OLED1 extensions fitted
+// (check the kit schematic before using other pins), and the most conversions
+// to make if the pool is not ready sooner.
+#define CONF_MONTY_HALL_ENTROPY_ADC_CHANNELS   ADC_TEMPERATURE_SENSOR, ADC_CHANNEL_4, ADC_CHANNEL_5
+#define CONF_MONTY_HALL_ENTROPY_CONVERSIONS    1024
+
+// Number of doors (3..64) and how many of them Monty opens (1..doors-2). With
+// more than 3 doors buttons 1 and 3 move a cursor and button 2 picks the door
+// under it.
+#define CONF_MONTY_HALL_DOORS        3
+#define CONF_MONTY_HALL_REVEALS      1
+
+// Finished three door games are logged as 2 byte records (see monty_log.h)
+// to the last CONF_MONTY_HALL_LOG_PAGES 512 byte pages of the second flash
+// plane, a page (256 games) at a time. A multiple of 16, as the pages are
+// erased 16 at a time; comment out to disable the log.
+#define CONF_MONTY_HALL_LOG_PAGES    2048
+
+// Uncomment to record the first CONF_MONTY_HALL_RECORD_EVENTS button presses
+// and the random draws they take (at most CONF_MONTY_HALL_RECORD_DRAWS). Once
+// full the recording is sent over the UART as REC lines and replayed at full
+// speed, reporting the cycles it took and a hash of the UART lines; feed the
+// REC lines to host/monty_pipeline to replay them on the host.
+//#define CONF_MONTY_HALL_RECORD_EVENTS  256
+#define CONF_MONTY_HALL_RECORD_DRAWS   1024
+
+// Uncomment to time pick_open_door() against pick_open_door_reference() with
+// the DWT cycle counter at start up and report the result over the UART.
+//#define CONF_MONTY_HALL_BENCHMARK
+#define CONF_MONTY_HALL_BENCHMARK_CALLS 10000
+
+#endif /* CONF_MONTY_HALL_H_INCLUDED */
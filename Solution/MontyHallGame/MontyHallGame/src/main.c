@@ -69,189 +69,92 @@
 
 #include <asf.h>
 #include <string.h>
-
-/** \brief definition of values for door selection */
-enum DOOR_PRESSED_EVENTS
-{
-	DOOR_PRESSED_MIN = 1,
-	DOOR_PRESSED_MAX = 3,
-	DOOR_NOT_PRESSED
-};
+#include "conf_monty_hall.h"
+#include "monty_entropy.h"
+#include "monty_flush.h"
+#include "monty_hall.h"
+#include "monty_log.h"
+#include "monty_nk.h"
+#include "monty_record.h"
+#include "monty_ui.h"
+#include "prng.h"
+
+/** \brief times to try a UART write before giving up on a character */
+#define UART_TRIES 1000000
 
 /** \brief global variable to pass information from interrupt to main */
 volatile uint32_t g_door_pressed = DOOR_NOT_PRESSED;
 
-/** \brief structure to hold door drawing coordinates */
-typedef struct 
-{
-	uint32_t col;
-	uint32_t page;
-	uint32_t width;
-	uint32_t height;
-} door_coordinates;
-
-/** \brief definition of values for monty hall game state */
-typedef enum 
-{
-	MONTY_GAME_STARTED, /**< Game is starting, next button press will setup the game */
-	FIRST_DOOR_OPEN,    /**< First door choice has been made, next press will end the game */
-	GAME_OVER_WON,      /**< Game is over, player won */
-	GAME_OVER_LOST      /**< Game is over, player lost */
-} MONTY_HALL_STATE;
-
-/** \brief structure for holding the current game state and historical won/loss info */
-typedef struct 
-{
-	uint32_t number_of_games;    /**< Total games played since reset */
-	uint32_t times_switched;     /**< Times the player switched doors */
-	uint32_t times_switched_won; /**< Times the player switching doors won */
-	uint32_t times_won;          /**< Total wins (switching or not) */
-	
-	MONTY_HALL_STATE state;      /**< State of the current game */
-	uint32_t first_door;         /**< First door selection */
-	uint32_t open_door;          /**< Door Monty openned */
-	uint32_t winning_door;       /**< Door with the big prize */
-	
-} monty_hall_state;
+/** \brief cycle counter value at the last door press */
+volatile uint32_t g_door_pressed_cycles = 0;
+
+/** \brief random stream the game draws from */
+static prng_stream g_game_rng;
 
-/** \brief Monty door picking algorithm 
+/** \brief the game on the display */
+static monty_ui g_ui;
+
+/** \brief background transfer of the game's screen to the OLED */
+static monty_flush g_display_flush;
+
+#ifndef CONF_MONTY_HALL_REPRODUCIBLE
+/** \brief noise the game's seed is drawn from */
+static monty_entropy_pool g_entropy;
+
+/** \brief ADC inputs sampled for noise */
+static const enum adc_channel_num_t g_entropy_channels[] = { CONF_MONTY_HALL_ENTROPY_ADC_CHANNELS };
+#define ENTROPY_CHANNELS (sizeof(g_entropy_channels) / sizeof(g_entropy_channels[0]))
+
+/** \brief ADC clock while sampling, Hz */
+#define ENTROPY_ADC_CLOCK 6400000
+
+/** \brief times to poll the ADC for the end of a conversion before giving up on it
  *
- * \param winning_door - door that has the big prize
- * \param first_door - door the player selected first
- * \returns The door Monty wants to open
+ * A conversion of the three default channels takes about 10 us at
+ * ENTROPY_ADC_CLOCK; this many polls take around a millisecond.
  */
-uint32_t pick_open_door( uint32_t winning_door, uint32_t first_door )
-{
-	uint32_t open_door = DOOR_NOT_PRESSED;
-	if( first_door != winning_door )
-	{
-		// Since the winning door is not the selected door,
-		//  we need simply pick the opposite unselected door
-		//  There is probably a more efficient algorithm for this,
-		//  but this will work for now.
-		if (first_door == 1)
-		{
-			if (winning_door == 2)
-			{
-				open_door = 3;
-			}
-			else
-			{
-				open_door = 2;
-			}
-		}
-		else if (first_door == 2)
-		{
-			if (winning_door == 3)
-			{
-				open_door = 1;
-			}
-			else
-			{
-				open_door = 3;
-			}
-		}
-		else if (first_door == 3)
-		{
-			if (winning_door == 1)
-			{
-				open_door = 2;
-			}
-			else
-			{
-				open_door = 1;
-			}
-		}
-	}
-	else
-	{
-		open_door = 1;
-		if( open_door == winning_door )
-		{
-			// we can't pick this door, since it is the winning one
-			open_door++;
-		}
-		
-		// Since Monty can open either door, we need to randomly select
-		//  a door.
-		int random_value = rand();
-		if( random_value & 0x1 )
-		{
-			open_door++;
-		}
-		if( open_door == winning_door )
-		{
-			// we can't pick this door, since it is the winning one
-			open_door++;
-		}
-	}
-	return open_door;
-}
+#define ENTROPY_ADC_TRIES 10000
+
+/** \brief bits credited to one ADC reading, only its lowest bits are noise */
+#define ENTROPY_ADC_CREDIT_BITS 1
+
+/** \brief bits credited to the cycles between two button presses */
+#define ENTROPY_PRESS_CREDIT_BITS 2
+#endif
+
+#ifdef CONF_MONTY_HALL_RECORD_EVENTS
+static monty_record_event g_record_events[CONF_MONTY_HALL_RECORD_EVENTS];
+static uint32_t g_record_draws[CONF_MONTY_HALL_RECORD_DRAWS];
 
-/** \brief game state machine
+/** \brief presses of this power-on and the draws they took */
+static monty_recording g_recording;
+
+/** \brief non-zero while the recording is replayed, monty_hall_rand() serves the recorded draws */
+static uint32_t g_record_replaying;
+
+/** \brief characters of a recording line, with the terminating zero
  *
- * \param p_game_state - pointer to the current game state, which will be updated
- * \param new_door_press - the door the player selected most recently
- * \returns 0 if everything is okay -1 for errors and player picking an open door
+ * The longest line is the REPLAY line with four 10 digit counters, 92
+ * characters; the REC and RECD lines of monty_record_format() are shorter.
  */
-int32_t handle_current_game_update( monty_hall_state *p_game_state, uint32_t new_door_press )
+#define RECORD_LINE 96
+_Static_assert( RECORD_LINE >= 16 + 9 * MONTY_RECORD_DRAWS_PER_LINE, "RECORD_LINE too short for a RECD line" );
+#endif
+
+/** \brief random source for the game core */
+uint32_t monty_hall_rand( void )
 {
-	if( p_game_state == NULL )
+#ifdef CONF_MONTY_HALL_RECORD_EVENTS
+	if( g_record_replaying )
 	{
-		return -1;
+		return monty_record_next_draw( &g_recording );
 	}
-	
-	switch( p_game_state->state )
-	{
-		// Set up the game, store the players first door, and open the door Monty selects
-		case MONTY_GAME_STARTED:
-		{
-			p_game_state->winning_door = (rand() % 3) + 1;
-			p_game_state->first_door = new_door_press;
-			p_game_state->state = FIRST_DOOR_OPEN;
-			p_game_state->open_door = pick_open_door( p_game_state->winning_door, new_door_press );
-			break;
-		}
-		
-		// Determine if the player picked a winner
-		case FIRST_DOOR_OPEN:
-		{
-			if( p_game_state->open_door == new_door_press )
-			{
-				// Invalid button press, stay in this state and wait for another press
-				return -1;
-			}
-			if( p_game_state->winning_door == new_door_press )
-			{
-				p_game_state->state = GAME_OVER_WON;
-				p_game_state->times_won++;
-			}
-			else
-			{
-				p_game_state->state = GAME_OVER_LOST;
-			}
-			if( p_game_state->first_door != new_door_press )
-			{
-				p_game_state->times_switched++;
-				if( p_game_state->state == GAME_OVER_WON )
-				{
-					p_game_state->times_switched_won++;
-				}
-			}
-			p_game_state->number_of_games++;
-			break;
-		}
-		
-		// Reset the game for the next player
-		default:
-		case GAME_OVER_LOST:
-		case GAME_OVER_WON:
-		{
-			p_game_state->state = MONTY_GAME_STARTED;
-			break;
-		}
-	}
-	return 0;
+	uint32_t value = prng_next_u32( &g_game_rng );
+	monty_record_draw( &g_recording, value );
+	return value;
+#else
+	return prng_next_u32( &g_game_rng );
+#endif
 }
 
 /**
@@ -264,6 +167,7 @@ static void ProcessButtonEvt(uint8_t uc_button)
 	if ((uc_button >= DOOR_PRESSED_MIN) && 
 	    (uc_button <= DOOR_PRESSED_MAX))
 	{
+		g_door_pressed_cycles = DWT->CYCCNT;
 		g_door_pressed = uc_button;
 	}
 	else
@@ -272,6 +176,14 @@ static void ProcessButtonEvt(uint8_t uc_button)
 	}
 }
 
+/**
+ * \brief SPI interrupt, drives the display flush from one PDC transfer to the next.
+ */
+void SPI_Handler(void)
+{
+	monty_flush_interrupt( &g_display_flush );
+}
+
 /**
  * \brief Handler for Button 1 rising edge interrupt.
  * \param id The button ID.
@@ -345,42 +257,102 @@ static void configure_buttons(void)
 
 }
 
-/** \brief draws a door at the specified coordinates
+#ifndef CONF_MONTY_HALL_REPRODUCIBLE
+/**
+ * \brief Adds ADC noise to the entropy pool until it is ready
  *
- *  \param door - the coordinates to use for the door
- *  \param open - whether door should be drawn open or closed
+ * Converts the CONF_MONTY_HALL_ENTROPY_ADC_CHANNELS inputs over and over, at
+ * most CONF_MONTY_HALL_ENTROPY_CONVERSIONS times, adding every reading and the
+ * cycle counter after each conversion (the ADC runs from its own clock
+ * divider, so the time a conversion takes jitters). With the default
+ * settings the pool is ready after well under a millisecond. The readings of
+ * a conversion that did not end within ENTROPY_ADC_TRIES polls are still
+ * mixed in, but credited nothing.
  */
-static void ssd1306_draw_door(door_coordinates door, uint8_t open)
+static void entropy_add_adc(void)
 {
-	uint8_t i = door.col;
-	uint8_t page_start = door.page;
-	
-	for( i = door.col; i < (door.col+door.width); ++i )
+	uint32_t end_of_conversion = 0;
+
+	pmc_enable_periph_clk(ID_ADC);
+	adc_init(ADC, sysclk_get_cpu_hz(), ENTROPY_ADC_CLOCK, ADC_STARTUP_TIME_4);
+	adc_configure_timing(ADC, 0, ADC_SETTLING_TIME_3, 1);
+	adc_configure_trigger(ADC, ADC_TRIG_SW, 0);
+	adc_set_resolution(ADC, ADC_12_BITS);
+	adc_enable_ts(ADC);
+	for( uint32_t i = 0; i < ENTROPY_CHANNELS; ++i )
+	{
+		adc_enable_channel(ADC, g_entropy_channels[i]);
+		end_of_conversion |= 1u << g_entropy_channels[i];
+	}
+
+	for( uint32_t conversion = 0;
+		 (conversion < CONF_MONTY_HALL_ENTROPY_CONVERSIONS) && !monty_entropy_ready( &g_entropy ); ++conversion )
 	{
-		for (page_start = door.page; page_start <= door.height; ++page_start) 
+		uint32_t credit_bits = 0;
+
+		adc_start(ADC);
+		for( uint32_t tries = 0; tries < ENTROPY_ADC_TRIES; ++tries )
 		{
-			// If this is an edge it is always drawn or if the door is closed, fill it in the door
-			uint8_t edge = (i == door.col) || (i == (door.col+door.width-1));
-			if( !open || edge || (page_start == door.page) || (page_start == door.height) )
+			if( (adc_get_status(ADC) & end_of_conversion) == end_of_conversion )
 			{
-				ssd1306_set_page_address(page_start);
-				ssd1306_set_column_address(i);
-				uint8_t data = 0xff;
-				if( open && !edge && (page_start == door.page) )
-				{
-					// bottom of the door
-					data = 0x01;
-				}
-				if( open && !edge && (page_start == door.height) )
-				{
-					// top of the door
-					data = 0x80;
-				}
-				ssd1306_write_data(data);
+				credit_bits = ENTROPY_ADC_CREDIT_BITS;
+				break;
 			}
 		}
+		for( uint32_t i = 0; i < ENTROPY_CHANNELS; ++i )
+		{
+			monty_entropy_add( &g_entropy, adc_get_channel_value(ADC, g_entropy_channels[i]), credit_bits );
+		}
+		monty_entropy_add( &g_entropy, DWT->CYCCNT, 0 );
 	}
+
+	adc_disable_all_channel(ADC);
+	adc_disable_ts(ADC);
+	pmc_disable_periph_clk(ID_ADC);
+}
+
+/**
+ * \brief Collects the entropy pool at power on
+ *
+ * The RTC keeps counting through a reset and the temperature changes from one
+ * power on to the next; neither is credited, but both make the seed differ
+ * even when the ADC readings happen to repeat.
+ */
+static void entropy_collect(void)
+{
+	uint32_t hour, minute, second, year, month, day, week;
+	double temperature = 0.0;
+	uint32_t temperature_words[2];
+
+	monty_entropy_init( &g_entropy, CONF_MONTY_HALL_SEED );
+
+	rtc_get_time(RTC, &hour, &minute, &second);
+	rtc_get_date(RTC, &year, &month, &day, &week);
+	monty_entropy_add( &g_entropy, (hour << 16) | (minute << 8) | second, 0 );
+	monty_entropy_add( &g_entropy, (year << 16) | (month << 8) | day, 0 );
+
+	monty_entropy_add( &g_entropy, at30tse_read_temperature(&temperature), 0 );
+	memcpy( temperature_words, &temperature, sizeof(temperature_words) );
+	monty_entropy_add( &g_entropy, temperature_words[0], 0 );
+	monty_entropy_add( &g_entropy, temperature_words[1], 0 );
+
+	entropy_add_adc();
+}
+
+/**
+ * \brief Seed for the game's random stream
+ *
+ * Drawn from everything the pool has collected so far: at power on the RTC,
+ * the temperature and the ADC noise, later also the cycle counts between the
+ * button presses. Each call gives a different seed.
+ */
+static uint64_t get_seed(void)
+{
+	uint32_t words[2];
+	monty_entropy_extract( &g_entropy, words, 2 );
+	return ((uint64_t)words[1] << 32) | words[0];
 }
+#endif
 
 /**
  * \brief Clear one character at the cursor current position on the OLED
@@ -445,15 +417,263 @@ void print_uart( char * p_string, uint32_t max_len, uint32_t uart_timeout_cnt )
     }
 }
 
+/** \brief sends a line of the game over the UART */
+static void ui_print( void *p_context, const char *p_line )
+{
+	(void)p_context;
+	print_uart( (char *)p_line, MONTY_UI_LINE, UART_TRIES );
+}
+
+#ifdef CONF_MONTY_HALL_LOG_PAGES
+/** \brief game log records per flash page */
+#define LOG_PAGE_RECORDS (IFLASH1_PAGE_SIZE / sizeof(monty_log_record))
+
+/** \brief pages erased by one erase pages command, see log_erase_block() */
+#define LOG_ERASE_PAGES 16
+
+/** \brief first page of the game log, counted from the start of the second plane */
+#define LOG_FIRST_PAGE (IFLASH1_NB_OF_PAGES - CONF_MONTY_HALL_LOG_PAGES)
+
+_Static_assert( (CONF_MONTY_HALL_LOG_PAGES >= 2 * LOG_ERASE_PAGES) && (CONF_MONTY_HALL_LOG_PAGES <= IFLASH1_NB_OF_PAGES) &&
+				((CONF_MONTY_HALL_LOG_PAGES % LOG_ERASE_PAGES) == 0),
+				"The game log needs whole erase blocks of the second flash plane, at least two" );
+
+/** \brief finished games waiting to be written to flash, one page */
+static monty_log_record g_log_ring[LOG_PAGE_RECORDS];
+
+/** \brief page image being filled from the ring */
+static uint32_t g_log_page_image[IFLASH1_PAGE_SIZE / sizeof(uint32_t)];
+static uint32_t g_log_page_fill;
+
+/** \brief next log page to write, 0..CONF_MONTY_HALL_LOG_PAGES-1 */
+static uint32_t g_log_page;
+
+/** \brief flash writes that failed, their games are lost */
+static uint32_t g_log_errors;
+
+static monty_log g_game_log;
+
+/** \brief records of a log page, read straight from flash */
+static const monty_log_record *log_page_records( uint32_t page )
+{
+	return (const monty_log_record *)(IFLASH1_ADDR + (LOG_FIRST_PAGE + page) * IFLASH1_PAGE_SIZE);
+}
+
+/** \brief a page holds games when its first record is valid, pages are only written whole */
+static uint32_t log_page_written( uint32_t page )
+{
+	return monty_log_valid( log_page_records( page )[0] );
+}
+
+/** \brief erases the 16 page block starting at a log page
+ *
+ * \param page - log page, a multiple of LOG_ERASE_PAGES
+ * \returns 0 if everything is okay, the EFC error otherwise
+ */
+static uint32_t log_erase_block( uint32_t page )
+{
+	// The argument of erase pages is the first page with 2 (16 pages) in its low bits
+	return efc_perform_command( EFC1, EFC_FCMD_EPA, (LOG_FIRST_PAGE + page) | 2 );
+}
+
+/** \brief backing store of the game log, writes whole flash pages
+ *
+ * The log lives in the second flash plane, so the code keeps running from the
+ * first plane while a page is programmed. The block after the page just
+ * written is erased as soon as the page fills its block, so there always is an
+ * erased page after the newest one for log_find_end() to find.
+ */
+static int32_t log_flush_to_flash( void *p_context, const monty_log_record *p_records, uint32_t count )
+{
+	(void)p_context;
+	monty_log_record *p_image = (monty_log_record *)g_log_page_image;
+
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		p_image[g_log_page_fill++] = p_records[i];
+		if( g_log_page_fill < LOG_PAGE_RECORDS )
+		{
+			continue;
+		}
+
+		// Fill the page latch with 32 bit writes to the page, then program it
+		volatile uint32_t *p_latch = (volatile uint32_t *)log_page_records( g_log_page );
+		for( uint32_t word = 0; word < IFLASH1_PAGE_SIZE / sizeof(uint32_t); ++word )
+		{
+			p_latch[word] = g_log_page_image[word];
+		}
+		if( efc_perform_command( EFC1, EFC_FCMD_WP, LOG_FIRST_PAGE + g_log_page ) != 0 )
+		{
+			g_log_errors++;
+		}
+
+		g_log_page = (g_log_page + 1) % CONF_MONTY_HALL_LOG_PAGES;
+		if( (g_log_page % LOG_ERASE_PAGES) == 0 )
+		{
+			// The oldest games go to make room for the next block
+			g_log_errors += log_erase_block( g_log_page ) != 0;
+		}
+		g_log_page_fill = 0;
+	}
+	return 0;
+}
+
+/** \brief finds the page after the newest one, erasing the first block when the log is unusable
+ *
+ * \returns the log page to write next
+ */
+static uint32_t log_find_end( void )
+{
+	uint32_t erased = 0;
+	for( uint32_t page = 0; page < CONF_MONTY_HALL_LOG_PAGES; ++page )
+	{
+		uint32_t previous = (page + CONF_MONTY_HALL_LOG_PAGES - 1) % CONF_MONTY_HALL_LOG_PAGES;
+		if( !log_page_written( page ) )
+		{
+			erased++;
+			if( log_page_written( previous ) )
+			{
+				return page;
+			}
+		}
+	}
+	if( erased != CONF_MONTY_HALL_LOG_PAGES )
+	{
+		// No erased page to continue from, the flash holds something else
+		log_erase_block( 0 );
+	}
+	return 0;
+}
+
+/** \brief opens the game log and counts the games already stored in it
+ *
+ * \param p_stats - counters of the stored games
+ */
+static void log_init( monty_stats *p_stats )
+{
+	g_log_page = log_find_end();
+	monty_log_init( &g_game_log, g_log_ring, LOG_PAGE_RECORDS, LOG_PAGE_RECORDS, log_flush_to_flash, NULL );
+
+	monty_stats_clear( p_stats );
+	for( uint32_t page = 0; page < CONF_MONTY_HALL_LOG_PAGES; ++page )
+	{
+		if( log_page_written( page ) )
+		{
+			monty_log_replay( log_page_records( page ), LOG_PAGE_RECORDS, p_stats );
+		}
+	}
+}
+#endif
+
+#ifdef CONF_MONTY_HALL_RECORD_EVENTS
+/** \brief folds a replayed UART line into the hash instead of sending it */
+static void record_hash_print( void *p_context, const char *p_line )
+{
+	uint32_t *p_hash = p_context;
+	*p_hash = monty_record_hash( *p_hash, p_line );
+}
+
+/**
+ * \brief Sends the full recording over the UART as REC/RECD lines, then
+ * replays it through a second game at full speed and reports the cycles the
+ * presses took and the hash of the UART lines they printed. monty_pipeline
+ * on the host replays the REC lines through the same code and prints the same
+ * hash.
+ */
+static void record_dump_and_replay( void )
+{
+	static monty_ui replay;
+	char line[RECORD_LINE];
+	uint32_t hash = MONTY_RECORD_HASH_START;
+
+	for( uint32_t event = 0; event < g_recording.event_count; ++event )
+	{
+		for( uint32_t n = 0; monty_record_format( &g_recording, event, n, line ); ++n )
+		{
+			print_uart( line, sizeof(line), UART_TRIES );
+		}
+	}
+
+	monty_ui_init( &replay, CONF_MONTY_HALL_DOORS, CONF_MONTY_HALL_REVEALS, record_hash_print, &hash, NULL );
+	monty_record_rewind( &g_recording );
+	g_record_replaying = true;
+
+	uint32_t slowest = 0;
+	uint32_t start = DWT->CYCCNT;
+	ssd1306_clear();
+	monty_ui_start( &replay );
+	for( uint32_t event = 0; event < g_recording.event_count; ++event )
+	{
+		uint32_t press_start = DWT->CYCCNT;
+		monty_ui_press( &replay, g_recording.p_events[event].button );
+		uint32_t cycles = DWT->CYCCNT - press_start;
+		slowest = (cycles > slowest) ? cycles : slowest;
+	}
+	uint32_t total = DWT->CYCCNT - start;
+	g_record_replaying = false;
+
+	snprintf( line, sizeof(line), "REPLAY %lu presses %lu draws, %lu cycles, max %lu, hash %08lx",
+		(unsigned long)g_recording.event_count,
+		(unsigned long)g_recording.next_draw,
+		(unsigned long)total,
+		(unsigned long)slowest,
+		(unsigned long)hash );
+	print_uart( line, sizeof(line), UART_TRIES );
+}
+#endif
+
+#ifdef CONF_MONTY_HALL_BENCHMARK
+/**
+ * \brief Times the table driven pick_open_door() against the original version
+ * with the DWT cycle counter and reports cycles per call (x100) over the UART.
+ *
+ * \param max_len - maximum number of characters in a UART line
+ * \param uart_timeout_cnt - number of times to try to write to the UART before timing out
+ */
+static void benchmark_pick_open_door( uint32_t max_len, uint32_t uart_timeout_cnt )
+{
+	static uint8_t winning[256];
+	static uint8_t first[256];
+	char line[80];
+	volatile uint32_t sink = 0;
+
+	for( uint32_t i = 0; i < 256; ++i )
+	{
+		winning[i] = (uint8_t)monty_hall_random_door( monty_hall_rand() );
+		first[i] = (uint8_t)monty_hall_random_door( monty_hall_rand() );
+	}
+
+	uint32_t start = DWT->CYCCNT;
+	for( uint32_t i = 0; i < CONF_MONTY_HALL_BENCHMARK_CALLS; ++i )
+	{
+		sink += pick_open_door_reference( winning[i & 0xff], first[i & 0xff] );
+	}
+	uint32_t reference_cycles = DWT->CYCCNT - start;
+
+	start = DWT->CYCCNT;
+	for( uint32_t i = 0; i < CONF_MONTY_HALL_BENCHMARK_CALLS; ++i )
+	{
+		sink += pick_open_door( winning[i & 0xff], first[i & 0xff] );
+	}
+	uint32_t table_cycles = DWT->CYCCNT - start;
+
+	sprintf( line, "pick_open_door_reference: %u cycles/100 calls",
+		(unsigned)((uint64_t)reference_cycles * 100 / CONF_MONTY_HALL_BENCHMARK_CALLS) );
+	print_uart( line, max_len, uart_timeout_cnt );
+	sprintf( line, "pick_open_door (table):   %u cycles/100 calls",
+		(unsigned)((uint64_t)table_cycles * 100 / CONF_MONTY_HALL_BENCHMARK_CALLS) );
+	print_uart( line, max_len, uart_timeout_cnt );
+}
+#endif
+
 /**
  *  Main entry point
  */
 int main(void)
 {
 	const uint32_t max_disp_string = 120;
-    const uint32_t max_uart_tries  = 1000000;
+    const uint32_t max_uart_tries  = UART_TRIES;
     char result_uart_output[max_disp_string];
-	char result_disp[4][max_disp_string];
 
 	// Initialize clocks.
 	sysclk_init();
@@ -464,123 +684,101 @@ int main(void)
 	// Initialize at30tse.
 	at30tse_init();
 
+	// Start the cycle counter, used to time the first door press
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+#ifdef CONF_MONTY_HALL_REPRODUCIBLE
+	prng_init( &g_game_rng, CONF_MONTY_HALL_SEED, CONF_MONTY_HALL_STREAM );
+#else
+	entropy_collect();
+	prng_init( &g_game_rng, get_seed(), CONF_MONTY_HALL_STREAM );
+	uint32_t rng_reseeded = false;
+	uint32_t last_press_cycles = 0;
+#endif
+
 	// Configure IO1 buttons.
 	configure_buttons();
 
 	// Start the UART
 	sam4s_console_uart_init();
+
+#ifdef CONF_MONTY_HALL_BENCHMARK
+	benchmark_pick_open_door( max_disp_string, max_uart_tries );
+#endif
 	
+#ifdef CONF_MONTY_HALL_LOG_PAGES
+	monty_stats logged;
+	log_init( &logged );
+	sprintf( result_uart_output, "Game log: %lu games, Switch Count %lu, Switch Win %d%% Stay Win %d%%",
+		(unsigned long)logged.number_of_games,
+		(unsigned long)logged.times_switched,
+		monty_stats_percent( logged.times_switched_won, logged.times_switched ),
+		monty_stats_percent( monty_stats_stayed_won( &logged ), monty_stats_stayed( &logged ) ) );
+	print_uart( result_uart_output, max_disp_string, max_uart_tries );
+#endif
+
+#ifdef CONF_MONTY_HALL_RECORD_EVENTS
+	monty_record_init( &g_recording, g_record_events, CONF_MONTY_HALL_RECORD_EVENTS,
+						g_record_draws, CONF_MONTY_HALL_RECORD_DRAWS );
+	uint32_t recording_replayed = false;
+#endif
+
 	// Initialize SPI and SSD1306 controller.
 	ssd1306_init();
 	ssd1306_clear();
+	monty_flush_init( &g_display_flush, NULL, NULL );
+	NVIC_EnableIRQ( SPI_IRQn );
+
+#ifdef CONF_MONTY_HALL_LOG_PAGES
+	monty_ui_init( &g_ui, CONF_MONTY_HALL_DOORS, CONF_MONTY_HALL_REVEALS, ui_print, NULL, &g_game_log );
+#else
+	monty_ui_init( &g_ui, CONF_MONTY_HALL_DOORS, CONF_MONTY_HALL_REVEALS, ui_print, NULL, NULL );
+#endif
+	// Presses are handled while the screen goes out over the PDC
+	monty_ui_flush_async( &g_ui, &g_display_flush );
+	monty_ui_start( &g_ui );
 
-
-	monty_hall_state game_state = { 0, 0, 0, 0, MONTY_GAME_STARTED,
-								DOOR_NOT_PRESSED, DOOR_NOT_PRESSED, DOOR_NOT_PRESSED };
-								
-    print_uart( "Press a button to select a door", max_disp_string, max_uart_tries );
-	ssd1306_set_page_address(0);
-	ssd1306_set_column_address(0);
-	ssd1306_write_text("Select a door");
-	
-	door_coordinates door1_coord = { 10, 2, 10, 3 };
-	door_coordinates door2_coord = { 60, 2, 10, 3 };
-	door_coordinates door3_coord = { 110, 2, 10, 3 };
-
-	ssd1306_draw_door( door1_coord, false );
-	ssd1306_draw_door( door2_coord, false );
-	ssd1306_draw_door( door3_coord, false );
-	
 	for( ;; )
 	{
-		int32_t result = 0;
 		if( g_door_pressed != DOOR_NOT_PRESSED )
 		{
-			uint32_t game_over = false;
-			result = handle_current_game_update( &game_state, g_door_pressed );
+			uint32_t button = g_door_pressed;
 			g_door_pressed = DOOR_NOT_PRESSED;
-			if( game_state.state == FIRST_DOOR_OPEN )
-			{
-				if( result == 0 )
-				{
-					sprintf( result_uart_output, "Game State %d: selected door %d open door %d",
-					game_state.state,
-					game_state.first_door,
-					game_state.open_door );
-					print_uart( result_uart_output, max_disp_string, max_uart_tries );
-				}
-				sprintf( result_disp[0], "Select a door (last %d)", game_state.first_door );
-			}
-			else if( game_state.state == GAME_OVER_WON )
-			{
-				sprintf( result_uart_output, "Won: Game State %d: selected door %d open door %d",
-				game_state.state,
-				game_state.first_door,
-				game_state.open_door );
-				print_uart( result_uart_output, max_disp_string, max_uart_tries );
-				game_over = true;
-				sprintf( result_disp[0], "Winner" );
-			}
-			else if( game_state.state == GAME_OVER_LOST )
+#ifndef CONF_MONTY_HALL_REPRODUCIBLE
+			// Human reaction time is the noisiest source there is
+			monty_entropy_add( &g_entropy, g_door_pressed_cycles - last_press_cycles, ENTROPY_PRESS_CREDIT_BITS );
+			last_press_cycles = g_door_pressed_cycles;
+			if( !rng_reseeded )
 			{
-				sprintf( result_uart_output, "Lost: Game State %d: selected door %d open door %d",
-				game_state.state,
-				game_state.first_door,
-				game_state.open_door );
-				print_uart( result_uart_output, max_disp_string, max_uart_tries );
-				game_over = true;
-				sprintf( result_disp[0], "Loser" );
+				prng_init( &g_game_rng, get_seed(), CONF_MONTY_HALL_STREAM );
+				rng_reseeded = true;
 			}
-			else if( game_state.state == MONTY_GAME_STARTED )
+#endif
+#ifdef CONF_MONTY_HALL_RECORD_EVENTS
+			monty_record_press( &g_recording, g_door_pressed_cycles, button );
+#endif
+			monty_ui_press( &g_ui, button );
+#ifdef CONF_MONTY_HALL_RECORD_EVENTS
+			if( monty_record_full( &g_recording ) && !recording_replayed )
 			{
-				print_uart( "Press a button to select a door", max_disp_string, max_uart_tries );
-				sprintf( result_disp[0], "Select a door" );
-			}
-			
-			// Game is over calculate the statistics and set up the final display
-			if( game_over )
-			{
-				uint32_t win_pct = (game_state.times_won * 100) / game_state.number_of_games;
-				uint32_t switching_win_pct = (game_state.times_switched_won * 100) / game_state.times_switched;
-				uint32_t staying_win_pct = ((game_state.times_won-game_state.times_switched_won) * 100)
-				/ (game_state.number_of_games-game_state.times_switched);
-				sprintf( result_uart_output, "Games Played: %d, Switch Count %d, Games Win %d%%, Switch Win %d%% Stay Win %d%%",
-				game_state.number_of_games,
-				game_state.times_switched,
-				win_pct,
-				switching_win_pct,
-				staying_win_pct );
-				print_uart( result_uart_output, max_disp_string, max_uart_tries );
-				print_uart( "Press a button to play again", max_disp_string, max_uart_tries );
-				game_state.open_door = DOOR_NOT_PRESSED;
-				sprintf( result_disp[1], "Game win %%   %d", win_pct );
-				sprintf( result_disp[2], "Switch win %% %d", switching_win_pct );				
-				sprintf( result_disp[3], "Stay win %%   %d", staying_win_pct );
-			}
-			
-			// Clear screen.
-			ssd1306_clear();
-			ssd1306_set_page_address(0);
-			ssd1306_set_column_address(0);
-			ssd1306_write_text(result_disp[0]);
-
-			if( !game_over )
-			{
-				ssd1306_draw_door( door1_coord, (game_state.open_door == 1) );
-				ssd1306_draw_door( door2_coord, (game_state.open_door == 2) );
-				ssd1306_draw_door( door3_coord, (game_state.open_door == 3) );
-			}
-			else
-			{
-				for( uint8_t row = 1; row < 4; ++row )
+				// The replay draws with blocking flushes on the same SPI
+				while( monty_flush_busy( &g_display_flush ) )
 				{
-					ssd1306_set_page_address(row);
-					ssd1306_set_column_address(0);
-					ssd1306_write_text(result_disp[row]);
 				}
+				record_dump_and_replay();
+				recording_replayed = true;
+				ssd1306_clear();
+				monty_framebuffer_panel_cleared( &g_ui.display );
+				monty_ui_draw( &g_ui );
 			}
+#endif
 		}
 
+		// Sends what a flush still in flight held back
+		monty_ui_flush( &g_ui );
+
 		/* Wait and stop screen flickers. */
 		delay_ms(50);
 	}
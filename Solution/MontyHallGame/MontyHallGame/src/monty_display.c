@@ -0,0 +1,179 @@
+/**
+ * \file
+ *
+ * \brief Drawing the game on the SSD1306 OLED
+ *
+ */
+
+#include <string.h>
+
+#include "monty_display.h"
+
+/** \brief works out one page of a door
+ *
+ *  \param p_door - the coordinates to use for the door
+ *  \param open - whether door should be drawn open or closed
+ *  \param page - page of the door
+ *  \param width - columns to work out, at most the door's width
+ *  \param p_row - pixels of the page
+ *  \param p_mask - pixels the door covers, an open door leaves its inside alone
+ */
+static void monty_display_door_row( const door_coordinates *p_door, uint8_t open, uint32_t page, uint32_t width,
+									uint8_t *p_row, uint8_t *p_mask )
+{
+	for( uint32_t i = 0; i < width; ++i )
+	{
+		// If this is an edge it is always drawn or if the door is closed, fill it in the door
+		// Doors too narrow to show an opening lose their edges when open
+		uint8_t edge = ((i == 0) || (i == (p_door->width-1))) && !(open && (p_door->width < 3));
+		uint8_t data = 0xff;
+		uint8_t mask = 0xff;
+		if( open && !edge )
+		{
+			if( page == p_door->height )
+			{
+				// top of the door
+				data = 0x80;
+			}
+			else if( page == p_door->page )
+			{
+				// bottom of the door
+				data = 0x01;
+			}
+			else
+			{
+				data = 0x00;
+				mask = 0x00;
+			}
+		}
+		p_row[i] = data;
+		p_mask[i] = mask;
+	}
+}
+
+/** \brief renders the doors of a layout into sprites
+ *
+ *  The text cache starts empty. Doors wider than MONTY_DISPLAY_DOOR_WIDTH or
+ *  taller than MONTY_DISPLAY_DOOR_PAGES get no sprite and are drawn column by
+ *  column instead.
+ *
+ *  \param p_sprites - sprites to set up
+ *  \param p_door - coordinates of a door, all doors of the layout have its size
+ */
+void monty_display_sprites_init( monty_display_sprites *p_sprites, const door_coordinates *p_door )
+{
+	uint32_t pages = p_door->height - p_door->page + 1;
+
+	monty_sprite_font_init( &p_sprites->font );
+	memset( p_sprites->doors, 0, sizeof(p_sprites->doors) );
+	if( (p_door->height < p_door->page) || (pages > MONTY_DISPLAY_DOOR_PAGES) ||
+		(p_door->width == 0) || (p_door->width > MONTY_DISPLAY_DOOR_WIDTH) )
+	{
+		return;
+	}
+
+	uint32_t width = p_door->width;
+	uint8_t mask[MONTY_DISPLAY_DOOR_WIDTH];
+	for( uint32_t page = 0; page < pages; ++page )
+	{
+		monty_display_door_row( p_door, 0, p_door->page + page, width, &p_sprites->closed[page * width], mask );
+		monty_display_door_row( p_door, 1, p_door->page + page, width, &p_sprites->open[page * width],
+								&p_sprites->open_mask[page * width] );
+	}
+	// Doors of two pages have no inside left open, the mask is only needed for taller ones
+	const uint8_t *p_open_mask = NULL;
+	for( uint32_t i = 0; i < pages * width; ++i )
+	{
+		if( p_sprites->open_mask[i] != 0xff )
+		{
+			p_open_mask = p_sprites->open_mask;
+		}
+	}
+	for( uint32_t open = 0; open < 2; ++open )
+	{
+		p_sprites->doors[open].p_image = open ? p_sprites->open : p_sprites->closed;
+		p_sprites->doors[open].p_mask = open ? p_open_mask : NULL;
+		p_sprites->doors[open].width = (uint8_t)width;
+		p_sprites->doors[open].pages = (uint8_t)pages;
+	}
+}
+
+/** \brief draws a door at the specified coordinates
+ *
+ *  Each page of the door is worked out in a row and copied in with one blit.
+ *
+ *  \param p_fb - framebuffer to draw into
+ *  \param p_door - the coordinates to use for the door
+ *  \param open - whether door should be drawn open or closed
+ */
+void monty_display_draw_door( monty_framebuffer *p_fb, const door_coordinates *p_door, uint8_t open )
+{
+	uint8_t row[MONTY_DISPLAY_COLUMNS];
+	uint8_t mask[MONTY_DISPLAY_COLUMNS];
+	uint32_t width = p_door->width;
+	uint32_t page_start = p_door->page;
+
+	if( width > MONTY_DISPLAY_COLUMNS )
+	{
+		width = MONTY_DISPLAY_COLUMNS;
+	}
+	for( page_start = p_door->page; page_start <= p_door->height; ++page_start )
+	{
+		monty_display_door_row( p_door, open, page_start, width, row, mask );
+		monty_framebuffer_blit_masked( p_fb, (uint8_t)p_door->col, (uint8_t)page_start, (uint8_t)width, 1, row, mask );
+	}
+}
+
+/** \brief draws all doors
+ *
+ *  \param p_fb - framebuffer to draw into
+ *  \param p_sprites - door sprites of the layout, NULL to work the doors out each time
+ *  \param p_doors - coordinates of the doors
+ *  \param door_count - number of doors
+ *  \param open_doors - doors to draw open
+ *  \param cursor_door - door to mark with the cursor, DOOR_NOT_PRESSED for none
+ */
+void monty_display_draw_doors( monty_framebuffer *p_fb, const monty_display_sprites *p_sprites,
+							const door_coordinates *p_doors, uint32_t door_count,
+							monty_door_set open_doors, uint32_t cursor_door )
+{
+	for( uint32_t door = 1; door <= door_count; ++door )
+	{
+		const door_coordinates *p_door = &p_doors[door-1];
+		uint8_t open = (open_doors & monty_door_bit(door)) != 0;
+
+		if( (p_sprites != NULL) && (p_sprites->doors[open].width == p_door->width) &&
+			(p_sprites->doors[open].pages == p_door->height - p_door->page + 1) )
+		{
+			monty_sprite_draw( p_fb, &p_sprites->doors[open], (uint8_t)p_door->col, (uint8_t)p_door->page );
+		}
+		else
+		{
+			monty_display_draw_door( p_fb, p_door, open );
+		}
+
+		// The cursor is a dash on the page above the door
+		monty_framebuffer_fill( p_fb, p_door->page - 1, p_door->col, p_door->width,
+								(door == cursor_door) ? 0x18 : 0x00 );
+	}
+}
+
+/** \brief writes a line of text at the start of a page
+ *
+ *  \param p_fb - framebuffer to draw into
+ *  \param p_sprites - sprites with the cached strings, NULL to draw glyph by glyph
+ *  \param page - page (text row) to write
+ *  \param p_text - text
+ */
+void monty_display_text( monty_framebuffer *p_fb, const monty_display_sprites *p_sprites, uint8_t page,
+						const char *p_text )
+{
+	if( p_sprites != NULL )
+	{
+		monty_sprite_font_text( &p_sprites->font, p_fb, page, 0, p_text );
+	}
+	else
+	{
+		monty_framebuffer_text( p_fb, page, 0, p_text );
+	}
+}
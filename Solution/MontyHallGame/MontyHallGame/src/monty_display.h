@@ -0,0 +1,63 @@
+/**
+ * \file
+ *
+ * \brief Drawing the game on the SSD1306 OLED
+ *
+ * Draws into a framebuffer (monty_framebuffer.h) that is flushed to the
+ * panel through the ssd1306_* calls of the ASF driver, so the same code draws
+ * on the board and into the controller model of the host build (see
+ * host/ssd1306_mock.h).
+ *
+ * The doors of the layout and the game's fixed strings are rendered once into
+ * sprites (monty_sprite.h), so drawing a screen is mostly copies.
+ *
+ */
+
+#ifndef MONTY_DISPLAY_H_INCLUDED
+#define MONTY_DISPLAY_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_framebuffer.h"
+#include "monty_nk.h"
+#include "monty_sprite.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief display width in columns */
+#define MONTY_DISPLAY_COLUMNS MONTY_FRAMEBUFFER_COLUMNS
+
+/** \brief display height in 8 pixel pages */
+#define MONTY_DISPLAY_PAGES MONTY_FRAMEBUFFER_PAGES
+
+/** \brief widest door kept as a sprite */
+#define MONTY_DISPLAY_DOOR_WIDTH 16
+
+/** \brief tallest door kept as a sprite, in pages */
+#define MONTY_DISPLAY_DOOR_PAGES 2
+
+/** \brief door and text sprites of a layout */
+typedef struct
+{
+	uint8_t closed[MONTY_DISPLAY_DOOR_PAGES * MONTY_DISPLAY_DOOR_WIDTH];
+	uint8_t open[MONTY_DISPLAY_DOOR_PAGES * MONTY_DISPLAY_DOOR_WIDTH];
+	uint8_t open_mask[MONTY_DISPLAY_DOOR_PAGES * MONTY_DISPLAY_DOOR_WIDTH];
+	monty_sprite doors[2];                       /**< Closed and open, width 0 when the doors are too big */
+	monty_sprite_font font;                      /**< Strings, added with monty_sprite_font_add() */
+} monty_display_sprites;
+
+void monty_display_sprites_init( monty_display_sprites *p_sprites, const door_coordinates *p_door );
+void monty_display_draw_door( monty_framebuffer *p_fb, const door_coordinates *p_door, uint8_t open );
+void monty_display_draw_doors( monty_framebuffer *p_fb, const monty_display_sprites *p_sprites,
+							const door_coordinates *p_doors, uint32_t door_count,
+							monty_door_set open_doors, uint32_t cursor_door );
+void monty_display_text( monty_framebuffer *p_fb, const monty_display_sprites *p_sprites, uint8_t page,
+						const char *p_text );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_DISPLAY_H_INCLUDED */
@@ -0,0 +1,123 @@
+/**
+ * \file
+ *
+ * \brief Entropy pool that turns noisy board measurements into a seed
+ *
+ */
+
+#include "monty_entropy.h"
+
+/** \brief padding word added after the last sample before an output */
+#define MONTY_ENTROPY_PAD 0x80000001u
+
+static inline uint32_t monty_entropy_rotl( uint32_t value, uint32_t bits )
+{
+	return (value << bits) | (value >> (32 - bits));
+}
+
+#define MONTY_ENTROPY_QUARTER_ROUND(s, a, b, c, d) \
+	do { \
+		s[a] += s[b]; s[d] = monty_entropy_rotl( s[d] ^ s[a], 16 ); \
+		s[c] += s[d]; s[b] = monty_entropy_rotl( s[b] ^ s[c], 12 ); \
+		s[a] += s[b]; s[d] = monty_entropy_rotl( s[d] ^ s[a], 8 ); \
+		s[c] += s[d]; s[b] = monty_entropy_rotl( s[b] ^ s[c], 7 ); \
+	} while( 0 )
+
+/** \brief ChaCha20 permutation (ten double rounds, no feed forward) */
+void monty_entropy_permute( uint32_t state[16] )
+{
+	for( uint32_t round = 0; round < 10; ++round )
+	{
+		MONTY_ENTROPY_QUARTER_ROUND( state, 0, 4, 8, 12 );
+		MONTY_ENTROPY_QUARTER_ROUND( state, 1, 5, 9, 13 );
+		MONTY_ENTROPY_QUARTER_ROUND( state, 2, 6, 10, 14 );
+		MONTY_ENTROPY_QUARTER_ROUND( state, 3, 7, 11, 15 );
+		MONTY_ENTROPY_QUARTER_ROUND( state, 0, 5, 10, 15 );
+		MONTY_ENTROPY_QUARTER_ROUND( state, 1, 6, 11, 12 );
+		MONTY_ENTROPY_QUARTER_ROUND( state, 2, 7, 8, 13 );
+		MONTY_ENTROPY_QUARTER_ROUND( state, 3, 4, 9, 14 );
+	}
+}
+
+/** \brief sets up an empty pool
+ *
+ * \param p_pool - pool to initialize
+ * \param personalization - value that tells devices or uses apart, not secret
+ */
+void monty_entropy_init( monty_entropy_pool *p_pool, uint64_t personalization )
+{
+	static const uint32_t constants[4] = { 0x61707865u, 0x3320646Eu, 0x79622D32u, 0x6B206574u };
+
+	for( uint32_t i = 0; i < 16; ++i )
+	{
+		p_pool->state[i] = 0;
+	}
+	// The constants and the personalization go into the capacity
+	for( uint32_t i = 0; i < 4; ++i )
+	{
+		p_pool->state[MONTY_ENTROPY_RATE + i] = constants[i];
+	}
+	p_pool->state[MONTY_ENTROPY_RATE + 4] = (uint32_t)personalization;
+	p_pool->state[MONTY_ENTROPY_RATE + 5] = (uint32_t)(personalization >> 32);
+	monty_entropy_permute( p_pool->state );
+
+	p_pool->position = 0;
+	p_pool->credit = 0;
+	p_pool->samples = 0;
+}
+
+/** \brief absorbs one sample
+ *
+ * \param p_pool - pool
+ * \param sample - measured value
+ * \param credit_bits - bits of entropy the sample is trusted to hold, at most 32
+ */
+void monty_entropy_add( monty_entropy_pool *p_pool, uint32_t sample, uint32_t credit_bits )
+{
+	p_pool->state[p_pool->position] ^= sample;
+	if( ++p_pool->position == MONTY_ENTROPY_RATE )
+	{
+		monty_entropy_permute( p_pool->state );
+		p_pool->position = 0;
+	}
+
+	credit_bits = (credit_bits < 32) ? credit_bits : 32;
+	p_pool->credit = (p_pool->credit + credit_bits >= p_pool->credit) ? p_pool->credit + credit_bits : UINT32_MAX;
+	p_pool->samples++;
+}
+
+/** \brief produces output from everything absorbed so far
+ *
+ * Can be called any number of times; samples added in between change the
+ * following outputs. Call monty_entropy_ready() first to know whether enough
+ * has been collected.
+ *
+ * \param p_pool - pool
+ * \param p_out - output words
+ * \param words - number of output words
+ */
+void monty_entropy_extract( monty_entropy_pool *p_pool, uint32_t *p_out, uint32_t words )
+{
+	// Padding marks where the samples end and the last capacity word that an output follows
+	p_pool->state[p_pool->position] ^= MONTY_ENTROPY_PAD;
+	p_pool->state[15] ^= 0x1;
+	p_pool->position = 0;
+
+	while( words > 0 )
+	{
+		monty_entropy_permute( p_pool->state );
+		uint32_t count = (words < MONTY_ENTROPY_RATE) ? words : MONTY_ENTROPY_RATE;
+		for( uint32_t i = 0; i < count; ++i )
+		{
+			*p_out++ = p_pool->state[i];
+		}
+		words -= count;
+	}
+
+	// Forget the output so that the state left behind does not give it away
+	for( uint32_t i = 0; i < MONTY_ENTROPY_RATE; ++i )
+	{
+		p_pool->state[i] = 0;
+	}
+	monty_entropy_permute( p_pool->state );
+}
@@ -0,0 +1,65 @@
+/**
+ * \file
+ *
+ * \brief Entropy pool that turns noisy board measurements into a seed
+ *
+ * Samples (ADC readings, temperature, clock values, cycle counts between
+ * button presses) are absorbed one 32 bit word at a time into a sponge built
+ * on the ChaCha20 permutation: a 16 word state of which the first
+ * MONTY_ENTROPY_RATE words take the samples and the rest is never output.
+ * Once the rate words are full the state is permuted. Extracting pads the
+ * pending samples, permutes, copies the output from the rate words and then
+ * permutes again with the output words cleared, so an extracted value can not
+ * be worked back into earlier ones.
+ *
+ * Every sample comes with the number of bits of entropy it is credited with,
+ * a deliberately low estimate. The pool is ready once MONTY_ENTROPY_READY_BITS
+ * have been credited. A sample credited with 0 bits (a clock, a serial number)
+ * still changes every later output.
+ *
+ * The pool has no board dependencies: the firmware feeds it from the
+ * hardware, host/monty_entropy_test.c feeds it test patterns and checks the
+ * output.
+ *
+ */
+
+#ifndef MONTY_ENTROPY_H_INCLUDED
+#define MONTY_ENTROPY_H_INCLUDED
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief words of the state that take samples and give output */
+#define MONTY_ENTROPY_RATE 8
+
+/** \brief credited bits after which the pool is ready */
+#define MONTY_ENTROPY_READY_BITS 128
+
+/** \brief entropy pool */
+typedef struct
+{
+	uint32_t state[16];    /**< ChaCha state, MONTY_ENTROPY_RATE rate words followed by the capacity */
+	uint32_t position;     /**< Next rate word a sample goes into */
+	uint32_t credit;       /**< Bits of entropy credited so far, saturating */
+	uint32_t samples;      /**< Samples absorbed so far */
+} monty_entropy_pool;
+
+void monty_entropy_init( monty_entropy_pool *p_pool, uint64_t personalization );
+void monty_entropy_add( monty_entropy_pool *p_pool, uint32_t sample, uint32_t credit_bits );
+void monty_entropy_extract( monty_entropy_pool *p_pool, uint32_t *p_out, uint32_t words );
+void monty_entropy_permute( uint32_t state[16] );
+
+/** \brief non-zero once MONTY_ENTROPY_READY_BITS have been credited */
+static inline int monty_entropy_ready( const monty_entropy_pool *p_pool )
+{
+	return p_pool->credit >= MONTY_ENTROPY_READY_BITS;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_ENTROPY_H_INCLUDED */
@@ -0,0 +1,191 @@
+/**
+ * \file
+ *
+ * \brief Framebuffer flush to the SSD1306 in the background over the SPI PDC
+ *
+ */
+
+#include <stddef.h>
+
+#include "ssd1306.h"
+#include "monty_flush.h"
+
+/** \brief sets up an idle flush
+ *
+ * The SPI interrupt has to be enabled in the NVIC and call
+ * monty_flush_interrupt().
+ *
+ * \param p_flush - flush
+ * \param done - called from the interrupt after each flush, NULL for none
+ * \param p_done_context - passed to done
+ */
+void monty_flush_init( monty_flush *p_flush, monty_flush_done_fn done, void *p_done_context )
+{
+	p_flush->count = 0;
+	p_flush->next = 0;
+	p_flush->busy = 0;
+	p_flush->flushes = 0;
+	p_flush->done = done;
+	p_flush->p_done_context = p_done_context;
+}
+
+/** \brief queues one segment, the caller checks that there is room */
+static inline void monty_flush_add_segment( monty_flush *p_flush, const uint8_t *p_bytes, uint32_t length,
+											uint8_t data )
+{
+	monty_flush_segment *p_segment = &p_flush->segments[p_flush->count++];
+
+	p_segment->p_bytes = p_bytes;
+	p_segment->length = (uint16_t)length;
+	p_segment->data = data;
+}
+
+/** \brief queues a run of display data and the address in front of it
+ *
+ * Only while the flush is idle. The data has to stay unchanged until the
+ * flush is done. The panel has to be in page addressing mode, as
+ * ssd1306_init() leaves it.
+ *
+ * \param p_flush - flush
+ * \param page - page of the run
+ * \param column - first column of the run
+ * \param p_data - display data
+ * \param length - bytes, 1..128
+ * \returns 0 if everything is okay, -1 when the queue is full
+ */
+int32_t monty_flush_add_run( monty_flush *p_flush, uint8_t page, uint8_t column, const uint8_t *p_data,
+							uint32_t length )
+{
+	uint32_t run = p_flush->count / 2;
+
+	if( p_flush->count + 2 > 2 * MONTY_FLUSH_RUNS )
+	{
+		return -1;
+	}
+	uint8_t *p_command = p_flush->commands[run];
+	ssd1306_page_commands( p_command, page, column );
+
+	monty_flush_add_segment( p_flush, p_command, MONTY_FLUSH_COMMAND_BYTES, 0 );
+	monty_flush_add_segment( p_flush, p_data, length, 1 );
+	return 0;
+}
+
+/** \brief queues a rectangle of display data as one window
+ *
+ * Only while the flush is idle. The data has to stay unchanged until the
+ * flush is done. The controller is switched to horizontal addressing for the
+ * window and back to page addressing after it, as ssd1306_blit() does.
+ *
+ * \param p_flush - flush
+ * \param column - first column of the window
+ * \param page - first page of the window
+ * \param width - columns, 1..128
+ * \param pages - pages, 1..4
+ * \param p_data - display data, width bytes for each page in turn
+ * \returns 0 if everything is okay, -1 when the queue is full
+ */
+int32_t monty_flush_add_window( monty_flush *p_flush, uint8_t column, uint8_t page, uint8_t width, uint8_t pages,
+							   const uint8_t *p_data )
+{
+	static const uint8_t page_mode[2] = { SSD1306_CMD_SET_MEMORY_ADDRESSING_MODE, SSD1306_ADDRESSING_PAGE };
+	uint32_t window = p_flush->count / 2;
+
+	if( p_flush->count + 3 > 2 * MONTY_FLUSH_RUNS )
+	{
+		return -1;
+	}
+	uint8_t *p_command = p_flush->commands[window];
+	p_command[0] = SSD1306_CMD_SET_MEMORY_ADDRESSING_MODE;
+	p_command[1] = SSD1306_ADDRESSING_HORIZONTAL;
+	ssd1306_window_commands( &p_command[2], column, column + width - 1, page, page + pages - 1 );
+
+	monty_flush_add_segment( p_flush, p_command, MONTY_FLUSH_WINDOW_COMMAND_BYTES, 0 );
+	monty_flush_add_segment( p_flush, p_data, (uint32_t)width * pages, 1 );
+	monty_flush_add_segment( p_flush, page_mode, sizeof(page_mode), 0 );
+	return 0;
+}
+
+/** \brief hands the next segment to the PDC and waits for its end in the background */
+static void monty_flush_next_segment( monty_flush *p_flush )
+{
+	const monty_flush_segment *p_segment = &p_flush->segments[p_flush->next++];
+	Spi *p_spi = SSD1306_SPI;
+	Pdc *p_pdc = spi_get_pdc_base( p_spi );
+
+	if( p_segment->data )
+	{
+		ssd1306_sel_data();
+	}
+	else
+	{
+		ssd1306_sel_cmd();
+	}
+	p_pdc->PERIPH_TPR = (uintptr_t)p_segment->p_bytes;
+	p_pdc->PERIPH_TCR = p_segment->length;
+	p_pdc->PERIPH_PTCR = PERIPH_PTCR_TXTEN;
+	p_spi->SPI_IER = SPI_IER_ENDTX;
+}
+
+/** \brief starts sending the queued segments, returns at once
+ *
+ * Nothing happens when nothing is queued.
+ *
+ * \param p_flush - flush
+ */
+void monty_flush_start( monty_flush *p_flush )
+{
+	struct spi_device device = { .id = SSD1306_CS_PIN };
+
+	if( p_flush->count == 0 )
+	{
+		return;
+	}
+	p_flush->next = 0;
+	p_flush->busy = 1;
+	spi_select_device( SSD1306_SPI, &device );
+	monty_flush_next_segment( p_flush );
+}
+
+/** \brief SPI interrupt: moves on to the next segment once the current one is out
+ *
+ * The PDC is done with a segment (ENDTX) before its last byte has been
+ * shifted out, and D/C# may only change after that (TXEMPTY), so each
+ * segment takes two interrupts.
+ *
+ * \param p_flush - flush
+ */
+void monty_flush_interrupt( monty_flush *p_flush )
+{
+	Spi *p_spi = SSD1306_SPI;
+	uint32_t status = p_spi->SPI_SR & p_spi->SPI_IMR;
+
+	if( status & SPI_SR_ENDTX )
+	{
+		p_spi->SPI_IDR = SPI_IDR_ENDTX;
+		p_spi->SPI_IER = SPI_IER_TXEMPTY;
+		return;
+	}
+	if( !(status & SPI_SR_TXEMPTY) )
+	{
+		return;
+	}
+
+	p_spi->SPI_IDR = SPI_IDR_TXEMPTY;
+	spi_get_pdc_base( p_spi )->PERIPH_PTCR = PERIPH_PTCR_TXTDIS;
+	if( p_flush->next < p_flush->count )
+	{
+		monty_flush_next_segment( p_flush );
+		return;
+	}
+
+	struct spi_device device = { .id = SSD1306_CS_PIN };
+	ssd1306_sel_cmd();
+	spi_deselect_device( p_spi, &device );
+	p_flush->count = 0;
+	p_flush->flushes++;
+	p_flush->busy = 0;
+	if( p_flush->done != NULL )
+	{
+		p_flush->done( p_flush->p_done_context );
+	}
+}
@@ -0,0 +1,92 @@
+/**
+ * \file
+ *
+ * \brief Framebuffer flush to the SSD1306 in the background over the SPI PDC
+ *
+ * monty_framebuffer_flush_async() queues the runs of changed bytes as
+ * segments, a three byte command segment (page and column address) and a data
+ * segment for each, or the changed pages whole as one window: a command
+ * segment that switches to horizontal addressing and sets the window (see
+ * ssd1306_blit()), the data and a command segment back to page addressing.
+ * monty_flush_start() hands the first segment to the PDC.
+ * From then on monty_flush_interrupt(), called from the SPI interrupt, sets
+ * D/C# and starts the next segment each time one has left the shifter, and
+ * calls the done callback after the last.
+ *
+ * The data segments point into the framebuffer's copy of the panel, which
+ * the flush leaves alone while a transfer is in flight, so the next frame is
+ * drawn into the framebuffer meanwhile. The main loop never waits for the bus.
+ *
+ * Only the SPI and PDC registers are used, through the names of the SAM4S
+ * headers; host/ssd1306_mock.h models them so the flow runs on the host.
+ *
+ */
+
+#ifndef MONTY_FLUSH_H_INCLUDED
+#define MONTY_FLUSH_H_INCLUDED
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief runs of changed bytes one flush can carry */
+#define MONTY_FLUSH_RUNS 24
+
+/** \brief bytes in front of each run: page, column high and column low */
+#define MONTY_FLUSH_COMMAND_BYTES 3
+
+/** \brief bytes in front of a window: horizontal mode, column and page range */
+#define MONTY_FLUSH_WINDOW_COMMAND_BYTES 8
+
+/** \brief unchanged bytes inside a run that are sent again rather than starting a new run
+ *
+ * A new run costs its three address bytes and two more segments, each ended
+ * by two interrupts, about as long as five bytes on the bus.
+ */
+#define MONTY_FLUSH_MAX_GAP 5
+
+/** \brief called from the interrupt after the last segment of a flush */
+typedef void (*monty_flush_done_fn)( void *p_context );
+
+/** \brief one PDC transfer */
+typedef struct
+{
+	const uint8_t *p_bytes;
+	uint16_t length;
+	uint8_t data;                       /**< D/C# level, 1 for display data */
+} monty_flush_segment;
+
+/** \brief flush in flight or being queued */
+typedef struct
+{
+	monty_flush_segment segments[2 * MONTY_FLUSH_RUNS];
+	uint8_t commands[MONTY_FLUSH_RUNS][MONTY_FLUSH_WINDOW_COMMAND_BYTES];
+	uint32_t count;                     /**< Segments queued */
+	volatile uint32_t next;             /**< Next segment to start */
+	volatile uint32_t busy;             /**< Non-zero from monty_flush_start() to the end of the last segment */
+	volatile uint32_t flushes;          /**< Flushes completed */
+	monty_flush_done_fn done;
+	void *p_done_context;
+} monty_flush;
+
+void monty_flush_init( monty_flush *p_flush, monty_flush_done_fn done, void *p_done_context );
+int32_t monty_flush_add_run( monty_flush *p_flush, uint8_t page, uint8_t column, const uint8_t *p_data,
+							uint32_t length );
+int32_t monty_flush_add_window( monty_flush *p_flush, uint8_t column, uint8_t page, uint8_t width, uint8_t pages,
+							   const uint8_t *p_data );
+void monty_flush_start( monty_flush *p_flush );
+void monty_flush_interrupt( monty_flush *p_flush );
+
+/** \brief non-zero while a flush is in flight */
+static inline uint32_t monty_flush_busy( const monty_flush *p_flush )
+{
+	return p_flush->busy;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_FLUSH_H_INCLUDED */
@@ -0,0 +1,413 @@
+/**
+ * \file
+ *
+ * \brief Framebuffer in RAM for the 128x32 SSD1306 OLED
+ *
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "ssd1306.h"
+#include "font.h"
+#include "monty_framebuffer.h"
+
+/** \brief widens the dirty range of a page to take in a column */
+static inline void monty_framebuffer_mark( monty_framebuffer *p_fb, uint8_t page, uint8_t first, uint8_t last )
+{
+	if( first < p_fb->dirty_first[page] )
+	{
+		p_fb->dirty_first[page] = first;
+	}
+	if( last > p_fb->dirty_last[page] )
+	{
+		p_fb->dirty_last[page] = last;
+	}
+}
+
+/** \brief marks a page as clean */
+static inline void monty_framebuffer_clean_page( monty_framebuffer *p_fb, uint8_t page )
+{
+	p_fb->dirty_first[page] = MONTY_FRAMEBUFFER_COLUMNS;
+	p_fb->dirty_last[page] = 0;
+}
+
+/** \brief sets up a blank framebuffer for a panel that has just been cleared
+ *
+ * \param p_fb - framebuffer
+ */
+void monty_framebuffer_init( monty_framebuffer *p_fb )
+{
+	memset( p_fb->pixels, 0, sizeof(p_fb->pixels) );
+	memset( p_fb->panel, 0, sizeof(p_fb->panel) );
+	for( uint8_t page = 0; page < MONTY_FRAMEBUFFER_PAGES; ++page )
+	{
+		monty_framebuffer_clean_page( p_fb, page );
+	}
+}
+
+/** \brief tells the framebuffer that the panel was cleared behind its back (ssd1306_clear())
+ *
+ * The next flush sends everything drawn that is not blank.
+ *
+ * \param p_fb - framebuffer
+ */
+void monty_framebuffer_panel_cleared( monty_framebuffer *p_fb )
+{
+	memset( p_fb->panel, 0, sizeof(p_fb->panel) );
+	for( uint8_t page = 0; page < MONTY_FRAMEBUFFER_PAGES; ++page )
+	{
+		monty_framebuffer_mark( p_fb, page, 0, MONTY_FRAMEBUFFER_COLUMNS - 1 );
+	}
+}
+
+/** \brief blanks the whole screen
+ *
+ * \param p_fb - framebuffer
+ */
+void monty_framebuffer_clear( monty_framebuffer *p_fb )
+{
+	memset( p_fb->pixels, 0, sizeof(p_fb->pixels) );
+	for( uint8_t page = 0; page < MONTY_FRAMEBUFFER_PAGES; ++page )
+	{
+		monty_framebuffer_mark( p_fb, page, 0, MONTY_FRAMEBUFFER_COLUMNS - 1 );
+	}
+}
+
+/** \brief sets one column of 8 pixels
+ *
+ * \param p_fb - framebuffer
+ * \param page - page, anything past the panel is ignored
+ * \param column - column, anything past the panel is ignored
+ * \param data - pixels, bit 0 at the top
+ */
+void monty_framebuffer_put( monty_framebuffer *p_fb, uint8_t page, uint8_t column, uint8_t data )
+{
+	if( (page < MONTY_FRAMEBUFFER_PAGES) && (column < MONTY_FRAMEBUFFER_COLUMNS) )
+	{
+		p_fb->pixels[page][column] = data;
+		monty_framebuffer_mark( p_fb, page, column, column );
+	}
+}
+
+/** \brief sets a run of columns of a page to the same 8 pixels
+ *
+ * \param p_fb - framebuffer
+ * \param page - page, anything past the panel is ignored
+ * \param column - first column
+ * \param width - number of columns, cut at the edge of the panel
+ * \param data - pixels, bit 0 at the top
+ */
+void monty_framebuffer_fill( monty_framebuffer *p_fb, uint8_t page, uint8_t column, uint8_t width, uint8_t data )
+{
+	if( (page >= MONTY_FRAMEBUFFER_PAGES) || (column >= MONTY_FRAMEBUFFER_COLUMNS) || (width == 0) )
+	{
+		return;
+	}
+	if( width > MONTY_FRAMEBUFFER_COLUMNS - column )
+	{
+		width = MONTY_FRAMEBUFFER_COLUMNS - column;
+	}
+	memset( &p_fb->pixels[page][column], data, width );
+	monty_framebuffer_mark( p_fb, page, column, column + width - 1 );
+}
+
+/** \brief copies an image of whole pages to the screen
+ *
+ * \param p_fb - framebuffer
+ * \param column - first column
+ * \param page - first page
+ * \param width - columns of the image, cut at the edge of the panel
+ * \param pages - pages of the image, cut at the edge of the panel
+ * \param p_image - width bytes for each page in turn, bit 0 at the top
+ */
+void monty_framebuffer_blit( monty_framebuffer *p_fb, uint8_t column, uint8_t page, uint8_t width, uint8_t pages,
+							 const uint8_t *p_image )
+{
+	if( (page >= MONTY_FRAMEBUFFER_PAGES) || (column >= MONTY_FRAMEBUFFER_COLUMNS) || (width == 0) )
+	{
+		return;
+	}
+	uint8_t visible = width;
+	if( visible > MONTY_FRAMEBUFFER_COLUMNS - column )
+	{
+		visible = MONTY_FRAMEBUFFER_COLUMNS - column;
+	}
+	for( ; (pages > 0) && (page < MONTY_FRAMEBUFFER_PAGES); --pages, ++page, p_image += width )
+	{
+		// Sprites are a few bytes wide, a plain loop beats the call into memcpy()
+		uint8_t *p_pixels = &p_fb->pixels[page][column];
+		for( uint8_t i = 0; i < visible; ++i )
+		{
+			p_pixels[i] = p_image[i];
+		}
+		monty_framebuffer_mark( p_fb, page, column, column + visible - 1 );
+	}
+}
+
+/** \brief copies an image of whole pages to the screen through a mask
+ *
+ * Only the pixels whose mask bit is set are copied, the others keep what is
+ * on the screen.
+ *
+ * \param p_fb - framebuffer
+ * \param column - first column
+ * \param page - first page
+ * \param width - columns of the image, cut at the edge of the panel
+ * \param pages - pages of the image, cut at the edge of the panel
+ * \param p_image - width bytes for each page in turn, bit 0 at the top
+ * \param p_mask - same layout as the image, NULL to copy every pixel
+ */
+void monty_framebuffer_blit_masked( monty_framebuffer *p_fb, uint8_t column, uint8_t page, uint8_t width,
+									uint8_t pages, const uint8_t *p_image, const uint8_t *p_mask )
+{
+	if( p_mask == NULL )
+	{
+		monty_framebuffer_blit( p_fb, column, page, width, pages, p_image );
+		return;
+	}
+	if( (page >= MONTY_FRAMEBUFFER_PAGES) || (column >= MONTY_FRAMEBUFFER_COLUMNS) || (width == 0) )
+	{
+		return;
+	}
+	uint8_t visible = width;
+	if( visible > MONTY_FRAMEBUFFER_COLUMNS - column )
+	{
+		visible = MONTY_FRAMEBUFFER_COLUMNS - column;
+	}
+	for( ; (pages > 0) && (page < MONTY_FRAMEBUFFER_PAGES); --pages, ++page, p_image += width, p_mask += width )
+	{
+		uint8_t *p_pixels = &p_fb->pixels[page][column];
+		for( uint8_t i = 0; i < visible; ++i )
+		{
+			p_pixels[i] = (uint8_t)((p_pixels[i] & ~p_mask[i]) | (p_image[i] & p_mask[i]));
+		}
+		monty_framebuffer_mark( p_fb, page, column, column + visible - 1 );
+	}
+}
+
+/** \brief writes text in the ASF font
+ *
+ * Same as ssd1306_write_text() after setting the address: each character's
+ * font columns followed by a blank column, wrapping around within the page.
+ *
+ * \param p_fb - framebuffer
+ * \param page - page (text row)
+ * \param column - column of the first character
+ * \param p_text - text, characters outside the font are skipped
+ * \returns column after the text
+ */
+uint8_t monty_framebuffer_text( monty_framebuffer *p_fb, uint8_t page, uint8_t column, const char *p_text )
+{
+	for( ; *p_text != 0; ++p_text )
+	{
+		if( (*p_text < ' ') || (*p_text > '~') )
+		{
+			continue;
+		}
+		const uint8_t *p_glyph = font_table[*p_text - ' '];
+		for( uint8_t i = 1; i <= p_glyph[0]; ++i )
+		{
+			monty_framebuffer_put( p_fb, page, column, p_glyph[i] );
+			column = (column + 1) & (MONTY_FRAMEBUFFER_COLUMNS - 1);
+		}
+		monty_framebuffer_put( p_fb, page, column, 0x00 );
+		column = (column + 1) & (MONTY_FRAMEBUFFER_COLUMNS - 1);
+	}
+	return column;
+}
+
+/** \brief finds the next run of changed bytes in the dirty range of a page
+ *
+ * A run carries on over up to max_gap unchanged bytes, which cost less to
+ * send again than the address and burst of a new run.
+ *
+ * \param p_fb - framebuffer
+ * \param page - page
+ * \param max_gap - cost of a new run, in data bytes
+ * \param p_column - column to look from, moved on past the run
+ * \param p_start - first column of the run
+ * \returns length of the run, 0 when the rest of the range is unchanged
+ */
+static uint32_t monty_framebuffer_next_run( const monty_framebuffer *p_fb, uint8_t page, uint32_t max_gap,
+											uint32_t *p_column, uint32_t *p_start )
+{
+	const uint8_t *p_pixels = p_fb->pixels[page];
+	const uint8_t *p_panel = p_fb->panel[page];
+	uint32_t last = p_fb->dirty_last[page];
+	uint32_t column = *p_column;
+
+	while( (column <= last) && (p_pixels[column] == p_panel[column]) )
+	{
+		column++;
+	}
+	if( column > last )
+	{
+		*p_column = column;
+		return 0;
+	}
+
+	uint32_t start = column;
+	uint32_t end = column;
+	for( column = start + 1; (column <= last) && (column - end <= max_gap + 1); ++column )
+	{
+		if( p_pixels[column] != p_panel[column] )
+		{
+			end = column;
+		}
+	}
+	*p_column = column;
+	*p_start = start;
+	return end - start + 1;
+}
+
+/** \brief finds out whether the changes are cheaper to send as whole pages
+ *
+ * Each run costs its bytes and the overhead of its address and burst. The
+ * band of whole pages from the first to the last page with changes is
+ * contiguous in the framebuffer and goes out as one window and one burst,
+ * with the addressing mode switched around them for about twice the overhead
+ * of a run, which wins once most of the screen changed.
+ *
+ * \param p_fb - framebuffer
+ * \param overhead - cost of the address and burst of a run, in data bytes
+ * \param p_first - first page of the band
+ * \returns pages in the band, 0 when sending the runs is cheaper or nothing changed
+ */
+static uint8_t monty_framebuffer_band( const monty_framebuffer *p_fb, uint32_t overhead, uint8_t *p_first )
+{
+	uint32_t runs_cost = 0;
+	uint8_t first = MONTY_FRAMEBUFFER_PAGES;
+	uint8_t last = 0;
+
+	for( uint8_t page = 0; page < MONTY_FRAMEBUFFER_PAGES; ++page )
+	{
+		uint32_t column = p_fb->dirty_first[page];
+		uint32_t start = 0;
+		uint32_t length;
+
+		while( (length = monty_framebuffer_next_run( p_fb, page, overhead, &column, &start )) != 0 )
+		{
+			runs_cost += length + overhead;
+			if( first == MONTY_FRAMEBUFFER_PAGES )
+			{
+				first = page;
+			}
+			last = page;
+		}
+	}
+	if( first == MONTY_FRAMEBUFFER_PAGES )
+	{
+		return 0;
+	}
+
+	uint8_t pages = last - first + 1;
+	if( (uint32_t)pages * MONTY_FRAMEBUFFER_COLUMNS + 2 * overhead > runs_cost )
+	{
+		return 0;
+	}
+	*p_first = first;
+	return pages;
+}
+
+/** \brief marks every page as clean once the band has been sent */
+static void monty_framebuffer_band_sent( monty_framebuffer *p_fb, uint8_t first, uint8_t pages )
+{
+	memcpy( p_fb->panel[first], p_fb->pixels[first], (uint32_t)pages * MONTY_FRAMEBUFFER_COLUMNS );
+	for( uint8_t page = 0; page < MONTY_FRAMEBUFFER_PAGES; ++page )
+	{
+		monty_framebuffer_clean_page( p_fb, page );
+	}
+}
+
+/** \brief sends what changed since the last flush to the panel and waits for it
+ *
+ * Each run of changed bytes is sent as its page and column address and one
+ * burst (ssd1306_blit() of a single page), or the pages with changes as a
+ * single window when that costs less. Must not be called while an asynchronous flush is in flight.
+ *
+ * \param p_fb - framebuffer
+ * \returns number of data bytes sent
+ */
+uint32_t monty_framebuffer_flush( monty_framebuffer *p_fb )
+{
+	uint32_t sent = 0;
+	uint8_t first = 0;
+	uint8_t pages = monty_framebuffer_band( p_fb, MONTY_FRAMEBUFFER_MAX_GAP, &first );
+
+	if( pages != 0 )
+	{
+		ssd1306_blit( 0, first, MONTY_FRAMEBUFFER_COLUMNS, pages, p_fb->pixels[first] );
+		monty_framebuffer_band_sent( p_fb, first, pages );
+		return (uint32_t)pages * MONTY_FRAMEBUFFER_COLUMNS;
+	}
+
+	for( uint8_t page = 0; page < MONTY_FRAMEBUFFER_PAGES; ++page )
+	{
+		uint32_t column = p_fb->dirty_first[page];
+		uint32_t start = 0;
+		uint32_t length;
+
+		while( (length = monty_framebuffer_next_run( p_fb, page, MONTY_FRAMEBUFFER_MAX_GAP, &column, &start )) != 0 )
+		{
+			ssd1306_blit( (uint8_t)start, page, (uint8_t)length, 1, &p_fb->pixels[page][start] );
+			memcpy( &p_fb->panel[page][start], &p_fb->pixels[page][start], length );
+			sent += length;
+		}
+		monty_framebuffer_clean_page( p_fb, page );
+	}
+	return sent;
+}
+
+/** \brief starts sending what changed since the last flush in the background
+ *
+ * The runs of changed bytes, or the pages with changes when that costs less
+ * (see monty_framebuffer_flush()), are copied to the framebuffer's copy of the
+ * panel and queued on the flush, which sends them from there while
+ * drawing goes on. If there are more runs than the flush takes, the rest stays
+ * dirty for the next call.
+ *
+ * \param p_fb - framebuffer
+ * \param p_flush - flush to send with
+ * \returns 0 if the changes are on their way (or there were none), -1 while
+ * the previous flush is still in flight, the changes then stay for the next call
+ */
+int32_t monty_framebuffer_flush_async( monty_framebuffer *p_fb, monty_flush *p_flush )
+{
+	if( monty_flush_busy( p_flush ) )
+	{
+		return -1;
+	}
+
+	// No driver latency between segments here, a run costs its address and segment changes
+	uint8_t first = 0;
+	uint8_t pages = monty_framebuffer_band( p_fb, MONTY_FLUSH_MAX_GAP, &first );
+	if( pages != 0 )
+	{
+		monty_framebuffer_band_sent( p_fb, first, pages );
+		monty_flush_add_window( p_flush, 0, first, MONTY_FRAMEBUFFER_COLUMNS, pages, p_fb->panel[first] );
+		monty_flush_start( p_flush );
+		return 0;
+	}
+
+	for( uint8_t page = 0; page < MONTY_FRAMEBUFFER_PAGES; ++page )
+	{
+		uint32_t column = p_fb->dirty_first[page];
+		uint32_t start = 0;
+		uint32_t length;
+
+		while( (length = monty_framebuffer_next_run( p_fb, page, MONTY_FLUSH_MAX_GAP, &column, &start )) != 0 )
+		{
+			if( monty_flush_add_run( p_flush, page, (uint8_t)start, &p_fb->panel[page][start], length ) != 0 )
+			{
+				p_fb->dirty_first[page] = (uint8_t)start;
+				monty_flush_start( p_flush );
+				return 0;
+			}
+			memcpy( &p_fb->panel[page][start], &p_fb->pixels[page][start], length );
+		}
+		monty_framebuffer_clean_page( p_fb, page );
+	}
+	monty_flush_start( p_flush );
+	return 0;
+}
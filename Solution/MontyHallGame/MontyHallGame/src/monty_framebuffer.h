@@ -0,0 +1,73 @@
+/**
+ * \file
+ *
+ * \brief Framebuffer in RAM for the 128x32 SSD1306 OLED
+ *
+ * Drawing goes into a copy of the screen in RAM instead of straight out over
+ * SPI, in the controller's own layout: one byte per column of each 8 pixel
+ * page, bit 0 at the top. Every drawing call widens the dirty column range of
+ * the pages it touches. monty_framebuffer_flush() then compares the dirty
+ * ranges with a second copy of what the panel already shows and sends only
+ * the bytes that changed, a page and column address and a burst per run of
+ * changes, so clearing the screen and drawing it again costs only what
+ * actually moved. When most of the screen changed, the pages with changes go
+ * out whole as a single window and burst instead (ssd1306_blit()).
+ *
+ * Only the flush talks to the controller: monty_framebuffer_flush() through
+ * the ssd1306_* calls of the ASF driver (on the host against the model of
+ * host/ssd1306_mock.h) and monty_framebuffer_flush_async() by queueing the runs on
+ * a PDC transfer in the background (monty_flush.h).
+ *
+ */
+
+#ifndef MONTY_FRAMEBUFFER_H_INCLUDED
+#define MONTY_FRAMEBUFFER_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_flush.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief panel width in columns */
+#define MONTY_FRAMEBUFFER_COLUMNS 128
+
+/** \brief panel height in 8 pixel pages */
+#define MONTY_FRAMEBUFFER_PAGES 4
+
+/** \brief unchanged bytes inside a run that are sent again rather than starting a new run
+ *
+ * A new run costs a three byte address and a burst, each with the driver's
+ * 10 us latency, about as long as 15 data bytes at 5 MHz.
+ */
+#define MONTY_FRAMEBUFFER_MAX_GAP 15
+
+/** \brief screen in RAM */
+typedef struct
+{
+	uint8_t pixels[MONTY_FRAMEBUFFER_PAGES][MONTY_FRAMEBUFFER_COLUMNS];   /**< Screen as drawn */
+	uint8_t panel[MONTY_FRAMEBUFFER_PAGES][MONTY_FRAMEBUFFER_COLUMNS];    /**< Screen as the panel shows it */
+	uint8_t dirty_first[MONTY_FRAMEBUFFER_PAGES];   /**< First column drawn on since the last flush */
+	uint8_t dirty_last[MONTY_FRAMEBUFFER_PAGES];    /**< Last column, below dirty_first when the page is clean */
+} monty_framebuffer;
+
+void monty_framebuffer_init( monty_framebuffer *p_fb );
+void monty_framebuffer_panel_cleared( monty_framebuffer *p_fb );
+void monty_framebuffer_clear( monty_framebuffer *p_fb );
+void monty_framebuffer_put( monty_framebuffer *p_fb, uint8_t page, uint8_t column, uint8_t data );
+void monty_framebuffer_fill( monty_framebuffer *p_fb, uint8_t page, uint8_t column, uint8_t width, uint8_t data );
+void monty_framebuffer_blit( monty_framebuffer *p_fb, uint8_t column, uint8_t page, uint8_t width, uint8_t pages,
+							 const uint8_t *p_image );
+void monty_framebuffer_blit_masked( monty_framebuffer *p_fb, uint8_t column, uint8_t page, uint8_t width,
+									uint8_t pages, const uint8_t *p_image, const uint8_t *p_mask );
+uint8_t monty_framebuffer_text( monty_framebuffer *p_fb, uint8_t page, uint8_t column, const char *p_text );
+uint32_t monty_framebuffer_flush( monty_framebuffer *p_fb );
+int32_t monty_framebuffer_flush_async( monty_framebuffer *p_fb, monty_flush *p_flush );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_FRAMEBUFFER_H_INCLUDED */
@@ -0,0 +1,244 @@
+/**
+ * \file
+ *
+ * \brief Monty Hall game core (door picking and game state machine)
+ *
+ * Copyright (c) 2013 Atmel Corporation. All rights reserved.
+ *
+ * \asf_license_start
+ *
+ * \page License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. The name of Atmel may not be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * 4. This software may only be redistributed and used in connection with an
+ *    Atmel microcontroller product.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * EXPRESSLY AND SPECIFICALLY DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \asf_license_stop
+ *
+ */
+
+#include "monty_hall.h"
+
+/**
+ * \brief Door Monty opens, as a constant expression
+ *
+ * If the player missed the prize Monty opens the one door that is neither
+ * picked nor the prize. If the player picked the prize Monty's coin decides:
+ * 0 opens the lower of the two other doors, 1 the higher one. Door 0 stands
+ * for an invalid door and gives DOOR_NOT_PRESSED.
+ */
+#define MONTY_OPEN_DOOR(w, f, c) \
+	( (((w) == 0) || ((f) == 0)) ? DOOR_NOT_PRESSED : \
+	  ((w) != (f)) ? (6 - (w) - (f)) : \
+	  (c) ? (((f) == 3) ? 2 : 3) : (((f) == 1) ? 2 : 1) )
+
+/** \brief a valid open door is a real door that is neither the prize nor the player's pick */
+#define MONTY_OPEN_DOOR_VALID(w, f, c) \
+	( (MONTY_OPEN_DOOR(w, f, c) >= DOOR_PRESSED_MIN) && (MONTY_OPEN_DOOR(w, f, c) <= DOOR_PRESSED_MAX) && \
+	  (MONTY_OPEN_DOOR(w, f, c) != (w)) && (MONTY_OPEN_DOOR(w, f, c) != (f)) )
+
+#define MONTY_OPEN_DOOR_VALID_ROW(w) \
+	( MONTY_OPEN_DOOR_VALID(w, 1, 0) && MONTY_OPEN_DOOR_VALID(w, 1, 1) && \
+	  MONTY_OPEN_DOOR_VALID(w, 2, 0) && MONTY_OPEN_DOOR_VALID(w, 2, 1) && \
+	  MONTY_OPEN_DOOR_VALID(w, 3, 0) && MONTY_OPEN_DOOR_VALID(w, 3, 1) )
+
+_Static_assert( MONTY_OPEN_DOOR_VALID_ROW(1) && MONTY_OPEN_DOOR_VALID_ROW(2) && MONTY_OPEN_DOOR_VALID_ROW(3),
+				"Monty must open a door that is neither the prize nor the player's pick" );
+_Static_assert( (MONTY_OPEN_DOOR(1, 1, 0) != MONTY_OPEN_DOOR(1, 1, 1)) &&
+				(MONTY_OPEN_DOOR(2, 2, 0) != MONTY_OPEN_DOOR(2, 2, 1)) &&
+				(MONTY_OPEN_DOOR(3, 3, 0) != MONTY_OPEN_DOOR(3, 3, 1)),
+				"Monty's coin must choose between both doors when the player picked the prize" );
+
+#define MONTY_OPEN_DOOR_COINS(w, f) { MONTY_OPEN_DOOR(w, f, 0), MONTY_OPEN_DOOR(w, f, 1) }
+#define MONTY_OPEN_DOOR_ROW(w) \
+	{ MONTY_OPEN_DOOR_COINS(w, 0), MONTY_OPEN_DOOR_COINS(w, 1), MONTY_OPEN_DOOR_COINS(w, 2), MONTY_OPEN_DOOR_COINS(w, 3) }
+
+/** \brief door Monty opens, indexed by [winning_door][first_door][coin] */
+const uint8_t monty_open_door_table[4][4][2] =
+{
+	MONTY_OPEN_DOOR_ROW(0),
+	MONTY_OPEN_DOOR_ROW(1),
+	MONTY_OPEN_DOOR_ROW(2),
+	MONTY_OPEN_DOOR_ROW(3)
+};
+
+/** \brief Monty door picking algorithm
+ *
+ * Table driven and branch free. Monty's coin is always tossed, so every game
+ * draws the same number of random values.
+ *
+ * \param winning_door - door that has the big prize
+ * \param first_door - door the player selected first
+ * \returns The door Monty wants to open
+ */
+uint32_t pick_open_door( uint32_t winning_door, uint32_t first_door )
+{
+	return pick_open_door_coin( winning_door, first_door, monty_hall_rand() & 0x1 );
+}
+
+/** \brief Monty door picking algorithm, original branching version
+ *
+ * Kept as the reference the table is checked against. Only tosses the coin
+ * when the player picked the prize.
+ *
+ * \param winning_door - door that has the big prize
+ * \param first_door - door the player selected first
+ * \returns The door Monty wants to open
+ */
+uint32_t pick_open_door_reference( uint32_t winning_door, uint32_t first_door )
+{
+	uint32_t open_door = DOOR_NOT_PRESSED;
+	if( first_door != winning_door )
+	{
+		// Since the winning door is not the selected door,
+		//  we need simply pick the opposite unselected door
+		//  There is probably a more efficient algorithm for this,
+		//  but this will work for now.
+		if (first_door == 1)
+		{
+			if (winning_door == 2)
+			{
+				open_door = 3;
+			}
+			else
+			{
+				open_door = 2;
+			}
+		}
+		else if (first_door == 2)
+		{
+			if (winning_door == 3)
+			{
+				open_door = 1;
+			}
+			else
+			{
+				open_door = 3;
+			}
+		}
+		else if (first_door == 3)
+		{
+			if (winning_door == 1)
+			{
+				open_door = 2;
+			}
+			else
+			{
+				open_door = 1;
+			}
+		}
+	}
+	else
+	{
+		open_door = 1;
+		if( open_door == winning_door )
+		{
+			// we can't pick this door, since it is the winning one
+			open_door++;
+		}
+		
+		// Since Monty can open either door, we need to randomly select
+		//  a door.
+		uint32_t random_value = monty_hall_rand();
+		if( random_value & 0x1 )
+		{
+			open_door++;
+		}
+		if( open_door == winning_door )
+		{
+			// we can't pick this door, since it is the winning one
+			open_door++;
+		}
+	}
+	return open_door;
+}
+
+/** \brief game state machine
+ *
+ * \param p_game_state - pointer to the current game state, which will be updated
+ * \param new_door_press - the door the player selected most recently
+ * \returns 0 if everything is okay -1 for errors and player picking an open door
+ */
+int32_t handle_current_game_update( monty_hall_state *p_game_state, uint32_t new_door_press )
+{
+	if( p_game_state == NULL )
+	{
+		return -1;
+	}
+	
+	switch( p_game_state->state )
+	{
+		// Set up the game, store the players first door, and open the door Monty selects
+		case MONTY_GAME_STARTED:
+		{
+			p_game_state->winning_door = monty_hall_random_door( monty_hall_rand() );
+			p_game_state->first_door = new_door_press;
+			p_game_state->state = FIRST_DOOR_OPEN;
+			p_game_state->open_door = pick_open_door( p_game_state->winning_door, new_door_press );
+			break;
+		}
+		
+		// Determine if the player picked a winner
+		case FIRST_DOOR_OPEN:
+		{
+			if( p_game_state->open_door == new_door_press )
+			{
+				// Invalid button press, stay in this state and wait for another press
+				return -1;
+			}
+			if( p_game_state->winning_door == new_door_press )
+			{
+				p_game_state->state = GAME_OVER_WON;
+				p_game_state->stats.times_won++;
+			}
+			else
+			{
+				p_game_state->state = GAME_OVER_LOST;
+			}
+			if( p_game_state->first_door != new_door_press )
+			{
+				p_game_state->stats.times_switched++;
+				if( p_game_state->state == GAME_OVER_WON )
+				{
+					p_game_state->stats.times_switched_won++;
+				}
+			}
+			p_game_state->stats.number_of_games++;
+			break;
+		}
+		
+		// Reset the game for the next player
+		default:
+		case GAME_OVER_LOST:
+		case GAME_OVER_WON:
+		{
+			p_game_state->state = MONTY_GAME_STARTED;
+			break;
+		}
+	}
+	return 0;
+}
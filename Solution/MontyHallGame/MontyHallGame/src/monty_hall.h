@@ -0,0 +1,131 @@
+/**
+ * \file
+ *
+ * \brief Monty Hall game core (door picking and game state machine)
+ *
+ * Copyright (c) 2013 Atmel Corporation. All rights reserved.
+ *
+ * \asf_license_start
+ *
+ * \page License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. The name of Atmel may not be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * 4. This software may only be redistributed and used in connection with an
+ *    Atmel microcontroller product.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * EXPRESSLY AND SPECIFICALLY DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \asf_license_stop
+ *
+ */
+
+#ifndef MONTY_HALL_H_INCLUDED
+#define MONTY_HALL_H_INCLUDED
+
+/*
+ * The game core has no board dependencies so that it can be linked both into
+ * the firmware and into the host side simulator (see host/Makefile).
+ */
+#include <stdint.h>
+#include <stddef.h>
+
+#include "monty_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief definition of values for door selection */
+enum DOOR_PRESSED_EVENTS
+{
+	DOOR_PRESSED_MIN = 1,
+	DOOR_PRESSED_MAX = 3,
+	DOOR_NOT_PRESSED
+};
+
+/** \brief definition of values for monty hall game state */
+typedef enum
+{
+	MONTY_GAME_STARTED, /**< Game is starting, next button press will setup the game */
+	FIRST_DOOR_OPEN,    /**< First door choice has been made, next press will end the game */
+	GAME_OVER_WON,      /**< Game is over, player won */
+	GAME_OVER_LOST      /**< Game is over, player lost */
+} MONTY_HALL_STATE;
+
+/** \brief structure for holding the current game state and historical won/loss info */
+typedef struct
+{
+	monty_stats stats;           /**< Won/loss counters since reset */
+
+	MONTY_HALL_STATE state;      /**< State of the current game */
+	uint32_t first_door;         /**< First door selection */
+	uint32_t open_door;          /**< Door Monty openned */
+	uint32_t winning_door;       /**< Door with the big prize */
+
+} monty_hall_state;
+
+/** \brief source of uniformly distributed 32 bit random values for the game
+ *
+ * Supplied by the application (firmware or host simulator), so the game core
+ * does not depend on where the randomness comes from.
+ */
+uint32_t monty_hall_rand( void );
+
+/** \brief maps a 32 bit random value onto a door number
+ *
+ * Uses the high part of value * 3 rather than a modulo, so the same mapping can
+ * be done with two compares against fixed thresholds in the batch kernels.
+ *
+ * \param random_value - value returned by monty_hall_rand()
+ * \returns door number between DOOR_PRESSED_MIN and DOOR_PRESSED_MAX
+ */
+static inline uint32_t monty_hall_random_door( uint32_t random_value )
+{
+	return (uint32_t)(((uint64_t)random_value * 3) >> 32) + DOOR_PRESSED_MIN;
+}
+
+extern const uint8_t monty_open_door_table[4][4][2];
+
+/** \brief door Monty opens for a given coin toss
+ *
+ * \param winning_door - door that has the big prize
+ * \param first_door - door the player selected first
+ * \param coin - Monty's coin toss, only used when the player picked the prize
+ * \returns The door Monty opens, DOOR_NOT_PRESSED for invalid doors
+ */
+static inline uint32_t pick_open_door_coin( uint32_t winning_door, uint32_t first_door, uint32_t coin )
+{
+	return monty_open_door_table[winning_door & 0x3][first_door & 0x3][coin & 0x1];
+}
+
+uint32_t pick_open_door( uint32_t winning_door, uint32_t first_door );
+uint32_t pick_open_door_reference( uint32_t winning_door, uint32_t first_door );
+int32_t handle_current_game_update( monty_hall_state *p_game_state, uint32_t new_door_press );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_HALL_H_INCLUDED */
@@ -0,0 +1,183 @@
+/**
+ * \file
+ *
+ * \brief Compact binary log of finished three door games
+ *
+ */
+
+#include <stddef.h>
+
+#include "monty_log.h"
+
+/** \brief decodes a record
+ *
+ * \param record - record written by monty_log_encode()
+ * \param p_game - the game
+ */
+void monty_log_decode( monty_log_record record, monty_log_game *p_game )
+{
+	p_game->first_door = (uint8_t)(record & 0x3);
+	p_game->open_door = (uint8_t)((record >> 2) & 0x3);
+	p_game->final_door = (uint8_t)((record >> 4) & 0x3);
+	p_game->winning_door = (uint8_t)((record >> 6) & 0x3);
+	p_game->won = (record & MONTY_LOG_WON_BIT) != 0;
+	p_game->switched = (record & MONTY_LOG_SWITCHED_BIT) != 0;
+}
+
+/** \brief sets up an empty log
+ *
+ * \param p_log - log to set up
+ * \param p_ring - ring storage, owned by the caller
+ * \param size - ring size in records, a power of two
+ * \param flush_threshold - pending records that trigger a flush, 1..size
+ * \param flush - backing store, NULL to only keep the ring
+ * \param p_context - passed to flush
+ */
+void monty_log_init( monty_log *p_log, monty_log_record *p_ring, uint32_t size, uint32_t flush_threshold,
+					monty_log_flush_fn flush, void *p_context )
+{
+	p_log->p_ring = p_ring;
+	p_log->size = size;
+	p_log->flush_threshold = ((flush_threshold == 0) || (flush_threshold > size)) ? size : flush_threshold;
+	p_log->head = 0;
+	p_log->tail = 0;
+	p_log->dropped = 0;
+	p_log->flush = flush;
+	p_log->p_context = p_context;
+}
+
+/** \brief appends a record, flushing once enough are pending
+ *
+ * Without a backing store, or while it refuses records, the ring keeps the
+ * newest size records and the oldest ones are dropped.
+ *
+ * \param p_log - log
+ * \param record - record to append
+ * \returns 0 if everything is okay, -1 when a record was dropped or the flush failed
+ */
+int32_t monty_log_append( monty_log *p_log, monty_log_record record )
+{
+	int32_t result = 0;
+
+	if( p_log->head - p_log->tail == p_log->size )
+	{
+		p_log->tail++;
+		p_log->dropped++;
+		result = -1;
+	}
+	p_log->p_ring[p_log->head & (p_log->size - 1)] = record;
+	p_log->head++;
+
+	if( (p_log->flush != NULL) && (p_log->head - p_log->tail >= p_log->flush_threshold) )
+	{
+		result |= monty_log_flush( p_log );
+	}
+	return result;
+}
+
+/** \brief hands all pending records to the backing store
+ *
+ * The pending records are passed in at most two contiguous blocks, the second
+ * one when they wrap around the end of the ring.
+ *
+ * \param p_log - log
+ * \returns 0 if everything is okay, -1 when there is no backing store or it failed
+ */
+int32_t monty_log_flush( monty_log *p_log )
+{
+	if( p_log->flush == NULL )
+	{
+		return -1;
+	}
+
+	while( p_log->head != p_log->tail )
+	{
+		uint32_t start = p_log->tail & (p_log->size - 1);
+		uint32_t count = p_log->head - p_log->tail;
+		if( count > p_log->size - start )
+		{
+			count = p_log->size - start;
+		}
+		if( p_log->flush( p_log->p_context, &p_log->p_ring[start], count ) != 0 )
+		{
+			return -1;
+		}
+		p_log->tail += count;
+	}
+	return 0;
+}
+
+/** \brief starts walking a block of stored records
+ *
+ * \param p_iterator - iterator
+ * \param p_records - records read from the backing store
+ * \param count - number of records
+ */
+void monty_log_iterator_init( monty_log_iterator *p_iterator, const monty_log_record *p_records, uint32_t count )
+{
+	p_iterator->p_records = p_records;
+	p_iterator->count = count;
+	p_iterator->next = 0;
+	p_iterator->invalid = 0;
+}
+
+/** \brief next valid game, skipping erased or damaged records
+ *
+ * \param p_iterator - iterator
+ * \param p_game - the game, NULL when only the count is wanted
+ * \returns 1 for a game, 0 at the end of the records
+ */
+int32_t monty_log_next( monty_log_iterator *p_iterator, monty_log_game *p_game )
+{
+	while( p_iterator->next < p_iterator->count )
+	{
+		monty_log_record record = p_iterator->p_records[p_iterator->next++];
+		if( !monty_log_valid( record ) )
+		{
+			p_iterator->invalid++;
+			continue;
+		}
+		if( p_game != NULL )
+		{
+			monty_log_decode( record, p_game );
+		}
+		return 1;
+	}
+	return 0;
+}
+
+/** \brief adds the games of a block of stored records to a set of counters
+ *
+ * Branch free with 32 bit partial sums, so the compiler can vectorise it.
+ *
+ * \param p_records - records read from the backing store
+ * \param count - number of records
+ * \param p_stats - counters to add to
+ * \returns number of records skipped because they were not valid
+ */
+uint32_t monty_log_replay( const monty_log_record *p_records, uint32_t count, monty_stats *p_stats )
+{
+	uint32_t games = 0;
+	uint32_t won = 0;
+	uint32_t switched = 0;
+	uint32_t switched_won = 0;
+
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		uint32_t record = p_records[i];
+		uint32_t valid = (record >> 10) == MONTY_LOG_TAG;
+		uint32_t record_won = (record >> 8) & valid;
+		uint32_t record_switched = (record >> 9) & valid;
+
+		games += valid;
+		won += record_won & 1;
+		switched += record_switched & 1;
+		switched_won += record_won & record_switched & 1;
+	}
+
+	p_stats->number_of_games += games;
+	p_stats->times_won += won;
+	p_stats->times_switched += switched;
+	p_stats->times_switched_won += switched_won;
+	return count - games;
+}
@@ -0,0 +1,136 @@
+/**
+ * \file
+ *
+ * \brief Compact binary log of finished three door games
+ *
+ * Every finished game is one 16 bit record:
+ *
+ *   bits  0..1  first door       bit  8  won
+ *   bits  2..3  open door        bit  9  switched
+ *   bits  4..5  final door       bits 10..15  MONTY_LOG_TAG
+ *   bits  6..7  winning door
+ *
+ * The tag tells records from erased (0xFFFF) or cleared (0x0000) storage, so a
+ * backing store can be scanned for its end and read back without a header.
+ *
+ * Records are appended to a RAM ring buffer and handed to the backing store
+ * (flash on the board, a file on the host) in bulk once flush_threshold of
+ * them are pending. monty_log_replay() rebuilds the monty_stats counters from
+ * stored records exactly as handle_current_game_update() counted them.
+ *
+ */
+
+#ifndef MONTY_LOG_H_INCLUDED
+#define MONTY_LOG_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief one finished game */
+typedef uint16_t monty_log_record;
+
+/** \brief value of the top six bits of every valid record */
+#define MONTY_LOG_TAG 0x2Du
+
+#define MONTY_LOG_WON_BIT      (1u << 8)
+#define MONTY_LOG_SWITCHED_BIT (1u << 9)
+
+/** \brief finished game decoded from a record */
+typedef struct
+{
+	uint8_t first_door;    /**< First door selection */
+	uint8_t open_door;     /**< Door Monty opened */
+	uint8_t final_door;    /**< Door pressed to end the game */
+	uint8_t winning_door;  /**< Door with the big prize */
+	uint8_t won;
+	uint8_t switched;
+} monty_log_game;
+
+/** \brief hands records to the backing store
+ *
+ * \param p_context - monty_log.p_context
+ * \param p_records - records, oldest first
+ * \param count - number of records
+ * \returns 0 when stored, -1 to keep them in the ring and try again later
+ */
+typedef int32_t (*monty_log_flush_fn)( void *p_context, const monty_log_record *p_records, uint32_t count );
+
+/** \brief RAM ring buffer in front of a backing store */
+typedef struct
+{
+	monty_log_record *p_ring;     /**< Ring storage, size records */
+	uint32_t size;                /**< Ring size, a power of two */
+	uint32_t flush_threshold;     /**< Pending records that trigger a flush, 1..size */
+	uint32_t head;                /**< Records appended, wraps at 2^32 */
+	uint32_t tail;                /**< Records handed to the backing store */
+	uint32_t dropped;             /**< Records lost because the ring was full */
+	monty_log_flush_fn flush;
+	void *p_context;
+} monty_log;
+
+/** \brief walks a block of stored records */
+typedef struct
+{
+	const monty_log_record *p_records;
+	uint32_t count;
+	uint32_t next;
+	uint32_t invalid;             /**< Records skipped because their tag did not match */
+} monty_log_iterator;
+
+/** \brief encodes a finished game
+ *
+ * \param first_door - first door selection
+ * \param open_door - door Monty opened
+ * \param final_door - door pressed to end the game
+ * \param winning_door - door with the big prize
+ * \returns the record
+ */
+static inline monty_log_record monty_log_encode( uint32_t first_door, uint32_t open_door, uint32_t final_door,
+												uint32_t winning_door )
+{
+	return (monty_log_record)((first_door & 0x3) | ((open_door & 0x3) << 2) | ((final_door & 0x3) << 4) |
+							((winning_door & 0x3) << 6) |
+							((final_door == winning_door) ? MONTY_LOG_WON_BIT : 0) |
+							((final_door != first_door) ? MONTY_LOG_SWITCHED_BIT : 0) |
+							(MONTY_LOG_TAG << 10));
+}
+
+/** \brief non-zero for a record written by monty_log_encode() */
+static inline int monty_log_valid( monty_log_record record )
+{
+	return (record >> 10) == MONTY_LOG_TAG;
+}
+
+/** \brief adds one record to a set of counters, as handle_current_game_update() counts a game */
+static inline void monty_log_count( monty_stats *p_stats, monty_log_record record )
+{
+	uint32_t won = (record & MONTY_LOG_WON_BIT) != 0;
+	uint32_t switched = (record & MONTY_LOG_SWITCHED_BIT) != 0;
+
+	p_stats->number_of_games++;
+	p_stats->times_won += won;
+	p_stats->times_switched += switched;
+	p_stats->times_switched_won += won & switched;
+}
+
+void monty_log_decode( monty_log_record record, monty_log_game *p_game );
+
+void monty_log_init( monty_log *p_log, monty_log_record *p_ring, uint32_t size, uint32_t flush_threshold,
+					monty_log_flush_fn flush, void *p_context );
+int32_t monty_log_append( monty_log *p_log, monty_log_record record );
+int32_t monty_log_flush( monty_log *p_log );
+
+void monty_log_iterator_init( monty_log_iterator *p_iterator, const monty_log_record *p_records, uint32_t count );
+int32_t monty_log_next( monty_log_iterator *p_iterator, monty_log_game *p_game );
+uint32_t monty_log_replay( const monty_log_record *p_records, uint32_t count, monty_stats *p_stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_LOG_H_INCLUDED */
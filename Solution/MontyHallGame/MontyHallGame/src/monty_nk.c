@@ -0,0 +1,211 @@
+/**
+ * \file
+ *
+ * \brief Generalized Monty Hall game with N doors of which Monty opens K
+ *
+ */
+
+#include "monty_nk.h"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+/** \brief first page of the door drawings, the top page holds the status text */
+#define MONTY_NK_DOOR_PAGE      2
+/** \brief last page of the door drawings */
+#define MONTY_NK_DOOR_LAST_PAGE 3
+/** \brief widest door drawn, the width of the doors on the three door screen */
+#define MONTY_NK_DOOR_MAX_WIDTH 10
+/** \brief display width the three door screen was laid out for */
+#define MONTY_NK_CLASSIC_COLUMNS 128
+
+/** \brief columns of the doors on the three door screen, as the game has always drawn them */
+static const uint32_t g_monty_nk_classic_columns[3] = { 10, 60, 110 };
+
+/** \brief picks the index-th door (counting from 0, lowest door first) of a set
+ *
+ * \param doors - set holding more than index doors
+ * \param index - which door to pick
+ * \returns set holding only the picked door
+ */
+monty_door_set monty_door_select( monty_door_set doors, uint32_t index )
+{
+#if defined(__BMI2__)
+	return _pdep_u64( (uint64_t)1 << index, doors );
+#else
+	// Six fixed halving steps: move to the upper half when the lower one holds too few doors
+	uint32_t shift = 0;
+	for( uint32_t width = 32; width > 0; width >>= 1 )
+	{
+		uint32_t low = monty_door_count( (doors >> shift) & (((monty_door_set)1 << width) - 1) );
+		uint32_t upper = (index >= low);
+		index -= upper * low;
+		shift += upper * width;
+	}
+	return (monty_door_set)1 << shift;
+#endif
+}
+
+/** \brief sets up a game and clears the statistics
+ *
+ * \param p_game_state - game to set up
+ * \param door_count - number of doors, 3..MONTY_NK_MAX_DOORS
+ * \param reveal_count - doors Monty opens, 1..door_count-2
+ * \returns 0 if everything is okay -1 for invalid rules
+ */
+int32_t monty_nk_init( monty_nk_state *p_game_state, uint32_t door_count, uint32_t reveal_count )
+{
+	if( (p_game_state == NULL) || (door_count < 3) || (door_count > MONTY_NK_MAX_DOORS) ||
+		(reveal_count < 1) || (reveal_count > door_count - 2) )
+	{
+		return -1;
+	}
+	monty_stats_clear( &p_game_state->stats );
+	p_game_state->state = MONTY_GAME_STARTED;
+	p_game_state->first_door = DOOR_NOT_PRESSED;
+	p_game_state->open_doors = 0;
+	p_game_state->winning_door = DOOR_NOT_PRESSED;
+	p_game_state->rules.door_count = door_count;
+	p_game_state->rules.reveal_count = reveal_count;
+	return 0;
+}
+
+/** \brief Monty door picking algorithm for N doors
+ *
+ * Monty opens reveal_count of the doors that are neither the prize nor the
+ * player's pick, chosen uniformly. When that is more than half of them, the
+ * doors that stay closed are chosen instead. Takes min(K, C-K) draws of
+ * monty_hall_rand() and selects for C candidates, see monty_nk.h.
+ *
+ * \param p_rules - game rules
+ * \param winning_door - door that has the big prize
+ * \param first_door - door the player selected first
+ * \returns The doors Monty wants to open
+ */
+monty_door_set monty_nk_pick_open_doors( const monty_nk_rules *p_rules, uint32_t winning_door, uint32_t first_door )
+{
+	monty_door_set candidates = monty_door_all( p_rules->door_count ) &
+								~monty_door_bit( winning_door ) & ~monty_door_bit( first_door );
+	uint32_t candidate_count = monty_door_count( candidates );
+	uint32_t keep_closed = candidate_count - p_rules->reveal_count;
+	uint32_t choose = (p_rules->reveal_count <= keep_closed) ? p_rules->reveal_count : keep_closed;
+	monty_door_set chosen = 0;
+
+	for( uint32_t i = 0; i < choose; ++i )
+	{
+		uint32_t index = monty_nk_random_index( monty_hall_rand(), candidate_count - i );
+		chosen |= monty_door_select( candidates & ~chosen, index );
+	}
+	return (choose == p_rules->reveal_count) ? chosen : (candidates & ~chosen);
+}
+
+/** \brief game state machine, same flow as handle_current_game_update()
+ *
+ * \param p_game_state - pointer to the current game state, which will be updated
+ * \param new_door_press - the door the player selected most recently
+ * \returns 0 if everything is okay -1 for errors, doors that don't exist and
+ *          the player picking an open door
+ */
+int32_t monty_nk_game_update( monty_nk_state *p_game_state, uint32_t new_door_press )
+{
+	if( p_game_state == NULL )
+	{
+		return -1;
+	}
+
+	switch( p_game_state->state )
+	{
+		// Set up the game, store the players first door, and open the doors Monty selects
+		case MONTY_GAME_STARTED:
+		{
+			if( (new_door_press < DOOR_PRESSED_MIN) || (new_door_press > p_game_state->rules.door_count) )
+			{
+				return -1;
+			}
+			p_game_state->winning_door = monty_nk_random_index( monty_hall_rand(), p_game_state->rules.door_count ) + 1;
+			p_game_state->first_door = new_door_press;
+			p_game_state->state = FIRST_DOOR_OPEN;
+			p_game_state->open_doors = monty_nk_pick_open_doors( &p_game_state->rules,
+										p_game_state->winning_door, new_door_press );
+			break;
+		}
+
+		// Determine if the player picked a winner
+		case FIRST_DOOR_OPEN:
+		{
+			if( (new_door_press < DOOR_PRESSED_MIN) || (new_door_press > p_game_state->rules.door_count) ||
+				(p_game_state->open_doors & monty_door_bit( new_door_press )) )
+			{
+				// Invalid button press, stay in this state and wait for another press
+				return -1;
+			}
+			if( p_game_state->winning_door == new_door_press )
+			{
+				p_game_state->state = GAME_OVER_WON;
+				p_game_state->stats.times_won++;
+			}
+			else
+			{
+				p_game_state->state = GAME_OVER_LOST;
+			}
+			if( p_game_state->first_door != new_door_press )
+			{
+				p_game_state->stats.times_switched++;
+				if( p_game_state->state == GAME_OVER_WON )
+				{
+					p_game_state->stats.times_switched_won++;
+				}
+			}
+			p_game_state->stats.number_of_games++;
+			break;
+		}
+
+		// Reset the game for the next player
+		default:
+		case GAME_OVER_LOST:
+		case GAME_OVER_WON:
+		{
+			p_game_state->state = MONTY_GAME_STARTED;
+			p_game_state->open_doors = 0;
+			break;
+		}
+	}
+	return 0;
+}
+
+/** \brief spreads the doors evenly over the display width
+ *
+ * Every door gets an equal slot of the width and is centered in it. Doors are
+ * half as wide as their slot (at least one column, at most the width of the
+ * doors on the three door screen). Three doors on the 128 column display keep
+ * the columns the three door game has always used instead.
+ *
+ * \param door_count - number of doors
+ * \param columns - display width in columns
+ * \param p_doors - door_count coordinates to fill in
+ */
+void monty_nk_layout( uint32_t door_count, uint32_t columns, door_coordinates *p_doors )
+{
+	uint32_t pitch = columns / door_count;
+	uint32_t width = pitch / 2;
+
+	if( width > MONTY_NK_DOOR_MAX_WIDTH )
+	{
+		width = MONTY_NK_DOOR_MAX_WIDTH;
+	}
+	if( width < 1 )
+	{
+		width = 1;
+	}
+
+	uint32_t margin = (columns - pitch * door_count) / 2 + (pitch - width) / 2;
+	uint32_t classic = (door_count == 3) && (columns == MONTY_NK_CLASSIC_COLUMNS);
+	for( uint32_t i = 0; i < door_count; ++i )
+	{
+		p_doors[i].col = classic ? g_monty_nk_classic_columns[i] : margin + i * pitch;
+		p_doors[i].page = MONTY_NK_DOOR_PAGE;
+		p_doors[i].width = width;
+		p_doors[i].height = MONTY_NK_DOOR_LAST_PAGE;
+	}
+}
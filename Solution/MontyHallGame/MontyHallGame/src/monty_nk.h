@@ -0,0 +1,110 @@
+/**
+ * \file
+ *
+ * \brief Generalized Monty Hall game with N doors of which Monty opens K
+ *
+ * Doors are numbered 1..N like in the three door game and sets of doors are
+ * kept as bit masks (bit d-1 for door d), so N is limited to 64. Monty opens
+ * K doors that are neither the prize nor the player's first pick. Picking the
+ * doors to open costs one popcount, then a random draw and one select per door
+ * chosen, and min(K, C-K) doors are chosen (C being the number of candidates,
+ * N-1 or N-2): when Monty opens most of the candidates, the few doors he
+ * leaves closed are picked instead. A select is constant time, so a reveal
+ * costs O(min(K, N-K)), not O(1): up to 31 draws and selects with 64 doors
+ * and K around half of them. It is constant only when K or N-K is, as in the
+ * classic "open all but one" variant, which takes at most one select
+ * whatever N is. A uniform choice of K of C doors needs log2(C choose K)
+ * random bits, more than one 32 bit draw once C passes a handful of doors, so
+ * no table of reveals makes the general case constant.
+ *
+ */
+
+#ifndef MONTY_NK_H_INCLUDED
+#define MONTY_NK_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_hall.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief largest supported number of doors */
+#define MONTY_NK_MAX_DOORS 64
+
+/** \brief set of doors, bit d-1 stands for door d */
+typedef uint64_t monty_door_set;
+
+/** \brief structure to hold door drawing coordinates */
+typedef struct
+{
+	uint32_t col;
+	uint32_t page;
+	uint32_t width;
+	uint32_t height;
+} door_coordinates;
+
+/** \brief game rules */
+typedef struct
+{
+	uint32_t door_count;   /**< Number of doors, 3..MONTY_NK_MAX_DOORS */
+	uint32_t reveal_count; /**< Doors Monty opens, 1..door_count-2 */
+} monty_nk_rules;
+
+/** \brief structure for holding the current game state and historical won/loss info */
+typedef struct
+{
+	monty_stats stats;           /**< Won/loss counters since reset */
+
+	MONTY_HALL_STATE state;      /**< State of the current game */
+	uint32_t first_door;         /**< First door selection */
+	monty_door_set open_doors;   /**< Doors Monty opened */
+	uint32_t winning_door;       /**< Door with the big prize */
+
+	monty_nk_rules rules;        /**< Rules for this game */
+} monty_nk_state;
+
+/** \brief set holding only the given door */
+static inline monty_door_set monty_door_bit( uint32_t door )
+{
+	return (monty_door_set)1 << (door - 1);
+}
+
+/** \brief set of doors 1..door_count */
+static inline monty_door_set monty_door_all( uint32_t door_count )
+{
+	return (door_count >= 64) ? ~(monty_door_set)0 : (((monty_door_set)1 << door_count) - 1);
+}
+
+/** \brief number of doors in a set */
+static inline uint32_t monty_door_count( monty_door_set doors )
+{
+#if defined(__GNUC__)
+	return (uint32_t)__builtin_popcountll( doors );
+#else
+	doors = doors - ((doors >> 1) & 0x5555555555555555ull);
+	doors = (doors & 0x3333333333333333ull) + ((doors >> 2) & 0x3333333333333333ull);
+	doors = (doors + (doors >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+	return (uint32_t)((doors * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+/** \brief random value between 0 and range-1 from a 32 bit random value (multiply-shift) */
+static inline uint32_t monty_nk_random_index( uint32_t random_value, uint32_t range )
+{
+	return (uint32_t)(((uint64_t)random_value * range) >> 32);
+}
+
+monty_door_set monty_door_select( monty_door_set doors, uint32_t index );
+
+int32_t monty_nk_init( monty_nk_state *p_game_state, uint32_t door_count, uint32_t reveal_count );
+monty_door_set monty_nk_pick_open_doors( const monty_nk_rules *p_rules, uint32_t winning_door, uint32_t first_door );
+int32_t monty_nk_game_update( monty_nk_state *p_game_state, uint32_t new_door_press );
+void monty_nk_layout( uint32_t door_count, uint32_t columns, door_coordinates *p_doors );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_NK_H_INCLUDED */
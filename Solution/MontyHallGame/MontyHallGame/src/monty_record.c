@@ -0,0 +1,189 @@
+/**
+ * \file
+ *
+ * \brief Recording and replaying the inputs of a game session
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "monty_record.h"
+
+/** \brief sets up an empty recording
+ *
+ * \param p_recording - recording to set up
+ * \param p_events - storage for event_capacity presses
+ * \param event_capacity - presses that can be recorded
+ * \param p_draws - storage for draw_capacity draws
+ * \param draw_capacity - draws that can be recorded
+ */
+void monty_record_init( monty_recording *p_recording, monty_record_event *p_events, uint32_t event_capacity,
+						uint32_t *p_draws, uint32_t draw_capacity )
+{
+	p_recording->p_events = p_events;
+	p_recording->event_capacity = event_capacity;
+	p_recording->event_count = 0;
+	p_recording->p_draws = p_draws;
+	p_recording->draw_capacity = draw_capacity;
+	p_recording->draw_count = 0;
+	p_recording->next_draw = 0;
+	p_recording->overflow = 0;
+}
+
+/** \brief starts recording a press, the draws that follow belong to it
+ *
+ * \param p_recording - recording
+ * \param cycles - cycle counter at the press
+ * \param button - button pressed
+ * \returns 0 if everything is okay, -1 when the recording is full
+ */
+int32_t monty_record_press( monty_recording *p_recording, uint32_t cycles, uint32_t button )
+{
+	if( (p_recording->event_count == p_recording->event_capacity) || (p_recording->overflow != 0) )
+	{
+		p_recording->overflow++;
+		return -1;
+	}
+	monty_record_event *p_event = &p_recording->p_events[p_recording->event_count++];
+	p_event->cycles = cycles;
+	p_event->button = button;
+	p_event->first_draw = p_recording->draw_count;
+	p_event->draw_count = 0;
+	return 0;
+}
+
+/** \brief records a draw of the last press
+ *
+ * Draws before the first press (a start up benchmark) are not part of the
+ * session and are ignored. When the draws do not fit the press they belong to
+ * is taken out again and the recording stops, so it only holds complete
+ * presses.
+ *
+ * \param p_recording - recording
+ * \param value - value monty_hall_rand() returned
+ */
+void monty_record_draw( monty_recording *p_recording, uint32_t value )
+{
+	if( (p_recording->event_count == 0) || (p_recording->overflow != 0) )
+	{
+		return;
+	}
+	if( p_recording->draw_count == p_recording->draw_capacity )
+	{
+		p_recording->event_count--;
+		p_recording->draw_count = p_recording->p_events[p_recording->event_count].first_draw;
+		p_recording->overflow++;
+		return;
+	}
+	p_recording->p_draws[p_recording->draw_count++] = value;
+	p_recording->p_events[p_recording->event_count - 1].draw_count++;
+}
+
+/** \brief non-zero once the recording has stopped */
+uint32_t monty_record_full( const monty_recording *p_recording )
+{
+	return (p_recording->event_count == p_recording->event_capacity) || (p_recording->overflow != 0);
+}
+
+/** \brief goes back to the first draw for a replay */
+void monty_record_rewind( monty_recording *p_recording )
+{
+	p_recording->next_draw = 0;
+}
+
+/** \brief next recorded draw, for monty_hall_rand() during a replay
+ *
+ * \returns the draw, 0 once all draws have been served
+ */
+uint32_t monty_record_next_draw( monty_recording *p_recording )
+{
+	if( p_recording->next_draw == p_recording->draw_count )
+	{
+		p_recording->overflow++;
+		return 0;
+	}
+	return p_recording->p_draws[p_recording->next_draw++];
+}
+
+/** \brief formats one UART line of a recorded press
+ *
+ * \param p_recording - recording
+ * \param event - press
+ * \param line - 0 for the REC line, 1.. for its RECD lines
+ * \param p_text - at least 16 + 9 * MONTY_RECORD_DRAWS_PER_LINE characters
+ * \returns non-zero when the line exists
+ */
+uint32_t monty_record_format( const monty_recording *p_recording, uint32_t event, uint32_t line, char *p_text )
+{
+	const monty_record_event *p_event = &p_recording->p_events[event];
+
+	if( line == 0 )
+	{
+		sprintf( p_text, "REC %lu %lu %lu", (unsigned long)p_event->cycles, (unsigned long)p_event->button,
+				(unsigned long)p_event->draw_count );
+		return 1;
+	}
+
+	uint32_t first = (line - 1) * MONTY_RECORD_DRAWS_PER_LINE;
+	if( first >= p_event->draw_count )
+	{
+		return 0;
+	}
+	uint32_t count = p_event->draw_count - first;
+	count = (count > MONTY_RECORD_DRAWS_PER_LINE) ? MONTY_RECORD_DRAWS_PER_LINE : count;
+
+	char *p_end = p_text + sprintf( p_text, "RECD" );
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		p_end += sprintf( p_end, " %08lx", (unsigned long)p_recording->p_draws[p_event->first_draw + first + i] );
+	}
+	return 1;
+}
+
+/** \brief reads back a line printed by monty_record_format(), other lines are ignored
+ *
+ * \param p_recording - recording to add to
+ * \param p_text - line, anything before "REC" (a terminal's time stamp) is skipped
+ * \returns 0 if everything is okay, -1 when the recording is full or a draw has no press
+ */
+int32_t monty_record_parse_line( monty_recording *p_recording, const char *p_text )
+{
+	const char *p_rec = strstr( p_text, "REC" );
+	if( p_rec == NULL )
+	{
+		return 0;
+	}
+
+	if( strncmp( p_rec, "RECD", 4 ) == 0 )
+	{
+		if( p_recording->event_count == 0 )
+		{
+			return -1;
+		}
+		char *p_end;
+		const char *p = p_rec + 4;
+		for( ;; )
+		{
+			unsigned long value = strtoul( p, &p_end, 16 );
+			if( p_end == p )
+			{
+				return 0;
+			}
+			monty_record_draw( p_recording, (uint32_t)value );
+			if( p_recording->overflow != 0 )
+			{
+				return -1;
+			}
+			p = p_end;
+		}
+	}
+
+	unsigned long cycles, button, draws;
+	if( sscanf( p_rec, "REC %lu %lu %lu", &cycles, &button, &draws ) == 3 )
+	{
+		return monty_record_press( p_recording, (uint32_t)cycles, (uint32_t)button );
+	}
+	return 0;
+}
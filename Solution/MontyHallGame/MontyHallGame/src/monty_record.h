@@ -0,0 +1,86 @@
+/**
+ * \file
+ *
+ * \brief Recording and replaying the inputs of a game session
+ *
+ * A session's only inputs are the button presses and the random values the
+ * game draws. The recorder keeps every press with its cycle counter time
+ * stamp and the draws the game took while handling it; a replay serves the
+ * same presses and draws back to monty_ui_press() at full speed, so the game,
+ * the UART lines and the display come out the same on every replay, on the
+ * board or on the host. Every line the pipeline prints is folded into a hash
+ * to compare replays with.
+ *
+ * The board prints a recording over the UART as
+ *
+ *   REC <cycles> <button> <draws>      one line per press
+ *   RECD <draw> ...                    its draws in hex, up to MONTY_RECORD_DRAWS_PER_LINE per line
+ *
+ * which monty_record_parse_line() reads back on the host.
+ *
+ */
+
+#ifndef MONTY_RECORD_H_INCLUDED
+#define MONTY_RECORD_H_INCLUDED
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief draws printed per RECD line */
+#define MONTY_RECORD_DRAWS_PER_LINE 8
+
+/** \brief FNV-1a offset basis, the hash of no lines */
+#define MONTY_RECORD_HASH_START 0x811C9DC5u
+
+/** \brief one button press */
+typedef struct
+{
+	uint32_t cycles;        /**< Cycle counter at the press */
+	uint32_t button;
+	uint32_t first_draw;    /**< Index of its first draw */
+	uint32_t draw_count;    /**< Draws taken while handling it */
+} monty_record_event;
+
+/** \brief recorded session, the storage is owned by the caller */
+typedef struct
+{
+	monty_record_event *p_events;
+	uint32_t event_capacity;
+	uint32_t event_count;
+	uint32_t *p_draws;
+	uint32_t draw_capacity;
+	uint32_t draw_count;
+	uint32_t next_draw;     /**< Replay position */
+	uint32_t overflow;      /**< Presses or draws that did not fit, or draws a replay ran short of */
+} monty_recording;
+
+/** \brief folds a line (and its line feed) into a hash of printed lines */
+static inline uint32_t monty_record_hash( uint32_t hash, const char *p_line )
+{
+	while( *p_line != 0 )
+	{
+		hash = (hash ^ (uint8_t)*p_line++) * 0x01000193u;
+	}
+	return (hash ^ '\n') * 0x01000193u;
+}
+
+void monty_record_init( monty_recording *p_recording, monty_record_event *p_events, uint32_t event_capacity,
+						uint32_t *p_draws, uint32_t draw_capacity );
+int32_t monty_record_press( monty_recording *p_recording, uint32_t cycles, uint32_t button );
+void monty_record_draw( monty_recording *p_recording, uint32_t value );
+uint32_t monty_record_full( const monty_recording *p_recording );
+
+void monty_record_rewind( monty_recording *p_recording );
+uint32_t monty_record_next_draw( monty_recording *p_recording );
+
+uint32_t monty_record_format( const monty_recording *p_recording, uint32_t event, uint32_t line, char *p_text );
+int32_t monty_record_parse_line( monty_recording *p_recording, const char *p_text );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_RECORD_H_INCLUDED */
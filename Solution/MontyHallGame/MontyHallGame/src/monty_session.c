@@ -0,0 +1,191 @@
+/**
+ * \file
+ *
+ * \brief Table of independent three door game sessions
+ *
+ */
+
+#include "monty_session.h"
+
+/** \brief low bit of every two bit lane */
+#define MONTY_SESSION_LOW_BITS 0x5555555555555555ull
+
+/** \brief low lane bit set where the lane is not 0 */
+static inline uint64_t monty_lanes_nonzero( uint64_t word )
+{
+	return (word | (word >> 1)) & MONTY_SESSION_LOW_BITS;
+}
+
+/** \brief low lane bit set where the lanes of a and b are equal */
+static inline uint64_t monty_lanes_equal( uint64_t a, uint64_t b )
+{
+	return ~monty_lanes_nonzero( a ^ b ) & MONTY_SESSION_LOW_BITS;
+}
+
+/** \brief replaces the lanes selected by mask (low lane bits) with the lanes of value */
+static inline uint64_t monty_lanes_set( uint64_t word, uint64_t mask, uint64_t value )
+{
+	uint64_t lanes = mask | (mask << 1);
+	return (word & ~lanes) | (value & lanes);
+}
+
+/** \brief two bit field value of a door, 0 for DOOR_NOT_PRESSED */
+static inline uint64_t monty_session_door_field( uint32_t door )
+{
+	return (door <= DOOR_PRESSED_MAX) ? door : 0;
+}
+
+/** \brief writes one session's hot fields back into its group */
+static void monty_session_put( monty_session_table *p_table, uint32_t session, const monty_hall_state *p_game_state )
+{
+	monty_session_group *p_group = &p_table->p_groups[session / MONTY_SESSION_LANES];
+	uint64_t mask = (uint64_t)1 << (2 * (session % MONTY_SESSION_LANES));
+	uint32_t shift = 2 * (session % MONTY_SESSION_LANES);
+
+	p_group->state = monty_lanes_set( p_group->state, mask, (uint64_t)p_game_state->state << shift );
+	p_group->first_door = monty_lanes_set( p_group->first_door, mask,
+								monty_session_door_field( p_game_state->first_door ) << shift );
+	p_group->open_door = monty_lanes_set( p_group->open_door, mask,
+								monty_session_door_field( p_game_state->open_door ) << shift );
+	p_group->winning_door = monty_lanes_set( p_group->winning_door, mask,
+								monty_session_door_field( p_game_state->winning_door ) << shift );
+	p_table->p_stats[session] = p_game_state->stats;
+}
+
+/** \brief sets up a table with every session waiting for its first game
+ *
+ * \param p_table - table to set up
+ * \param p_groups - MONTY_SESSION_GROUPS(sessions) groups
+ * \param p_stats - sessions sets of counters
+ * \param sessions - number of sessions
+ */
+void monty_session_init( monty_session_table *p_table, monty_session_group *p_groups, monty_stats *p_stats,
+						uint32_t sessions )
+{
+	p_table->p_groups = p_groups;
+	p_table->p_stats = p_stats;
+	p_table->sessions = sessions;
+
+	for( uint32_t group = 0; group < MONTY_SESSION_GROUPS(sessions); ++group )
+	{
+		// MONTY_GAME_STARTED is 0, so all lanes start a game on their next press
+		p_groups[group].state = 0;
+		p_groups[group].first_door = 0;
+		p_groups[group].open_door = 0;
+		p_groups[group].winning_door = 0;
+	}
+	for( uint32_t session = 0; session < sessions; ++session )
+	{
+		monty_stats_clear( &p_stats[session] );
+	}
+}
+
+/** \brief unpacks one session
+ *
+ * \param p_table - table
+ * \param session - session index
+ * \param p_game_state - the session as a monty_hall_state
+ */
+void monty_session_get( const monty_session_table *p_table, uint32_t session, monty_hall_state *p_game_state )
+{
+	const monty_session_group *p_group = &p_table->p_groups[session / MONTY_SESSION_LANES];
+	uint32_t lane = session % MONTY_SESSION_LANES;
+	uint32_t first_door = monty_session_field( p_group->first_door, lane );
+	uint32_t open_door = monty_session_field( p_group->open_door, lane );
+	uint32_t winning_door = monty_session_field( p_group->winning_door, lane );
+
+	p_game_state->stats = p_table->p_stats[session];
+	p_game_state->state = (MONTY_HALL_STATE)monty_session_field( p_group->state, lane );
+	p_game_state->first_door = first_door ? first_door : DOOR_NOT_PRESSED;
+	p_game_state->open_door = open_door ? open_door : DOOR_NOT_PRESSED;
+	p_game_state->winning_door = winning_door ? winning_door : DOOR_NOT_PRESSED;
+}
+
+/** \brief one button press for one session, through handle_current_game_update()
+ *
+ * \param p_table - table
+ * \param session - session index
+ * \param door - door pressed
+ * \returns the result of handle_current_game_update()
+ */
+int32_t monty_session_press( monty_session_table *p_table, uint32_t session, uint32_t door )
+{
+	monty_hall_state game_state;
+
+	monty_session_get( p_table, session, &game_state );
+	int32_t result = handle_current_game_update( &game_state, door );
+	monty_session_put( p_table, session, &game_state );
+	return result;
+}
+
+/** \brief applies one round of button presses to all sessions
+ *
+ * Same transitions as handle_current_game_update(): a press starts a game,
+ * picks the final door (a press on the open door is ignored) or leaves the
+ * game over screen.
+ *
+ * \param p_table - table
+ * \param p_presses - MONTY_SESSION_GROUPS(sessions) words, see monty_session_set_press()
+ * \returns number of games that ended
+ */
+uint32_t monty_session_update( monty_session_table *p_table, const uint64_t *p_presses )
+{
+	uint32_t finished = 0;
+
+	for( uint32_t group = 0; group < MONTY_SESSION_GROUPS(p_table->sessions); ++group )
+	{
+		uint64_t presses = p_presses[group];
+		uint64_t pressed = monty_lanes_nonzero( presses );
+		if( pressed == 0 )
+		{
+			continue;
+		}
+
+		monty_session_group *p_group = &p_table->p_groups[group];
+		uint64_t state_low = p_group->state & MONTY_SESSION_LOW_BITS;
+		uint64_t state_high = (p_group->state >> 1) & MONTY_SESSION_LOW_BITS;
+
+		// MONTY_GAME_STARTED (0) lanes start a game, one at a time as each draws
+		uint64_t starting = pressed & ~state_low & ~state_high;
+		// FIRST_DOOR_OPEN (1) lanes pressing a closed door finish their game
+		uint64_t finishing = pressed & state_low & ~state_high &
+							~monty_lanes_equal( presses, p_group->open_door );
+		// GAME_OVER_WON (2) and GAME_OVER_LOST (3) lanes go back to MONTY_GAME_STARTED
+		uint64_t resetting = pressed & state_high;
+
+		uint64_t won = finishing & monty_lanes_equal( presses, p_group->winning_door );
+		uint64_t switched = finishing & ~monty_lanes_equal( presses, p_group->first_door );
+
+		uint64_t state = monty_lanes_set( p_group->state, resetting, 0 );
+		state = monty_lanes_set( state, finishing, (finishing << 1) | (finishing & ~won) );
+		p_group->state = state;
+
+		for( uint64_t lanes = finishing; lanes != 0; lanes &= lanes - 1 )
+		{
+			uint32_t lane = (uint32_t)__builtin_ctzll( lanes ) / 2;
+			uint64_t bit = (uint64_t)1 << (2 * lane);
+			monty_stats *p_stats = &p_table->p_stats[group * MONTY_SESSION_LANES + lane];
+
+			p_stats->number_of_games++;
+			p_stats->times_won += (won & bit) != 0;
+			p_stats->times_switched += (switched & bit) != 0;
+			p_stats->times_switched_won += (switched & won & bit) != 0;
+			finished++;
+		}
+
+		for( uint64_t lanes = starting; lanes != 0; lanes &= lanes - 1 )
+		{
+			uint32_t lane = (uint32_t)__builtin_ctzll( lanes ) / 2;
+			uint64_t bit = (uint64_t)1 << (2 * lane);
+			uint32_t first_door = monty_session_field( presses, lane );
+			uint32_t winning_door = monty_hall_random_door( monty_hall_rand() );
+			uint32_t open_door = pick_open_door( winning_door, first_door );
+
+			p_group->state = monty_lanes_set( p_group->state, bit, (uint64_t)FIRST_DOOR_OPEN << (2 * lane) );
+			p_group->first_door = monty_lanes_set( p_group->first_door, bit, (uint64_t)first_door << (2 * lane) );
+			p_group->open_door = monty_lanes_set( p_group->open_door, bit, (uint64_t)open_door << (2 * lane) );
+			p_group->winning_door = monty_lanes_set( p_group->winning_door, bit, (uint64_t)winning_door << (2 * lane) );
+		}
+	}
+	return finished;
+}
@@ -0,0 +1,86 @@
+/**
+ * \file
+ *
+ * \brief Table of independent three door game sessions
+ *
+ * A session is the state of one monty_hall_state: four fields that only take
+ * values 0..3 (the doors are 1..3, 0 standing for no door yet) and the won/loss
+ * counters. The table keeps the four small fields packed two bits per session,
+ * 32 sessions to a uint64_t, and groups the four words of the same 32
+ * sessions together: one group is 32 bytes, so a 64 byte cache line holds the
+ * hot state of 64 sessions. The counters, only touched when a game ends, live
+ * in a separate array.
+ *
+ * monty_session_update() applies one round of button presses, one two bit
+ * press per session (0 for none), to the whole table. Finishing and resetting
+ * games is done 32 sessions at a time with bitwise operations; only sessions
+ * starting a game go one by one, as they draw random numbers. Sessions are
+ * handled in index order, so the random draws and the results are the same as
+ * calling handle_current_game_update() for every pressed session in turn.
+ *
+ */
+
+#ifndef MONTY_SESSION_H_INCLUDED
+#define MONTY_SESSION_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_hall.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief sessions per group, one two bit lane each in a uint64_t */
+#define MONTY_SESSION_LANES 32
+
+/** \brief number of groups (and of press words) for a number of sessions */
+#define MONTY_SESSION_GROUPS(sessions) (((sessions) + MONTY_SESSION_LANES - 1) / MONTY_SESSION_LANES)
+
+/** \brief hot state of 32 sessions, two bits per session in every field */
+typedef struct
+{
+	uint64_t state;        /**< MONTY_HALL_STATE */
+	uint64_t first_door;   /**< First door selection, 0 before the first press */
+	uint64_t open_door;    /**< Door Monty opened, 0 when none is open */
+	uint64_t winning_door; /**< Door with the big prize, 0 before the first game */
+} monty_session_group;
+
+/** \brief session table, the storage is owned by the caller */
+typedef struct
+{
+	monty_session_group *p_groups; /**< MONTY_SESSION_GROUPS(sessions) groups */
+	monty_stats *p_stats;          /**< One set of counters per session */
+	uint32_t sessions;
+} monty_session_table;
+
+/** \brief reads a two bit field of a session */
+static inline uint32_t monty_session_field( uint64_t word, uint32_t lane )
+{
+	return (uint32_t)(word >> (2 * lane)) & 0x3;
+}
+
+/** \brief stores a door press for a session in a round of presses
+ *
+ * \param p_presses - MONTY_SESSION_GROUPS(sessions) words, cleared before the round
+ * \param session - session index
+ * \param door - DOOR_PRESSED_MIN..DOOR_PRESSED_MAX
+ */
+static inline void monty_session_set_press( uint64_t *p_presses, uint32_t session, uint32_t door )
+{
+	uint32_t lane = session % MONTY_SESSION_LANES;
+	uint64_t *p_word = &p_presses[session / MONTY_SESSION_LANES];
+	*p_word = (*p_word & ~((uint64_t)0x3 << (2 * lane))) | ((uint64_t)(door & 0x3) << (2 * lane));
+}
+
+void monty_session_init( monty_session_table *p_table, monty_session_group *p_groups, monty_stats *p_stats,
+						uint32_t sessions );
+void monty_session_get( const monty_session_table *p_table, uint32_t session, monty_hall_state *p_game_state );
+int32_t monty_session_press( monty_session_table *p_table, uint32_t session, uint32_t door );
+uint32_t monty_session_update( monty_session_table *p_table, const uint64_t *p_presses );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_SESSION_H_INCLUDED */
@@ -0,0 +1,122 @@
+/**
+ * \file
+ *
+ * \brief Pre-rendered images blitted into the framebuffer
+ *
+ */
+
+#include <string.h>
+
+#include "ssd1306.h"
+#include "font.h"
+#include "monty_sprite.h"
+
+/** \brief draws a sprite, cut at the edge of the panel
+ *
+ * \param p_fb - framebuffer
+ * \param p_sprite - sprite
+ * \param column - column of its left edge
+ * \param page - page of its first row
+ */
+void monty_sprite_draw( monty_framebuffer *p_fb, const monty_sprite *p_sprite, uint8_t column, uint8_t page )
+{
+	monty_framebuffer_blit_masked( p_fb, column, page, p_sprite->width, p_sprite->pages, p_sprite->p_image,
+								   p_sprite->p_mask );
+}
+
+/** \brief empties the text cache
+ *
+ * \param p_font - text cache
+ */
+void monty_sprite_font_init( monty_sprite_font *p_font )
+{
+	p_font->used = 0;
+	p_font->count = 0;
+}
+
+/** \brief renders a string into the text cache
+ *
+ * The same bytes monty_framebuffer_text() draws: each character's font
+ * columns and a blank column, characters outside the font skipped.
+ *
+ * \param p_font - text cache
+ * \param p_text - string, has to stay around as long as the cache
+ * \returns 0 if everything is okay, -1 when the cache is full or the string
+ * is wider than the panel
+ */
+int32_t monty_sprite_font_add( monty_sprite_font *p_font, const char *p_text )
+{
+	if( p_font->count >= MONTY_SPRITE_TEXTS )
+	{
+		return -1;
+	}
+	uint8_t *p_pixels = &p_font->pixels[p_font->used];
+	uint32_t room = MONTY_SPRITE_TEXT_BYTES - p_font->used;
+	uint32_t width = 0;
+
+	if( room > MONTY_FRAMEBUFFER_COLUMNS )
+	{
+		room = MONTY_FRAMEBUFFER_COLUMNS;
+	}
+	for( const char *p_char = p_text; *p_char != 0; ++p_char )
+	{
+		if( (*p_char < ' ') || (*p_char > '~') )
+		{
+			continue;
+		}
+		const uint8_t *p_glyph = font_table[*p_char - ' '];
+		if( width + p_glyph[0] + 1 > room )
+		{
+			return -1;
+		}
+		memcpy( &p_pixels[width], &p_glyph[1], p_glyph[0] );
+		width += p_glyph[0];
+		p_pixels[width++] = 0x00;
+	}
+
+	monty_sprite_text *p_entry = &p_font->texts[p_font->count++];
+	p_entry->p_text = p_text;
+	p_entry->length = strlen( p_text );
+	p_entry->sprite.p_image = p_pixels;
+	p_entry->sprite.p_mask = NULL;
+	p_entry->sprite.width = (uint8_t)width;
+	p_entry->sprite.pages = 1;
+	p_font->used += width;
+	return 0;
+}
+
+/** \brief writes text, the longest cached start of it as a sprite
+ *
+ * Same result as monty_framebuffer_text(). The cached start is only used
+ * when it fits before the edge of the panel, where the text would wrap.
+ *
+ * \param p_font - text cache
+ * \param p_fb - framebuffer
+ * \param page - page (text row)
+ * \param column - column of the first character
+ * \param p_text - text, characters outside the font are skipped
+ * \returns column after the text
+ */
+uint8_t monty_sprite_font_text( const monty_sprite_font *p_font, monty_framebuffer *p_fb, uint8_t page,
+								uint8_t column, const char *p_text )
+{
+	const monty_sprite_text *p_best = NULL;
+
+	for( uint32_t i = 0; i < p_font->count; ++i )
+	{
+		const monty_sprite_text *p_entry = &p_font->texts[i];
+		if( ((p_best == NULL) || (p_entry->length > p_best->length)) &&
+			((uint32_t)column + p_entry->sprite.width <= MONTY_FRAMEBUFFER_COLUMNS) &&
+			(strncmp( p_text, p_entry->p_text, p_entry->length ) == 0) )
+		{
+			p_best = p_entry;
+		}
+	}
+	if( p_best != NULL )
+	{
+		monty_sprite_draw( p_fb, &p_best->sprite, column, page );
+		column = (column + p_best->sprite.width) & (MONTY_FRAMEBUFFER_COLUMNS - 1);
+		p_text += p_best->length;
+	}
+	return monty_framebuffer_text( p_fb, page, column, p_text );
+}
@@ -0,0 +1,71 @@
+/**
+ * \file
+ *
+ * \brief Pre-rendered images blitted into the framebuffer
+ *
+ * A sprite is an image in the framebuffer's own layout, whole 8 pixel pages
+ * of one byte per column, with an optional mask of the pixels it covers, so
+ * drawing it is a copy per page (monty_framebuffer_blit()) instead of working
+ * out every byte again.
+ *
+ * The text cache renders strings the game draws over and over in the ASF font
+ * once, into a small pool. monty_sprite_font_text() then draws the longest
+ * cached start of a line as a sprite and only the rest, such as a number,
+ * glyph by glyph, and leaves exactly the bytes monty_framebuffer_text() would.
+ *
+ */
+
+#ifndef MONTY_SPRITE_H_INCLUDED
+#define MONTY_SPRITE_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_framebuffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief strings the text cache holds */
+#define MONTY_SPRITE_TEXTS 8
+
+/** \brief bytes of rendered text the cache holds, a character takes about 6 */
+#define MONTY_SPRITE_TEXT_BYTES 384
+
+/** \brief image of whole pages */
+typedef struct
+{
+	const uint8_t *p_image;      /**< width bytes for each page in turn, bit 0 at the top */
+	const uint8_t *p_mask;       /**< Same layout, set bits are drawn, NULL to draw every pixel */
+	uint8_t width;
+	uint8_t pages;
+} monty_sprite;
+
+/** \brief string rendered in the ASF font, one page high */
+typedef struct
+{
+	const char *p_text;          /**< Has to stay around as long as the cache */
+	uint32_t length;             /**< Characters */
+	monty_sprite sprite;
+} monty_sprite_text;
+
+/** \brief cache of rendered strings */
+typedef struct
+{
+	uint8_t pixels[MONTY_SPRITE_TEXT_BYTES];
+	uint32_t used;               /**< Bytes of pixels taken */
+	monty_sprite_text texts[MONTY_SPRITE_TEXTS];
+	uint32_t count;
+} monty_sprite_font;
+
+void monty_sprite_draw( monty_framebuffer *p_fb, const monty_sprite *p_sprite, uint8_t column, uint8_t page );
+void monty_sprite_font_init( monty_sprite_font *p_font );
+int32_t monty_sprite_font_add( monty_sprite_font *p_font, const char *p_text );
+uint8_t monty_sprite_font_text( const monty_sprite_font *p_font, monty_framebuffer *p_fb, uint8_t page,
+								uint8_t column, const char *p_text );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_SPRITE_H_INCLUDED */
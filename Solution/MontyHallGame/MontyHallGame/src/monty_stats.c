@@ -0,0 +1,207 @@
+/**
+ * \file
+ *
+ * \brief Game statistics
+ *
+ */
+
+#include <math.h>
+
+#include "monty_stats.h"
+
+/** \brief iteration limit of the incomplete beta continued fraction */
+#define MONTY_STATS_BETA_ITERATIONS 1000000
+/** \brief bisection steps when inverting the incomplete beta function */
+#define MONTY_STATS_BISECTIONS      64
+
+/** \brief percentage rounded down, 0 when nothing was counted
+ *
+ * \param part - counted events
+ * \param whole - trials, at least part
+ * \returns 100 * part / whole
+ */
+uint32_t monty_stats_percent( uint64_t part, uint64_t whole )
+{
+	if( whole == 0 )
+	{
+		return 0;
+	}
+	if( part > UINT64_MAX / 100 )
+	{
+		// 100 * part would overflow, at this size one part in 100 of whole is plenty of precision
+		return (uint32_t)(part / (whole / 100));
+	}
+	return (uint32_t)((part * 100) / whole);
+}
+
+/** \brief Wilson score interval of a rate
+ *
+ * \param successes - counted events
+ * \param trials - trials, at least successes
+ * \param z - standard normal quantile of the confidence level, MONTY_STATS_Z95 for 95%
+ * \param p_interval - the interval, [0, 1] without trials
+ */
+void monty_stats_wilson( uint64_t successes, uint64_t trials, double z, monty_interval *p_interval )
+{
+	p_interval->lower = 0.0;
+	p_interval->upper = 1.0;
+	if( trials == 0 )
+	{
+		return;
+	}
+
+	double n = (double)trials;
+	double p = (double)successes / n;
+	double z2 = z * z;
+	double centre = (p + z2 / (2.0 * n)) / (1.0 + z2 / n);
+	double half_width = (z / (1.0 + z2 / n)) * sqrt( p * (1.0 - p) / n + z2 / (4.0 * n * n) );
+
+	p_interval->lower = (successes == 0) ? 0.0 : centre - half_width;
+	p_interval->upper = (successes == trials) ? 1.0 : centre + half_width;
+}
+
+/** \brief continued fraction of the incomplete beta function (modified Lentz) */
+static double monty_stats_beta_fraction( double a, double b, double x )
+{
+	const double tiny = 1e-300;
+	double c = 1.0;
+	double d = 1.0 - (a + b) * x / (a + 1.0);
+	d = (fabs( d ) < tiny) ? (1.0 / tiny) : (1.0 / d);
+	double fraction = d;
+
+	for( uint32_t m = 1; m <= MONTY_STATS_BETA_ITERATIONS; ++m )
+	{
+		double m2 = 2.0 * m;
+		double numerator = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+		d = 1.0 + numerator * d;
+		d = (fabs( d ) < tiny) ? (1.0 / tiny) : (1.0 / d);
+		c = 1.0 + numerator / c;
+		c = (fabs( c ) < tiny) ? tiny : c;
+		fraction *= d * c;
+
+		numerator = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+		d = 1.0 + numerator * d;
+		d = (fabs( d ) < tiny) ? (1.0 / tiny) : (1.0 / d);
+		c = 1.0 + numerator / c;
+		c = (fabs( c ) < tiny) ? tiny : c;
+		double delta = d * c;
+		fraction *= delta;
+		if( fabs( delta - 1.0 ) < 1e-15 )
+		{
+			break;
+		}
+	}
+	return fraction;
+}
+
+/** \brief regularized incomplete beta function I_x(a, b) */
+static double monty_stats_beta( double a, double b, double x )
+{
+	if( x <= 0.0 )
+	{
+		return 0.0;
+	}
+	if( x >= 1.0 )
+	{
+		return 1.0;
+	}
+
+	double front = exp( lgamma( a + b ) - lgamma( a ) - lgamma( b ) + a * log( x ) + b * log1p( -x ) );
+	if( x < (a + 1.0) / (a + b + 2.0) )
+	{
+		return front * monty_stats_beta_fraction( a, b, x ) / a;
+	}
+	return 1.0 - front * monty_stats_beta_fraction( b, a, 1.0 - x ) / b;
+}
+
+/** \brief x with I_x(a, b) = q, by bisection */
+static double monty_stats_beta_quantile( double q, double a, double b )
+{
+	double low = 0.0;
+	double high = 1.0;
+	for( uint32_t i = 0; i < MONTY_STATS_BISECTIONS; ++i )
+	{
+		double mid = 0.5 * (low + high);
+		if( monty_stats_beta( a, b, mid ) < q )
+		{
+			low = mid;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	return 0.5 * (low + high);
+}
+
+/** \brief exact (Clopper-Pearson) interval of a rate
+ *
+ * Never narrower than the requested confidence, but slower than
+ * monty_stats_wilson(): meant for reporting, not for every game.
+ *
+ * \param successes - counted events
+ * \param trials - trials, at least successes
+ * \param alpha - one minus the confidence level, 0.05 for 95%
+ * \param p_interval - the interval, [0, 1] without trials
+ */
+void monty_stats_clopper_pearson( uint64_t successes, uint64_t trials, double alpha, monty_interval *p_interval )
+{
+	p_interval->lower = 0.0;
+	p_interval->upper = 1.0;
+	if( trials == 0 )
+	{
+		return;
+	}
+
+	double x = (double)successes;
+	double n = (double)trials;
+	if( successes > 0 )
+	{
+		p_interval->lower = monty_stats_beta_quantile( alpha / 2.0, x, n - x + 1.0 );
+	}
+	if( successes < trials )
+	{
+		p_interval->upper = monty_stats_beta_quantile( 1.0 - alpha / 2.0, x + 1.0, n - x );
+	}
+}
+
+/** \brief sets up a sequential probability ratio test
+ *
+ * \param p_sprt - test to set up
+ * \param p0 - rate under the null hypothesis
+ * \param p1 - rate under the alternative, above p0
+ * \param alpha - probability of accepting H1 when p0 is true
+ * \param beta - probability of accepting H0 when p1 is true
+ */
+void monty_sprt_init( monty_sprt *p_sprt, double p0, double p1, double alpha, double beta )
+{
+	p_sprt->success_llr = log( p1 / p0 );
+	p_sprt->failure_llr = log( (1.0 - p1) / (1.0 - p0) );
+	p_sprt->accept_h1 = log( (1.0 - beta) / alpha );
+	p_sprt->accept_h0 = log( beta / (1.0 - alpha) );
+}
+
+/** \brief checks the test against the counters so far
+ *
+ * The log likelihood ratio is linear in the counters, so a check costs two
+ * multiplications however many games were played.
+ *
+ * \param p_sprt - test
+ * \param successes - counted events
+ * \param trials - trials, at least successes
+ * \returns the decision, MONTY_SPRT_CONTINUE while neither boundary is crossed
+ */
+MONTY_SPRT monty_sprt_check( const monty_sprt *p_sprt, uint64_t successes, uint64_t trials )
+{
+	double llr = (double)successes * p_sprt->success_llr + (double)(trials - successes) * p_sprt->failure_llr;
+
+	if( llr >= p_sprt->accept_h1 )
+	{
+		return MONTY_SPRT_ACCEPT_H1;
+	}
+	if( llr <= p_sprt->accept_h0 )
+	{
+		return MONTY_SPRT_ACCEPT_H0;
+	}
+	return MONTY_SPRT_CONTINUE;
+}
@@ -0,0 +1,103 @@
+/**
+ * \file
+ *
+ * \brief Game statistics
+ *
+ * The counters only ever get incremented while games are played, so keeping
+ * them is free of divisions. Counters of independent runs (threads, shards,
+ * saved sessions) are merged by adding them. Rates and their confidence
+ * intervals are derived from the counters on demand.
+ *
+ * monty_sprt is Wald's sequential probability ratio test on a rate. It only
+ * needs the counters, so a run can check it between batches of games and stop
+ * as soon as the answer is settled.
+ *
+ */
+
+#ifndef MONTY_STATS_H_INCLUDED
+#define MONTY_STATS_H_INCLUDED
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief won/loss counters of a series of games */
+typedef struct
+{
+	uint64_t number_of_games;    /**< Total games played since reset */
+	uint64_t times_switched;     /**< Times the player switched doors */
+	uint64_t times_switched_won; /**< Times the player switching doors won */
+	uint64_t times_won;          /**< Total wins (switching or not) */
+} monty_stats;
+
+/** \brief two sided confidence interval of a rate */
+typedef struct
+{
+	double lower;
+	double upper;
+} monty_interval;
+
+/** \brief decision of the sequential test */
+typedef enum
+{
+	MONTY_SPRT_CONTINUE,  /**< Not settled, play more games */
+	MONTY_SPRT_ACCEPT_H0, /**< The rate is p0 (or lower) */
+	MONTY_SPRT_ACCEPT_H1  /**< The rate is p1 (or higher) */
+} MONTY_SPRT;
+
+/** \brief sequential probability ratio test of rate p0 against p1 > p0 */
+typedef struct
+{
+	double success_llr; /**< Log likelihood ratio added by a success */
+	double failure_llr; /**< Log likelihood ratio added by a failure */
+	double accept_h1;   /**< Upper boundary, log((1-beta)/alpha) */
+	double accept_h0;   /**< Lower boundary, log(beta/(1-alpha)) */
+} monty_sprt;
+
+/** \brief z value of a two sided 95% interval */
+#define MONTY_STATS_Z95 1.959963984540054
+
+/** \brief clears the counters */
+static inline void monty_stats_clear( monty_stats *p_stats )
+{
+	p_stats->number_of_games = 0;
+	p_stats->times_switched = 0;
+	p_stats->times_switched_won = 0;
+	p_stats->times_won = 0;
+}
+
+/** \brief adds the counters of another run */
+static inline void monty_stats_merge( monty_stats *p_stats, const monty_stats *p_other )
+{
+	p_stats->number_of_games    += p_other->number_of_games;
+	p_stats->times_switched     += p_other->times_switched;
+	p_stats->times_switched_won += p_other->times_switched_won;
+	p_stats->times_won          += p_other->times_won;
+}
+
+/** \brief games in which the player kept the first door */
+static inline uint64_t monty_stats_stayed( const monty_stats *p_stats )
+{
+	return p_stats->number_of_games - p_stats->times_switched;
+}
+
+/** \brief games won keeping the first door */
+static inline uint64_t monty_stats_stayed_won( const monty_stats *p_stats )
+{
+	return p_stats->times_won - p_stats->times_switched_won;
+}
+
+uint32_t monty_stats_percent( uint64_t part, uint64_t whole );
+void monty_stats_wilson( uint64_t successes, uint64_t trials, double z, monty_interval *p_interval );
+void monty_stats_clopper_pearson( uint64_t successes, uint64_t trials, double alpha, monty_interval *p_interval );
+
+void monty_sprt_init( monty_sprt *p_sprt, double p0, double p1, double alpha, double beta );
+MONTY_SPRT monty_sprt_check( const monty_sprt *p_sprt, uint64_t successes, uint64_t trials );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_STATS_H_INCLUDED */
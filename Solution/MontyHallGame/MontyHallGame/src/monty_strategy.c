@@ -0,0 +1,168 @@
+/**
+ * \file
+ *
+ * \brief Player strategies for the three door game
+ *
+ */
+
+#include "monty_strategy.h"
+
+/** \brief games in which the greedy strategy explores, out of 16 */
+#define MONTY_GREEDY_EXPLORE_MASK 0xF
+
+/** \brief the built-in strategies all pick their first door uniformly */
+static uint32_t monty_strategy_uniform_first( void *p_context, uint32_t random_value )
+{
+	(void)p_context;
+	return monty_hall_random_door( random_value );
+}
+
+static uint32_t monty_strategy_switch_final( void *p_context, uint32_t first_door, uint32_t open_door, uint32_t random_value )
+{
+	(void)p_context;
+	(void)random_value;
+	return monty_other_door( first_door, open_door );
+}
+
+static uint32_t monty_strategy_stay_final( void *p_context, uint32_t first_door, uint32_t open_door, uint32_t random_value )
+{
+	(void)p_context;
+	(void)open_door;
+	(void)random_value;
+	return first_door;
+}
+
+static uint32_t monty_strategy_random_final( void *p_context, uint32_t first_door, uint32_t open_door, uint32_t random_value )
+{
+	(void)p_context;
+	return (random_value & 0x1) ? monty_other_door( first_door, open_door ) : first_door;
+}
+
+/** \brief win-stay lose-shift, starts out switching */
+static uint32_t monty_strategy_win_stay_final( void *p_context, uint32_t first_door, uint32_t open_door, uint32_t random_value )
+{
+	const monty_strategy_learner *p_learner = (const monty_strategy_learner *)p_context;
+	uint32_t switching = (p_learner->plays[0] + p_learner->plays[1] == 0) ||
+							(p_learner->last_switched == p_learner->last_won);
+
+	(void)random_value;
+	return switching ? monty_other_door( first_door, open_door ) : first_door;
+}
+
+/** \brief epsilon greedy on the win rates, every action is tried at least once */
+static uint32_t monty_strategy_greedy_final( void *p_context, uint32_t first_door, uint32_t open_door, uint32_t random_value )
+{
+	const monty_strategy_learner *p_learner = (const monty_strategy_learner *)p_context;
+	uint32_t switching;
+
+	if( (random_value & MONTY_GREEDY_EXPLORE_MASK) == 0 )
+	{
+		switching = (random_value >> 4) & 0x1;
+	}
+	else if( (p_learner->plays[0] == 0) || (p_learner->plays[1] == 0) )
+	{
+		switching = (p_learner->plays[1] == 0);
+	}
+	else
+	{
+		// wins[1] / plays[1] > wins[0] / plays[0] without dividing
+		switching = ((uint64_t)p_learner->wins[1] * p_learner->plays[0]) >
+					((uint64_t)p_learner->wins[0] * p_learner->plays[1]);
+	}
+	return switching ? monty_other_door( first_door, open_door ) : first_door;
+}
+
+/** \brief bookkeeping shared by the learning strategies */
+static void monty_strategy_learn( void *p_context, uint32_t switched, uint32_t won )
+{
+	monty_strategy_learner *p_learner = (monty_strategy_learner *)p_context;
+
+	p_learner->plays[switched]++;
+	p_learner->wins[switched] += won;
+	p_learner->last_switched = switched;
+	p_learner->last_won = won;
+}
+
+/** \brief sets up one of the built-in strategies
+ *
+ * \param which - strategy to set up, always switching for an unknown one
+ * \param p_learner - state for the learning strategies, cleared by the caller, may be
+ *                    NULL for the others. Every strategy needs its own.
+ * \param p_strategy - strategy to fill in
+ */
+void monty_strategy_builtin( MONTY_STRATEGY_BUILTIN which, monty_strategy_learner *p_learner,
+							monty_strategy *p_strategy )
+{
+	monty_strategy strategy = { "switch", monty_strategy_uniform_first, monty_strategy_switch_final, NULL, NULL };
+
+	switch( which )
+	{
+		case MONTY_STRATEGY_STAY:
+			strategy.p_name = "stay";
+			strategy.final_door = monty_strategy_stay_final;
+			break;
+		case MONTY_STRATEGY_RANDOM:
+			strategy.p_name = "random";
+			strategy.final_door = monty_strategy_random_final;
+			break;
+		case MONTY_STRATEGY_WIN_STAY:
+			strategy.p_name = "win-stay";
+			strategy.final_door = monty_strategy_win_stay_final;
+			strategy.outcome = monty_strategy_learn;
+			strategy.p_context = p_learner;
+			break;
+		case MONTY_STRATEGY_GREEDY:
+			strategy.p_name = "greedy";
+			strategy.final_door = monty_strategy_greedy_final;
+			strategy.outcome = monty_strategy_learn;
+			strategy.p_context = p_learner;
+			break;
+		default:
+		case MONTY_STRATEGY_SWITCH:
+			break;
+	}
+	*p_strategy = strategy;
+}
+
+/** \brief plays one game for a strategy through handle_current_game_update()
+ *
+ * The game must be waiting for its first press (MONTY_GAME_STARTED) and is
+ * left that way. The game core draws the prize door and Monty's coin through
+ * monty_hall_rand() as usual.
+ *
+ * \param p_strategy - strategy pressing the doors
+ * \param p_game_state - game to play, its counters are updated
+ * \param first_random - random value for the first decision
+ * \param final_random - random value for the final decision
+ * \returns 1 if the strategy won, 0 if it lost, -1 for errors
+ */
+int32_t monty_strategy_play( monty_strategy *p_strategy, monty_hall_state *p_game_state,
+								uint32_t first_random, uint32_t final_random )
+{
+	if( (p_strategy == NULL) || (p_game_state == NULL) || (p_game_state->state != MONTY_GAME_STARTED) )
+	{
+		return -1;
+	}
+
+	uint32_t first_door = p_strategy->first_door( p_strategy->p_context, first_random );
+	handle_current_game_update( p_game_state, first_door );
+
+	uint32_t final_door = p_strategy->final_door( p_strategy->p_context, first_door,
+												p_game_state->open_door, final_random );
+	if( handle_current_game_update( p_game_state, final_door ) != 0 )
+	{
+		// Pressed the open door, abandon the game
+		p_game_state->state = MONTY_GAME_STARTED;
+		return -1;
+	}
+
+	uint32_t won = (p_game_state->state == GAME_OVER_WON);
+	if( p_strategy->outcome != NULL )
+	{
+		p_strategy->outcome( p_strategy->p_context, final_door != first_door, won );
+	}
+
+	// Any press on the game over screen starts the next game
+	handle_current_game_update( p_game_state, first_door );
+	return (int32_t)won;
+}
@@ -0,0 +1,79 @@
+/**
+ * \file
+ *
+ * \brief Player strategies for the three door game
+ *
+ * A strategy answers the two questions the buttons answer on the board: which
+ * door to press first, and which door to press once Monty has opened one. Both
+ * decisions get a 32 bit random value from the caller instead of drawing on
+ * their own, so several strategies can be played against exactly the same
+ * random numbers (see host/monty_eval.c). Strategies that learn are told the
+ * result of every game.
+ *
+ */
+
+#ifndef MONTY_STRATEGY_H_INCLUDED
+#define MONTY_STRATEGY_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_hall.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief one player strategy */
+typedef struct
+{
+	const char *p_name;
+
+	/** \brief door to press first, DOOR_PRESSED_MIN..DOOR_PRESSED_MAX */
+	uint32_t (*first_door)( void *p_context, uint32_t random_value );
+
+	/** \brief door to press after Monty opened open_door */
+	uint32_t (*final_door)( void *p_context, uint32_t first_door, uint32_t open_door, uint32_t random_value );
+
+	/** \brief result of the game just played, NULL for strategies that don't learn */
+	void (*outcome)( void *p_context, uint32_t switched, uint32_t won );
+
+	void *p_context;        /**< Strategy state, NULL when stateless */
+} monty_strategy;
+
+/** \brief state of the learning strategies, clear it before the first game */
+typedef struct
+{
+	uint32_t plays[2];      /**< Games played staying [0] and switching [1] */
+	uint32_t wins[2];       /**< Games won staying [0] and switching [1] */
+	uint32_t last_switched; /**< Action of the last game */
+	uint32_t last_won;      /**< Result of the last game */
+} monty_strategy_learner;
+
+/** \brief closed door that isn't the first pick */
+static inline uint32_t monty_other_door( uint32_t first_door, uint32_t open_door )
+{
+	// Doors 1 + 2 + 3
+	return 6 - first_door - open_door;
+}
+
+/** \brief built-in strategies, index into monty_strategy_builtin() */
+typedef enum
+{
+	MONTY_STRATEGY_SWITCH,      /**< Always switch */
+	MONTY_STRATEGY_STAY,        /**< Never switch */
+	MONTY_STRATEGY_RANDOM,      /**< Switch on a coin toss */
+	MONTY_STRATEGY_WIN_STAY,    /**< Repeat the last action after a win, change it after a loss */
+	MONTY_STRATEGY_GREEDY,      /**< Take the action with the better win rate so far, explore 1 game in 16 */
+	MONTY_STRATEGY_COUNT
+} MONTY_STRATEGY_BUILTIN;
+
+void monty_strategy_builtin( MONTY_STRATEGY_BUILTIN which, monty_strategy_learner *p_learner,
+							monty_strategy *p_strategy );
+int32_t monty_strategy_play( monty_strategy *p_strategy, monty_hall_state *p_game_state,
+								uint32_t first_random, uint32_t final_random );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_STRATEGY_H_INCLUDED */
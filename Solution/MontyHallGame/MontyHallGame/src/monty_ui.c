@@ -0,0 +1,259 @@
+/**
+ * \file
+ *
+ * \brief Button press to game to display pipeline
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "monty_ui.h"
+
+/** \brief starts of the display rows that are rendered once and blitted */
+static const char *g_monty_ui_sprite_texts[] = {
+	"Select a door", "Winner", "Loser", "Game win %   ", "Switch win % ", "Stay win %   "
+};
+
+/** \brief sets up a new game
+ *
+ * \param p_ui - game and screen to set up
+ * \param door_count - number of doors, 3..MONTY_NK_MAX_DOORS
+ * \param reveal_count - doors Monty opens, 1..door_count-2 (1 with three doors)
+ * \param print - sends UART lines
+ * \param p_print_context - passed to print
+ * \param p_log - log for finished three door games, NULL for none
+ * \returns 0 if everything is okay, -1 for invalid rules
+ */
+int32_t monty_ui_init( monty_ui *p_ui, uint32_t door_count, uint32_t reveal_count,
+					monty_ui_print_fn print, void *p_print_context, monty_log *p_log )
+{
+	memset( p_ui, 0, sizeof(*p_ui) );
+	p_ui->game.state = MONTY_GAME_STARTED;
+	p_ui->game.first_door = DOOR_NOT_PRESSED;
+	p_ui->game.open_door = DOOR_NOT_PRESSED;
+	p_ui->game.winning_door = DOOR_NOT_PRESSED;
+	p_ui->door_count = door_count;
+	p_ui->cursor_door = DOOR_NOT_PRESSED;
+	p_ui->print = print;
+	p_ui->p_print_context = p_print_context;
+	p_ui->p_log = p_log;
+
+	if( door_count > DOOR_PRESSED_MAX )
+	{
+		if( monty_nk_init( &p_ui->nk_game, door_count, reveal_count ) != 0 )
+		{
+			return -1;
+		}
+		p_ui->cursor_door = DOOR_PRESSED_MIN;
+	}
+	else if( (door_count != DOOR_PRESSED_MAX) || (reveal_count != 1) )
+	{
+		return -1;
+	}
+	monty_nk_layout( door_count, MONTY_DISPLAY_COLUMNS, p_ui->doors );
+	monty_framebuffer_init( &p_ui->display );
+	monty_display_sprites_init( &p_ui->sprites, &p_ui->doors[0] );
+	for( uint32_t i = 0; i < sizeof(g_monty_ui_sprite_texts) / sizeof(g_monty_ui_sprite_texts[0]); ++i )
+	{
+		// A string that does not fit is drawn glyph by glyph
+		monty_sprite_font_add( &p_ui->sprites.font, g_monty_ui_sprite_texts[i] );
+	}
+	return 0;
+}
+
+/** \brief first screen, drawn on a cleared display */
+void monty_ui_start( monty_ui *p_ui )
+{
+	p_ui->print( p_ui->p_print_context, "Press a button to select a door" );
+	sprintf( p_ui->rows[0], "Select a door" );
+	monty_display_text( &p_ui->display, &p_ui->sprites, 0, p_ui->rows[0] );
+	monty_display_draw_doors( &p_ui->display, &p_ui->sprites, p_ui->doors, p_ui->door_count, 0, p_ui->cursor_door );
+	monty_ui_flush( p_ui );
+}
+
+/** \brief handles one button press: game update, UART report and display
+ *
+ * \param p_ui - game and screen
+ * \param button - button pressed, DOOR_PRESSED_MIN..DOOR_PRESSED_MAX
+ */
+void monty_ui_press( monty_ui *p_ui, uint32_t button )
+{
+	int32_t result;
+	uint32_t game_over = 0;
+	MONTY_HALL_STATE state;
+	uint32_t first_door;
+	uint32_t open_report;
+	const char *p_open_report;
+	const monty_stats *p_stats;
+
+	if( p_ui->door_count > DOOR_PRESSED_MAX )
+	{
+		// While a door has to be picked buttons 1 and 3 only move the cursor
+		monty_nk_state *p_game = &p_ui->nk_game;
+		if( ((p_game->state == MONTY_GAME_STARTED) || (p_game->state == FIRST_DOOR_OPEN)) && (button != 2) )
+		{
+			if( button == 1 )
+			{
+				p_ui->cursor_door = (p_ui->cursor_door > DOOR_PRESSED_MIN) ? (p_ui->cursor_door - 1) : p_ui->door_count;
+			}
+			else
+			{
+				p_ui->cursor_door = (p_ui->cursor_door < p_ui->door_count) ? (p_ui->cursor_door + 1) : DOOR_PRESSED_MIN;
+			}
+			monty_display_draw_doors( &p_ui->display, &p_ui->sprites, p_ui->doors, p_ui->door_count,
+									p_game->open_doors, p_ui->cursor_door );
+			monty_ui_flush( p_ui );
+			return;
+		}
+		result = monty_nk_game_update( p_game, p_ui->cursor_door );
+		state = p_game->state;
+		first_door = p_game->first_door;
+		open_report = monty_door_count( p_game->open_doors );
+		p_open_report = "doors opened";
+		p_stats = &p_game->stats;
+	}
+	else
+	{
+		monty_hall_state *p_game = &p_ui->game;
+		result = handle_current_game_update( p_game, button );
+		state = p_game->state;
+		first_door = p_game->first_door;
+		open_report = p_game->open_door;
+		p_open_report = "open door";
+		p_stats = &p_game->stats;
+	}
+
+	if( state == FIRST_DOOR_OPEN )
+	{
+		if( result == 0 )
+		{
+			sprintf( p_ui->line, "Game State %d: selected door %d %s %d", state, first_door, p_open_report, open_report );
+			p_ui->print( p_ui->p_print_context, p_ui->line );
+		}
+		sprintf( p_ui->rows[0], "Select a door (last %d)", first_door );
+	}
+	else if( state == GAME_OVER_WON )
+	{
+		sprintf( p_ui->line, "Won: Game State %d: selected door %d %s %d", state, first_door, p_open_report, open_report );
+		p_ui->print( p_ui->p_print_context, p_ui->line );
+		game_over = 1;
+		sprintf( p_ui->rows[0], "Winner" );
+	}
+	else if( state == GAME_OVER_LOST )
+	{
+		sprintf( p_ui->line, "Lost: Game State %d: selected door %d %s %d", state, first_door, p_open_report, open_report );
+		p_ui->print( p_ui->p_print_context, p_ui->line );
+		game_over = 1;
+		sprintf( p_ui->rows[0], "Loser" );
+	}
+	else if( state == MONTY_GAME_STARTED )
+	{
+		p_ui->print( p_ui->p_print_context, "Press a button to select a door" );
+		sprintf( p_ui->rows[0], "Select a door" );
+	}
+
+	// Game is over calculate the statistics and set up the final display
+	if( game_over )
+	{
+		// Percentages are 0 until the player has both switched and stayed at least once
+		uint32_t win_pct = monty_stats_percent( p_stats->times_won, p_stats->number_of_games );
+		uint32_t switching_win_pct = monty_stats_percent( p_stats->times_switched_won, p_stats->times_switched );
+		uint32_t staying_win_pct = monty_stats_percent( monty_stats_stayed_won( p_stats ), monty_stats_stayed( p_stats ) );
+		// Nobody presses 2^32 buttons, print the counters as 32 bit so newlib nano can format them
+		sprintf( p_ui->line, "Games Played: %lu, Switch Count %lu, Games Win %d%%, Switch Win %d%% Stay Win %d%%",
+				(unsigned long)p_stats->number_of_games,
+				(unsigned long)p_stats->times_switched,
+				win_pct,
+				switching_win_pct,
+				staying_win_pct );
+		p_ui->print( p_ui->p_print_context, p_ui->line );
+		p_ui->print( p_ui->p_print_context, "Press a button to play again" );
+		if( p_ui->door_count > DOOR_PRESSED_MAX )
+		{
+			p_ui->nk_game.open_doors = 0;
+		}
+		else
+		{
+			if( p_ui->p_log != NULL )
+			{
+				monty_log_append( p_ui->p_log, monty_log_encode( p_ui->game.first_door, p_ui->game.open_door,
+												button, p_ui->game.winning_door ) );
+			}
+			p_ui->game.open_door = DOOR_NOT_PRESSED;
+		}
+		sprintf( p_ui->rows[1], "Game win %%   %d", win_pct );
+		sprintf( p_ui->rows[2], "Switch win %% %d", switching_win_pct );
+		sprintf( p_ui->rows[3], "Stay win %%   %d", staying_win_pct );
+	}
+
+	monty_ui_draw( p_ui );
+}
+
+/** \brief redraws the whole screen for the current game state
+ *
+ * Only the bytes that differ from what the panel shows are sent; after
+ * drawing on the panel behind the game's back, call
+ * monty_framebuffer_panel_cleared() and clear the panel first.
+ *
+ * \param p_ui - game and screen
+ */
+void monty_ui_draw( monty_ui *p_ui )
+{
+	MONTY_HALL_STATE state = p_ui->game.state;
+	monty_door_set open_doors = ((p_ui->game.open_door >= DOOR_PRESSED_MIN) && (p_ui->game.open_door <= DOOR_PRESSED_MAX)) ?
+								monty_door_bit( p_ui->game.open_door ) : 0;
+	if( p_ui->door_count > DOOR_PRESSED_MAX )
+	{
+		state = p_ui->nk_game.state;
+		open_doors = p_ui->nk_game.open_doors;
+	}
+
+	// Clear screen, only what ends up different from before goes out to the panel
+	monty_framebuffer_clear( &p_ui->display );
+	monty_display_text( &p_ui->display, &p_ui->sprites, 0, p_ui->rows[0] );
+
+	if( (state != GAME_OVER_WON) && (state != GAME_OVER_LOST) )
+	{
+		monty_display_draw_doors( &p_ui->display, &p_ui->sprites, p_ui->doors, p_ui->door_count, open_doors,
+								p_ui->cursor_door );
+	}
+	else
+	{
+		for( uint8_t row = 1; row < MONTY_DISPLAY_PAGES; ++row )
+		{
+			monty_display_text( &p_ui->display, &p_ui->sprites, row, p_ui->rows[row] );
+		}
+	}
+	monty_ui_flush( p_ui );
+}
+
+/** \brief sends what changed on the screen to the panel
+ *
+ * With an asynchronous flush (monty_ui_flush_async()) this only starts the
+ * transfer, and while the previous one is still in flight the changes wait
+ * for the next call, so the main loop calls it every time round.
+ *
+ * \param p_ui - game and screen
+ */
+void monty_ui_flush( monty_ui *p_ui )
+{
+	if( p_ui->p_flush != NULL )
+	{
+		monty_framebuffer_flush_async( &p_ui->display, p_ui->p_flush );
+	}
+	else
+	{
+		monty_framebuffer_flush( &p_ui->display );
+	}
+}
+
+/** \brief flushes the screen in the background from now on
+ *
+ * \param p_ui - game and screen
+ * \param p_flush - flush to send with, NULL to wait for every flush
+ */
+void monty_ui_flush_async( monty_ui *p_ui, monty_flush *p_flush )
+{
+	p_ui->p_flush = p_flush;
+}
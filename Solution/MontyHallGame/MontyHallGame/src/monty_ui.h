@@ -0,0 +1,68 @@
+/**
+ * \file
+ *
+ * \brief Button press to game to display pipeline
+ *
+ * monty_ui_press() is what the main loop does with one button press: update
+ * the game, send the UART lines and redraw the display. The screen is redrawn
+ * into a framebuffer and only what changed goes out to the panel. It has no
+ * board dependencies beyond the ssd1306_* calls, so a recorded session (see
+ * monty_record.h) can be replayed through exactly the same code on the board
+ * and on the host.
+ *
+ * With three doors each button picks its door. With more doors than buttons,
+ * buttons 1 and 3 move a cursor while a door has to be picked and button 2
+ * picks the door under it.
+ *
+ */
+
+#ifndef MONTY_UI_H_INCLUDED
+#define MONTY_UI_H_INCLUDED
+
+#include <stdint.h>
+
+#include "monty_display.h"
+#include "monty_log.h"
+#include "monty_nk.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief longest line on the UART or the display */
+#define MONTY_UI_LINE 120
+
+/** \brief sends a line over the UART */
+typedef void (*monty_ui_print_fn)( void *p_context, const char *p_line );
+
+/** \brief game and screen */
+typedef struct
+{
+	monty_hall_state game;                       /**< Three door game */
+	monty_nk_state nk_game;                      /**< Game with more doors than buttons */
+	uint32_t door_count;
+	uint32_t cursor_door;                        /**< DOOR_NOT_PRESSED in the three door game */
+	door_coordinates doors[MONTY_NK_MAX_DOORS];
+	char rows[MONTY_DISPLAY_PAGES][MONTY_UI_LINE];
+	monty_framebuffer display;                   /**< Screen, flushed at the end of every press */
+	monty_display_sprites sprites;               /**< Doors of the layout and the fixed strings */
+	monty_flush *p_flush;                        /**< Background flush, NULL to wait for each flush */
+	char line[MONTY_UI_LINE];
+	monty_ui_print_fn print;
+	void *p_print_context;
+	monty_log *p_log;                            /**< Finished three door games, NULL for none */
+} monty_ui;
+
+int32_t monty_ui_init( monty_ui *p_ui, uint32_t door_count, uint32_t reveal_count,
+					monty_ui_print_fn print, void *p_print_context, monty_log *p_log );
+void monty_ui_start( monty_ui *p_ui );
+void monty_ui_press( monty_ui *p_ui, uint32_t button );
+void monty_ui_draw( monty_ui *p_ui );
+void monty_ui_flush( monty_ui *p_ui );
+void monty_ui_flush_async( monty_ui *p_ui, monty_flush *p_flush );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTY_UI_H_INCLUDED */
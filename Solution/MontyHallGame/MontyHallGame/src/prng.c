@@ -0,0 +1,87 @@
+/**
+ * \file
+ *
+ * \brief Seedable counter-based random number generator (Philox4x32-10)
+ *
+ */
+
+#include "prng.h"
+
+/** \brief fills the buffer with the next block of the stream */
+static void prng_refill( prng_stream *p_stream )
+{
+	prng_block_at( p_stream, p_stream->block, p_stream->buffer );
+	p_stream->block++;
+	p_stream->index = 0;
+}
+
+/** \brief sets up a stream at position 0
+ *
+ * \param p_stream - stream to initialize
+ * \param seed - key shared by all streams of a run
+ * \param stream_id - selects one of 2^64 independent streams for that seed
+ */
+void prng_init( prng_stream *p_stream, uint64_t seed, uint64_t stream_id )
+{
+	p_stream->key[0] = (uint32_t)seed;
+	p_stream->key[1] = (uint32_t)(seed >> 32);
+	p_stream->stream[0] = (uint32_t)stream_id;
+	p_stream->stream[1] = (uint32_t)(stream_id >> 32);
+	p_stream->block = 0;
+	p_stream->index = PRNG_BLOCK_WORDS;
+}
+
+/** \brief next 32 random bits of the stream */
+uint32_t prng_next_u32( prng_stream *p_stream )
+{
+	if( p_stream->index >= PRNG_BLOCK_WORDS )
+	{
+		prng_refill( p_stream );
+	}
+	return p_stream->buffer[p_stream->index++];
+}
+
+/** \brief next 64 random bits of the stream (two words, low word first) */
+uint64_t prng_next_u64( prng_stream *p_stream )
+{
+	uint64_t low = prng_next_u32( p_stream );
+	return low | ((uint64_t)prng_next_u32( p_stream ) << 32);
+}
+
+/** \brief random value between 0 and range-1
+ *
+ * Multiply-shift mapping of one word (no division, no rejection). The bias is
+ * below range / 2^32, which is negligible for the small ranges used here.
+ */
+uint32_t prng_uniform( prng_stream *p_stream, uint32_t range )
+{
+	return (uint32_t)(((uint64_t)prng_next_u32( p_stream ) * range) >> 32);
+}
+
+/** \brief current position of the stream, in 32 bit words from the start */
+uint64_t prng_tell( const prng_stream *p_stream )
+{
+	return p_stream->block * PRNG_BLOCK_WORDS - (PRNG_BLOCK_WORDS - p_stream->index);
+}
+
+/** \brief moves the stream to an absolute position in O(1)
+ *
+ * \param p_stream - stream
+ * \param position - word position, as returned by prng_tell()
+ */
+void prng_seek( prng_stream *p_stream, uint64_t position )
+{
+	p_stream->block = position / PRNG_BLOCK_WORDS;
+	p_stream->index = PRNG_BLOCK_WORDS;
+	if( position % PRNG_BLOCK_WORDS )
+	{
+		prng_refill( p_stream );
+		p_stream->index = (uint32_t)(position % PRNG_BLOCK_WORDS);
+	}
+}
+
+/** \brief skips words of the stream in O(1) */
+void prng_jump( prng_stream *p_stream, uint64_t words )
+{
+	prng_seek( p_stream, prng_tell( p_stream ) + words );
+}
@@ -0,0 +1,96 @@
+/**
+ * \file
+ *
+ * \brief Seedable counter-based random number generator (Philox4x32-10)
+ *
+ * Philox turns a 128 bit counter and a 64 bit key into 128 random bits
+ * (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC11).
+ * There is no hidden state, so any position of any stream can be produced
+ * directly: jumping ahead is just setting the counter, and independent streams
+ * are obtained by using a different stream id in the upper half of the counter.
+ *
+ * A prng_stream is owned by one user; streams with different ids (or different
+ * block ranges of one stream) can be used from different threads without locking.
+ *
+ */
+
+#ifndef PRNG_H_INCLUDED
+#define PRNG_H_INCLUDED
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief number of 32 bit words produced per counter value */
+#define PRNG_BLOCK_WORDS 4
+
+/** \brief one random stream */
+typedef struct
+{
+	uint32_t key[2];                      /**< Seed */
+	uint32_t stream[2];                   /**< Stream id, upper half of the counter */
+	uint64_t block;                       /**< Next block to generate, lower half of the counter */
+	uint32_t buffer[PRNG_BLOCK_WORDS];    /**< Last generated block */
+	uint32_t index;                       /**< Next unused word in buffer, PRNG_BLOCK_WORDS when empty */
+} prng_stream;
+
+/** \brief one Philox4x32 round */
+static inline void prng_philox_round( uint32_t ctr[4], const uint32_t key[2] )
+{
+	uint64_t product0 = (uint64_t)0xD2511F53u * ctr[0];
+	uint64_t product1 = (uint64_t)0xCD9E8D57u * ctr[2];
+	uint32_t c1 = ctr[1];
+	uint32_t c3 = ctr[3];
+
+	ctr[0] = (uint32_t)(product1 >> 32) ^ c1 ^ key[0];
+	ctr[1] = (uint32_t)product1;
+	ctr[2] = (uint32_t)(product0 >> 32) ^ c3 ^ key[1];
+	ctr[3] = (uint32_t)product0;
+}
+
+/** \brief Philox4x32-10 block function
+ *
+ * \param p_key - 64 bit key
+ * \param p_ctr - 128 bit counter, replaced by the random output
+ */
+static inline void prng_philox4x32_10( const uint32_t p_key[2], uint32_t p_ctr[4] )
+{
+	uint32_t key[2] = { p_key[0], p_key[1] };
+	for( uint32_t round = 0; round < 10; ++round )
+	{
+		prng_philox_round( p_ctr, key );
+		key[0] += 0x9E3779B9u;
+		key[1] += 0xBB67AE85u;
+	}
+}
+
+/** \brief generates block number block_index of a stream without touching its position
+ *
+ * \param p_stream - stream
+ * \param block_index - counter value
+ * \param p_out - PRNG_BLOCK_WORDS random words
+ */
+static inline void prng_block_at( const prng_stream *p_stream, uint64_t block_index, uint32_t p_out[PRNG_BLOCK_WORDS] )
+{
+	p_out[0] = (uint32_t)block_index;
+	p_out[1] = (uint32_t)(block_index >> 32);
+	p_out[2] = p_stream->stream[0];
+	p_out[3] = p_stream->stream[1];
+	prng_philox4x32_10( p_stream->key, p_out );
+}
+
+void prng_init( prng_stream *p_stream, uint64_t seed, uint64_t stream_id );
+uint32_t prng_next_u32( prng_stream *p_stream );
+uint64_t prng_next_u64( prng_stream *p_stream );
+uint32_t prng_uniform( prng_stream *p_stream, uint32_t range );
+uint64_t prng_tell( const prng_stream *p_stream );
+void prng_seek( prng_stream *p_stream, uint64_t position );
+void prng_jump( prng_stream *p_stream, uint64_t words );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PRNG_H_INCLUDED */